@@ -30,6 +30,7 @@
 #include "cave/helper/cavereplay.hpp"
 #include "cave/cavestored.hpp"
 #include "misc/logger.hpp"
+#include "misc/trace.hpp"
 
 /// Add extra ckdelay to cave by checking the existence some animated elements.
 /// BD1 and similar engines had animation bits in cave data, to set which elements to animate (firefly, butterfly, amoeba).
@@ -397,6 +398,7 @@ void CaveRendered::store_rc(int x, int y, GdElementEnum element, CaveObject cons
 /// Must write this in a way so it can be called many times for a single CaveRendered object!
 /// @param data The stored cave to read the map, objects and random values from
 void CaveRendered::create_map(CaveStored const &data, int level) {
+    TraceSpan span("create_map", "cave");
     rendered_on = level;
     if (data.map.empty()) {
         /* if we have no map, fill with predictable random generator. */
@@ -480,6 +482,7 @@ CaveRendered::CaveRendered(CaveStored const &data, int level, int seed)
     amoeba_2_state(GD_AM_SLEEPING),
     magic_wall_state(GD_MW_DORMANT),
     player_state(GD_PL_NOT_YET) {
+    TraceSpan span("CaveRendered", "cave");
     rendered_on = level;
 
     render_seed = seed;
@@ -213,7 +213,7 @@ public:
     GdBool voodoo_touched;
 
     SoundWithPos sound1, sound2, sound3;        ///< sound set for 3 channels after each iteration
-    std::list<ParticleSet> particles;
+    ParticleSystem particles;
     GdColor dirt_particle_color, dirt_2_particle_color, diamond_particle_color,
             stone_particle_color, mega_stone_particle_color,
             explosion_particle_color, magic_wall_particle_color, expanding_wall_particle_color,
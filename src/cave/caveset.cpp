@@ -27,11 +27,13 @@
 
 #include <cstdio>
 #include <fstream>
+#include <memory>
 #include "cave/caveset.hpp"
 #include "misc/logger.hpp"
 #include "misc/autogfreeptr.hpp"
 #include "cave/caverendered.hpp"
 #include "fileops/bdcffsave.hpp"
+#include "misc/parallel.hpp"
 
 /* list of possible extensions which can be opened */
 const char *gd_caveset_extensions[] = {"*.gds", "*.bd", "*.bdr", "*.brc", "*.vsf", "*.mem", NULL};
@@ -66,7 +68,65 @@ PropertyDescription const CaveSet::descriptor[] = {
 };
 
 
-CaveSet::CaveSet() {
+bool LazyCaveSource::cave_has_levels(unsigned i) const {
+    std::auto_ptr<CaveStored> cave(create_cave(i));
+    return cave->has_levels();
+}
+
+
+/* the caves created by the jobs of LazyCaveSource::create_caves(), and the messages logged meanwhile */
+struct CreateCavesJobs {
+    LazyCaveSource const *source;
+    std::vector<unsigned> const *indices;
+    std::vector<CaveStored *> caves;
+    std::vector<Logger::Container> messages;
+    std::vector<std::string> errors;
+};
+
+
+static void create_cave_job(unsigned job, gpointer data) {
+    CreateCavesJobs &jobs = *static_cast<CreateCavesJobs *>(data);
+    /* the messages are logged again by the calling thread */
+    Logger logger(false, true);
+    try {
+        jobs.caves[job] = jobs.source->create_cave(jobs.indices->at(job));
+    } catch (std::exception &e) {
+        jobs.errors[job] = e.what();
+    }
+    jobs.messages[job] = logger.get_messages();
+    logger.clear();
+}
+
+
+std::vector<CaveStored *> LazyCaveSource::create_caves(std::vector<unsigned> const &indices) const {
+    CreateCavesJobs jobs;
+    jobs.source = this;
+    jobs.indices = &indices;
+    jobs.caves.resize(indices.size(), NULL);
+    jobs.messages.resize(indices.size());
+    jobs.errors.resize(indices.size());
+    gd_parallel_for(indices.size(), create_cave_job, &jobs);
+
+    /* log the messages in the order of the caves, as if they were created one by one */
+    std::string error;
+    for (unsigned i = 0; i < indices.size(); ++i) {
+        for (Logger::ConstIterator it = jobs.messages[i].begin(); it != jobs.messages[i].end(); ++it)
+            log(it->sev, it->message);
+        if (error.empty())
+            error = jobs.errors[i];
+    }
+    if (!error.empty()) {
+        for (unsigned i = 0; i < jobs.caves.size(); ++i)
+            delete jobs.caves[i];
+        throw std::runtime_error(error);
+    }
+    return jobs.caves;
+}
+
+
+CaveSet::CaveSet()
+    :   cached_checksum(0),
+        cached_checksum_valid(false) {
     /* some bdcff defaults */
     initial_lives = 3;
     maximum_lives = 9;
@@ -74,18 +134,122 @@ CaveSet::CaveSet() {
 }
 
 
-/* calculates an adler checksum, for which it uses all
-   elements of all cave-rendereds. */
+/// Make the caveset have count caves, which are created by the source when first accessed.
+/// The caveset must be empty when calling this.
+void CaveSet::set_lazy_caves(SmartPtr<LazyCaveSource> const &source, unsigned count) {
+    g_assert(caves.empty());
+    lazy_caves = source;
+    for (unsigned i = 0; i < count; ++i)
+        caves.push_back_adopt(NULL);
+}
+
+
+/// Return the cave with index i. If it is not yet created, the lazy cave source is asked for it.
+CaveStored &CaveSet::cave(unsigned i) const {
+    CaveStored *cave = caves.at(i);
+    if (cave == NULL) {
+        /* the caveset is logically not changed by creating the cave */
+        cave = lazy_caves->create_cave(i);
+        const_cast<AdoptingContainer<CaveStored> &>(caves).replace_adopt(i, cave);
+    }
+    return *cave;
+}
+
+
+/// Create all caves which are not yet created. This is faster than
+/// creating them one by one through cave(), as they are created in parallel.
+void CaveSet::create_all_caves() const {
+    std::vector<unsigned> indices;
+    for (unsigned i = 0; i < caves.size(); ++i)
+        if (caves.at(i) == NULL)
+            indices.push_back(i);
+    if (indices.empty())
+        return;
+
+    std::vector<CaveStored *> created = lazy_caves->create_caves(indices);
+    for (unsigned i = 0; i < indices.size(); ++i)
+        const_cast<AdoptingContainer<CaveStored> &>(caves).replace_adopt(indices[i], created[i]);
+}
+
+
+/* the adler checksum of a rendered cave, started from zero, and the number of cells;
+   from these the checksum of the caveset can be continued with the cave. */
+struct CaveChecksumJobs {
+    CaveSet const *caveset;
+    std::vector<unsigned> a, b, cells;
+};
+
+
+static void cave_checksum_job(unsigned job, gpointer data) {
+    CaveChecksumJobs &jobs = *static_cast<CaveChecksumJobs *>(data);
+    /* the messages of rendering are shown when the cave is played */
+    Logger ignore_messages(true);
+    CaveRendered rendered(jobs.caveset->cave(job), 0, 0);  /* level=1, seed=0 */
+    unsigned a = 0, b = 0;
+    gd_cave_adler_checksum_more(rendered, a, b);
+    jobs.a[job] = a;
+    jobs.b[job] = b;
+    jobs.cells[job] = rendered.w * rendered.h;
+}
+
+
+/// Calculate an adler checksum, for which all elements of all cave-rendereds are used.
+/// It identifies the caveset, for example for the highscore file. It is calculated
+/// only once, unless the caveset is edited.
 unsigned CaveSet::checksum() const {
-    unsigned a = 1, b = 0;
+    /* an edited caveset may change at any time */
+    if (cached_checksum_valid && !edited)
+        return cached_checksum;
+
+    /* render the caves in parallel, then continue the adler sums with each cave.
+     * if a cave of n cells has the sums a_i and b_i counted from zero, then the sums
+     * continued from a and b are a+a_i and b+n*a+b_i, as each cell adds a to b. */
+    create_all_caves();
+    CaveChecksumJobs jobs;
+    jobs.caveset = this;
+    jobs.a.resize(caves.size());
+    jobs.b.resize(caves.size());
+    jobs.cells.resize(caves.size());
+    gd_parallel_for(caves.size(), cave_checksum_job, &jobs);
+    guint64 a = 1, b = 0;
     for (unsigned int i = 0; i < caves.size(); ++i) {
-        CaveRendered rendered(*caves.at(i), 0, 0);  /* level=1, seed=0 */
-        gd_cave_adler_checksum_more(rendered, a, b);
+        b = (b + jobs.cells[i] % 65521 * a + jobs.b[i]) % 65521;
+        a = (a + jobs.a[i]) % 65521;
+    }
+
+    unsigned result = (b << 16) + a;
+    if (!edited) {
+        cached_checksum = result;
+        cached_checksum_valid = true;
     }
-    return (b << 16) + a;
+    return result;
+}
+
+
+/// Set the checksum of the caves, if it is already known. For the caveset cache.
+void CaveSet::set_checksum(unsigned checksum) {
+    cached_checksum = checksum;
+    cached_checksum_valid = true;
 }
 
 
+/// Add work to be done when the caves are first needed, see finish_loading().
+void CaveSet::add_pending_load(SmartPtr<PendingLoad> const &load) {
+    pending_loads.push_back(load);
+}
+
+
+/// Do the work left from loading, in the order it was added. This must be
+/// called before the caves are played or edited, or their highscores are
+/// shown; it creates all caves.
+void CaveSet::finish_loading() {
+    /* taken from the caveset first, so none of them is done twice */
+    std::vector<SmartPtr<PendingLoad> > loads;
+    loads.swap(pending_loads);
+    for (unsigned i = 0; i < loads.size(); ++i)
+        loads[i]->finish(*this);
+}
+
 
 /********************************************************************************
  *
@@ -96,7 +260,7 @@ unsigned CaveSet::checksum() const {
 /* return index of first selectable cave */
 int CaveSet::first_selectable_cave_index() const {
     for (unsigned int i = 0; i < caves.size(); ++i) {
-        if (caves.at(i)->selectable)
+        if (cave(i).selectable)
             return i;
     }
 
@@ -123,20 +287,25 @@ void CaveSet::set_name_from_filename(const char *filename) {
 /// @param filename The name of the file to write to.
 /// @return true, if successful; false, if error.
 void CaveSet::save_to_file(const char *filename) {
+    /* create the bdcff first, so the file is not truncated if creating the caves fails.
+     * then all caves exist, and the lazy cave source (with its copy of the file contents) is not needed anymore. */
+    std::string saved;
+    finish_loading();       /* so the highscores are also saved */
+    save_to_bdcff(*this, saved);
+    lazy_caves.release();
     std::ofstream outfile;
     outfile.open(filename);
     if (!outfile)
         throw std::runtime_error(_("Could not open file for writing."));
-    std::list<std::string> saved;
-    save_to_bdcff(*this, saved);
-    for (std::list<std::string>::const_iterator it = saved.begin(); it != saved.end(); ++it)
-        outfile << *it << std::endl;
+    outfile.write(saved.data(), saved.size());
     outfile.close();
     if (!outfile)
         throw std::runtime_error(_("Error writing to file."));
-    /* remember savename and that now it is not edited */
+    /* remember savename and that now it is not edited. the caves may have been changed
+     * while it was edited, so the checksum is calculated again. */
     this->filename = filename;
     this->edited = false;
+    this->cached_checksum_valid = false;
 }
 
 
@@ -145,7 +314,7 @@ void CaveSet::save_to_file(const char *filename) {
 bool CaveSet::has_replays() const {
     /* for all caves */
     for (unsigned int i = 0; i < caves.size(); ++i) {
-        if (!caves.at(i)->replays.empty())
+        if (!cave(i).replays.empty())
             return true;
     }
 
@@ -159,7 +328,9 @@ bool CaveSet::has_replays() const {
 bool CaveSet::has_levels() const {
     /* for all caves */
     for (unsigned int i = 0; i < caves.size(); ++i) {
-        if (caves.at(i)->has_levels())
+        /* caves not yet created are not created for this */
+        bool levels = caves.at(i) != NULL ? caves.at(i)->has_levels() : lazy_caves->cave_has_levels(i);
+        if (levels)
             return true;
     }
     /* no levels at all */
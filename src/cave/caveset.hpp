@@ -25,11 +25,45 @@
 
 #include "config.h"
 
+#include <vector>
+
 #include "cave/cavetypes.hpp"
 #include "cave/helper/cavehighscore.hpp"
 #include "cave/helper/reflective.hpp"
 #include "cave/helper/adoptingcontainer.hpp"
 #include "cave/cavestored.hpp"
+#include "misc/smartptr.hpp"
+
+/// @ingroup Cave
+/// Creates the caves of a caveset when they are first accessed.
+/// The caves container of a CaveSet may hold NULL placeholders for these;
+/// CaveSet::cave() asks the source to create the cave in their place.
+class LazyCaveSource {
+public:
+    virtual ~LazyCaveSource() {}
+    /// Create the cave with index i. The cave returned must be allocated with new.
+    virtual CaveStored *create_cave(unsigned i) const = 0;
+    /// Tell if the cave with index i has difficulty levels, see CaveStored::has_levels().
+    /// Sources may be able to answer this without creating the cave.
+    virtual bool cave_has_levels(unsigned i) const;
+    /// Create the caves with the given indices, on worker threads.
+    /// The messages logged are passed to the logger of the calling thread, in the order of the caves.
+    std::vector<CaveStored *> create_caves(std::vector<unsigned> const &indices) const;
+};
+
+class CaveSet;
+
+/// @ingroup Cave
+/// Work left from loading a caveset, which needs all of its caves; like saving
+/// the caveset cache, or loading the highscores, as their file name is given by
+/// the checksum of the caves. Creating all caves takes time in proportion to
+/// their number, so this is done only when they are first needed; see CaveSet::finish_loading().
+class PendingLoad {
+public:
+    virtual ~PendingLoad() {}
+    /// Do the work for the caveset, which is already removed from its pending loads.
+    virtual void finish(CaveSet &caveset) = 0;
+};
 
 /// @ingroup Cave
 class CaveSet : public Reflective {
@@ -63,8 +97,18 @@ public:
     GdInt last_selected_cave;       ///< If running a game, the index of the selected gave is stored here
     GdInt last_selected_level;      ///< If running a game, the level of the selected gave is stored here
 
+    /// The caves. Some may be NULL placeholders, if lazy caves were added;
+    /// so use cave() to access them.
     AdoptingContainer<CaveStored> caves;
-
+    /// The source of the lazily created caves, if any.
+    SmartPtr<LazyCaveSource> lazy_caves;
+    /// The checksum of the caves, if already calculated; see checksum().
+    mutable unsigned cached_checksum;
+    mutable bool cached_checksum_valid;
+    /// The work left from loading, see finish_loading().
+    std::vector<SmartPtr<PendingLoad> > pending_loads;
+
+    void set_lazy_caves(SmartPtr<LazyCaveSource> const &source, unsigned count);
     void save_to_file(const char *filename);
     void set_name_from_filename(const char *filename);
 
@@ -73,12 +117,18 @@ public:
         return !caves.empty();
     }
     bool has_levels() const;
-    CaveStored &cave(unsigned i) const {
-        return *(caves.at(i));
-    }
+    CaveStored &cave(unsigned i) const;
+    void create_all_caves() const;
     int cave_index(CaveStored const *cave) const;
     int first_selectable_cave_index() const;
     unsigned checksum() const;
+    void set_checksum(unsigned checksum);
+    void add_pending_load(SmartPtr<PendingLoad> const &load);
+    void finish_loading();
+    /// True, if there is no work left from loading, see finish_loading().
+    bool is_loading_finished() const {
+        return pending_loads.empty();
+    }
 
 // for reflective
 public:
@@ -31,6 +31,7 @@
 #include "cave/caveset.hpp"
 #include "sound/sound.hpp"
 #include "misc/util.hpp"
+#include "misc/frametimes.hpp"
 #include "input/gameinputhandler.hpp"
 #include "settings.hpp"
 
@@ -88,6 +89,8 @@ GameControl::~GameControl() {
 /// Create a full game from the caveset.
 /// @returns A newly allocated GameControl. Free with delete.
 GameControl *GameControl::new_normal(CaveSet *caveset, std::string player_name, int cave, int level) {
+    /* the game adds highscores and statistics, so they must be loaded */
+    caveset->finish_loading();
     GameControl *g = new GameControl;
 
     g->type = TYPE_NORMAL;
@@ -448,7 +451,10 @@ GameControl::State GameControl::iterate_cave(GameInputHandler *inputhandler) {
             replay_record->store_movement(player_move, fire, suicide);
 
         /* cave iterate gives us a new player move, which might have diagonal movements removed */
-        played_cave->iterate(player_move, fire, suicide);
+        {
+            FrameTimeMeasure measure(FrameTimes::Iterate);
+            played_cave->iterate(player_move, fire, suicide);
+        }
         if (played_cave->score)
             increment_score(played_cave->score);
         return_state = STATE_NOTHING;
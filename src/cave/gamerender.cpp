@@ -33,6 +33,8 @@
 #include "cave/caverendered.hpp"
 #include "cave/caveset.hpp"
 #include "misc/util.hpp"
+#include "misc/frametimes.hpp"
+#include "misc/trace.hpp"
 #include "input/gameinputhandler.hpp"
 #include "gfx/pixbuf.hpp"
 #include "gfx/screen.hpp"
@@ -63,7 +65,7 @@ GameRenderer::GameRenderer(Screen &screen, CellRenderer &cells, FontManager &fon
         game(game),
         play_area_w(0), play_area_h(0),
         statusbar_height(0), statusbar_y1(0), statusbar_y2(0), statusbar_mid(0),
-        out_of_window(false), show_replay_sign(true),
+        out_of_window(false), show_replay_sign(true), show_frame_times(false),
         scroll_x(0), scroll_y(0),
         scroll_desired_x(0), scroll_desired_y(0),
         millisecs_game(0),
@@ -343,31 +345,47 @@ void GameRenderer::drawcave() const {
     if (gd_particle_effects) {
         int xs = xplus - scroll_x - game.played_cave->x1 * cell_size;
         int ys = yplus + statusbar_height - scroll_y_aligned - game.played_cave->y1 * cell_size;
-        std::list<ParticleSet>::const_iterator it;
-        for (it = game.played_cave->particles.begin(); it != game.played_cave->particles.end(); ++it)
-            screen.draw_particle_set(xs, ys, *it);
+        particle_governor.start();
+        screen.draw_particles(xs, ys, game.played_cave->particles);
+        particle_governor.stop();
     }
 
-    /* if using particle effects, the whole cave needs to be redrawn later. */
-    if (gd_particle_effects) {
+    /* if using particle effects or showing the frame times, the whole cave needs to be redrawn later. */
+    if (gd_particle_effects || show_frame_times) {
         /* remember to redraw the whole cave */
         for (int y = game.played_cave->y1; y <= game.played_cave->y2; y++)
             for (int x = game.played_cave->x1; x <= game.played_cave->x2; x++)
                 game.gfx_buffer(x, y) |= GD_REDRAW;
     }
 
-    /* writing the scrolling parameters to the screen */
-    /*
-    std::string s = SPrintf("ms=%2d fps=%2d sm=%4.2f sx=%4.2f sy=%4.2f") % scroll_ms % (1000/scroll_ms) % scroll_speed_normal % scroll_speed_x % scroll_speed_y;
-    font_manager.blittext_n(1, screen.get_height()-font_manager.get_line_height()+1, GD_GDASH_BLACK, s.c_str());
-    font_manager.blittext_n(0, screen.get_height()-font_manager.get_line_height(), GD_GDASH_WHITE, s.c_str());
-    */
+    if (show_frame_times)
+        drawframetimes();
 
     /* restore clipping to whole screen */
     screen.remove_clip_rect();
 }
 
 
+/* draw the percentiles of the frame times over the bottom of the cave. */
+void GameRenderer::drawframetimes() const {
+    /* about the last five seconds */
+    FrameTimes::Statistics stats[FrameTimes::NumSections];
+    gd_frame_times.get_statistics(250, stats);
+
+    int line_height = font_manager.get_line_height();
+    int y = screen.get_height() - (FrameTimes::NumSections + 2) * line_height;
+    font_manager.blittext_n(0, y, GD_GDASH_YELLOW, "ms         p50  p95  p99   max");
+    for (unsigned s = 0; s < FrameTimes::NumSections; ++s) {
+        y += line_height;
+        std::string line = SPrintf("%-9s %4.1f %4.1f %4.1f %5.1f") % FrameTimes::section_names[s] % stats[s].p50 % stats[s].p95 % stats[s].p99 % stats[s].max;
+        font_manager.blittext_n(0, y, GD_GDASH_WHITE, line.c_str());
+    }
+    y += line_height;
+    std::string line = SPrintf("particles %3d%%") % int(particle_governor.get_factor() * 100 + 0.5);
+    font_manager.blittext_n(0, y, GD_GDASH_WHITE, line.c_str());
+}
+
+
 void GameRenderer::set_random_colors() {
     if (game.played_cave.get() == NULL)
         return;
@@ -711,6 +729,7 @@ void GameRenderer::drawstory() const {
 
 
 void GameRenderer::draw(bool full) const {
+    TraceSpan span("draw", "render");
     // if cave exists and colors are selected, it means that the cave was drawn
     if (!game.gfx_buffer.empty()) {
         // if everything must be redrawn, clear the screen and remember that
@@ -721,9 +740,13 @@ void GameRenderer::draw(bool full) const {
                 for (int x = game.played_cave->x1; x <= game.played_cave->x2; x++)
                     game.gfx_buffer(x, y) |= GD_REDRAW;
         }
-        if (full || must_draw_cave)
+        if (full || must_draw_cave) {
+            FrameTimeMeasure measure(FrameTimes::DrawCave);
             drawcave();
+            particle_governor.frame_finished(game.played_cave->particles.num_sets() > 0);
+        }
         if (full || must_draw_status) {
+            FrameTimeMeasure measure(FrameTimes::DrawStatus);
             drawstatus();
         }
 
@@ -753,12 +776,6 @@ void GameRenderer::screen_initialized() {
     story.linesavailable = screen.get_height() / font_manager.get_line_height() - 6;
 }
 
-/** For removing old particles (a predicate) */
-static bool old_particle(ParticleSet const &ps) {
-    return ps.life < 0;
-}
-
-
 GameRenderer::State GameRenderer::main_int(int millisecs_elapsed, bool paused, GameInputHandler *inputhandler) {
     GameControl::State state = GameControl::STATE_NOTHING;
 
@@ -776,7 +793,10 @@ GameRenderer::State GameRenderer::main_int(int millisecs_elapsed, bool paused, G
         millisecs_game -= 40;
 
         /* tell the interrupt "40 ms has passed" - the cave will move. */
-        state = game.main_int(inputhandler, !paused && !out_of_window);
+        {
+            FrameTimeMeasure measure(FrameTimes::GameMainInt);
+            state = game.main_int(inputhandler, !paused && !out_of_window);
+        }
         animcycle = (animcycle + 1) % 8;
         must_draw_cave = true;
         must_draw_status = true;
@@ -785,6 +805,9 @@ GameRenderer::State GameRenderer::main_int(int millisecs_elapsed, bool paused, G
         switch (state) {
             case GameControl::STATE_CAVE_LOADED:
                 set_colors_from_cave();
+                /* scale the cells while the cave is uncovered */
+                if (gd_prescale_cells)
+                    cells.prescale_cells();
                 scroll_to_origin();
                 break;
 
@@ -829,17 +852,21 @@ GameRenderer::State GameRenderer::main_int(int millisecs_elapsed, bool paused, G
         /* the scrolling routine invalidates the game gfx cells if needed. */
         out_of_window = scroll(millisecs_elapsed, game.played_cave->player_state == GD_PL_NOT_YET);
 
-        /* move the particles */
-        std::list<ParticleSet>::iterator it;
-        for (it = game.played_cave->particles.begin(); it != game.played_cave->particles.end(); ++it) {
-            if (it->is_new)
-                it->normalize(cells.get_cell_size());
-            it->move(millisecs_elapsed);
+        /* move the particles, and scale the number of new ones to the time available */
+        {
+            FrameTimeMeasure measure(FrameTimes::Particles);
+            particle_governor.start();
+            game.played_cave->particles.normalize(cells.get_cell_size());
+            game.played_cave->particles.move(millisecs_elapsed);
+            game.played_cave->particles.set_count_factor(particle_governor.get_factor());
+            particle_governor.stop();
         }
-        game.played_cave->particles.remove_if(old_particle);
 
         /* always render the cave to the gfx buffer; however it may do nothing if animcycle was not changed. */
-        game.played_cave->draw_indexes(game.gfx_buffer, game.covered, game.bonus_life_flash > 0, animcycle, gd_no_invisible_outbox);
+        {
+            FrameTimeMeasure measure(FrameTimes::DrawIndexes);
+            game.played_cave->draw_indexes(game.gfx_buffer, game.covered, game.bonus_life_flash > 0, animcycle, gd_no_invisible_outbox);
+        }
 
         /* draw the cave. */
         must_draw_cave = true;
@@ -33,6 +33,7 @@
 #include "cave/colors.hpp"
 #include "cave/cavetypes.hpp"
 #include "gfx/pixmapstorage.hpp"
+#include "cave/particle.hpp"
 
 class Screen;
 class CellRenderer;
@@ -91,6 +92,7 @@ class GameRenderer : public PixmapStorage {
     bool out_of_window;
 
     bool show_replay_sign;
+    bool show_frame_times;
 
     double scroll_x, scroll_y;
     double scroll_speed_x, scroll_speed_y;
@@ -104,6 +106,9 @@ class GameRenderer : public PixmapStorage {
 
     mutable bool must_draw_cave, must_clear_screen, must_draw_status, must_draw_story;
 
+    /// Measures drawing time, and scales the particle counts.
+    mutable ParticleGovernor particle_governor;
+
     // the last set status bar in the game
     bool status_bar_fast, status_bar_alternate, status_bar_paused;
 
@@ -126,6 +131,7 @@ class GameRenderer : public PixmapStorage {
     void drawstatus_uncover() const;
     void drawstatus_game() const;
     void drawstatus() const;
+    void drawframetimes() const;
 
     void set_colors_from_cave();
     void select_status_bar_colors();
@@ -177,8 +183,22 @@ public:
      */
     void draw(bool full) const;
 
+    /**
+     * Show or hide the frame times overlay, which shows percentiles of the time
+     * spent in the parts of the game loop. */
+    void toggle_frame_times() {
+        show_frame_times = !show_frame_times;
+    }
+
     /** Implement PixbufStorage. */
     void release_pixmaps();
+
+    /**
+     * The factor, with which particle counts are multiplied currently,
+     * to keep the frame time within the budget. For diagnostics. */
+    double get_particle_factor() const {
+        return particle_governor.get_factor();
+    }
 };
 
 
@@ -36,6 +36,8 @@
  * and adopts the pointers given to them to store.
  * Some functions can be inherited from the base class,
  * some need to be redefined to delete the pointers as needed.
+ * NULL pointers can also be stored as placeholders; those are
+ * copied as NULL.
  */
 template <class T>
 class AdoptingContainer: private std::vector<T *> {
@@ -70,6 +72,14 @@ public:
         this->push_back(x);
     }
 
+    /// Store object given in place of the nth one, which is deleted; adopt it.
+    /// @param n The index of the element to replace.
+    /// @param x The pointer to the object to store.
+    void replace_adopt(unsigned n, T *x) {
+        delete _my_base::at(n);
+        _my_base::at(n) = x;
+    }
+
     typedef typename _my_base::const_iterator const_iterator;
     using _my_base::begin;
     using _my_base::end;
@@ -110,7 +120,7 @@ AdoptingContainer<T>& AdoptingContainer<T>::operator=(const AdoptingContainer<T>
         delete(*this)[i];
     this->resize(rhs.size());
     for (unsigned i = 0; i < size(); ++i)
-        (*this)[i] = rhs[i]->clone();
+        (*this)[i] = rhs[i] != NULL ? rhs[i]->clone() : NULL;
     return *this;
 }
 
@@ -25,8 +25,8 @@
 
 #include <glib.h>
 #include <vector>
-#include <sstream>
-#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
 #include <cstring>
 
 #include "cave/helper/cavereplay.hpp"
@@ -51,7 +51,10 @@ PropertyDescription const CaveReplay::descriptor[] = {
 };
 
 CaveReplay::CaveReplay() :
+    num_movements(0),
+    last_run_pos(0),
     current_playing_pos(0),
+    current_run_played(0),
     level(1),
     seed(0),
     score(0),
@@ -63,10 +66,60 @@ CaveReplay::CaveReplay() :
 }
 
 
+/* append a movement to the replay, repeated count times. */
+/* continues the last run, if it is the same movement. */
+void CaveReplay::add_movements(movement data, unsigned count) {
+    while (count > 0) {
+        if (!movements.empty() && (movements[last_run_pos] & ~REPLAY_RUN_MASK) == data) {
+            /* the same as the last run: make it longer, as far as it goes */
+            if (!(movements[last_run_pos] & REPLAY_RUN_MASK)) {
+                movements[last_run_pos] |= REPLAY_RUN_MASK;
+                movements.push_back(1);
+            }
+            unsigned add = std::min(count, 255u - movements[last_run_pos + 1]);
+            movements[last_run_pos + 1] += add;
+            num_movements += add;
+            count -= add;
+            if (count == 0)
+                break;
+        }
+        /* start a new run */
+        last_run_pos = movements.size();
+        movements.push_back(data);
+        num_movements++;
+        count--;
+    }
+}
+
 /* store movement in a replay */
 void CaveReplay::store_movement(GdDirectionEnum player_move, bool player_fire, bool suicide) {
     g_assert(player_move == (player_move & REPLAY_MOVE_MASK));
-    movements.push_back((player_move) | (player_fire ? REPLAY_FIRE_MASK : 0) | (suicide ? REPLAY_SUICIDE_MASK : 0));
+    add_movements((player_move) | (player_fire ? REPLAY_FIRE_MASK : 0) | (suicide ? REPLAY_SUICIDE_MASK : 0), 1);
+}
+
+/* set the movements from the bytes returned by get_raw_movements(), and rewind the replay. */
+/* throws an exception, if the bytes are not valid run-length encoded movements. */
+void CaveReplay::set_raw_movements(unsigned char const *data, size_t count) {
+    unsigned num = 0, last = 0;
+    for (size_t pos = 0; pos < count; ) {
+        if (data[pos] & ~(REPLAY_MOVE_MASK | REPLAY_FIRE_MASK | REPLAY_SUICIDE_MASK | REPLAY_RUN_MASK)
+                || (data[pos] & REPLAY_MOVE_MASK) >= MV_MAX)
+            throw std::runtime_error("invalid replay movement");
+        last = pos;
+        if (data[pos] & REPLAY_RUN_MASK) {
+            if (pos + 1 >= count || data[pos + 1] < 2)
+                throw std::runtime_error("invalid replay movement");
+            num += data[pos + 1];
+            pos += 2;
+        } else {
+            num++;
+            pos++;
+        }
+    }
+    movements.assign(data, data + count);
+    num_movements = num;
+    last_run_pos = last;
+    rewind();
 }
 
 /* get next available movement from a replay; store variables to player_move, player_fire, suicide */
@@ -76,7 +129,14 @@ bool CaveReplay::get_next_movement(GdDirectionEnum &player_move, bool &player_fi
     if (current_playing_pos >= movements.size())
         return false;
 
-    movement data = movements[current_playing_pos++];
+    movement data = movements[current_playing_pos];
+    /* step to the next run, if this one is finished */
+    unsigned run_length = (data & REPLAY_RUN_MASK) ? movements[current_playing_pos + 1] : 1;
+    current_run_played++;
+    if (current_run_played == run_length) {
+        current_playing_pos += (data & REPLAY_RUN_MASK) ? 2 : 1;
+        current_run_played = 0;
+    }
 
     suicide = (data & REPLAY_SUICIDE_MASK) != 0;
     player_fire = (data & REPLAY_FIRE_MASK) != 0;
@@ -87,6 +147,7 @@ bool CaveReplay::get_next_movement(GdDirectionEnum &player_move, bool &player_fi
 
 void CaveReplay::rewind() {
     current_playing_pos = 0;
+    current_run_played = 0;
 }
 
 
@@ -104,15 +165,16 @@ void CaveReplay::rewind() {
 #define REPLAY_BDCFF_FIRE "F"
 #define REPLAY_BDCFF_SUICIDE "k"
 
-bool CaveReplay::load_one_from_bdcff(const std::string &str) {
+bool CaveReplay::load_one_from_bdcff(char const *str, size_t length) {
     GdDirectionEnum dir;
     bool up, down, left, right;
     bool fire, suicide;
     int num = -1;
-    unsigned int count, i;
+    unsigned int count;
+    size_t i;
 
     fire = suicide = up = down = left = right = false;
-    for (i = 0; i < str.length(); i++)
+    for (i = 0; i < length; i++)
         switch (str[i]) {
             case 'U':
                 fire = true;
@@ -157,8 +219,12 @@ bool CaveReplay::load_one_from_bdcff(const std::string &str) {
 
             default:
                 if (g_ascii_isdigit(str[i])) {
-                    if (num == -1)
-                        sscanf(str.c_str() + i, "%d", &num);
+                    /* the first number is the count */
+                    if (num == -1) {
+                        num = 0;
+                        for (size_t j = i; j < length && g_ascii_isdigit(str[j]) && num <= (G_MAXINT - 9) / 10; j++)
+                            num = num * 10 + (str[j] - '0');
+                    }
                 }
                 break;
         }
@@ -166,18 +232,25 @@ bool CaveReplay::load_one_from_bdcff(const std::string &str) {
     count = 1;
     if (num != -1)
         count = num;
-    for (i = 0; i < count; i++)
-        store_movement(dir, fire, suicide);
+    add_movements(dir | (fire ? REPLAY_FIRE_MASK : 0) | (suicide ? REPLAY_SUICIDE_MASK : 0), count);
 
     return true;
 }
 
 bool CaveReplay::load_from_bdcff(std::string const &str) {
-    std::istringstream is(str);
-    std::string one;
+    /* split to words at the whitespace */
+    char const *s = str.c_str(), *end = s + str.length();
     bool result = true;
-    while (is >> one)
-        result = result && load_one_from_bdcff(one);
+    while (s != end) {
+        if (g_ascii_isspace(*s)) {
+            ++s;
+            continue;
+        }
+        char const *word = s;
+        while (s != end && !g_ascii_isspace(*s))
+            ++s;
+        result = result && load_one_from_bdcff(word, s - word);
+    }
 
     return result;
 }
@@ -228,29 +301,31 @@ const char *CaveReplay::direction_fire_to_bdcff(GdDirectionEnum dir, bool fire)
 std::string CaveReplay::movements_to_bdcff() const {
     std::string str;
 
-    for (unsigned pos = 0; pos < movements.size(); pos++) {
-        int num = 1;
-        movement data;
+    for (unsigned pos = 0; pos < movements.size(); ) {
+        movement data = movements[pos] & ~REPLAY_RUN_MASK;
+        unsigned num = 0;
+
+        /* count the number of iterations of the same movement - which may be stored in more runs. */
+        while (pos < movements.size() && (movements[pos] & ~REPLAY_RUN_MASK) == data) {
+            if (movements[pos] & REPLAY_RUN_MASK) {
+                num += movements[pos + 1];
+                pos += 2;
+            } else {
+                num++;
+                pos++;
+            }
+        }
 
         /* if this is not the first movement, append a space. */
         if (!str.empty())
             str += ' ';
-
-        /* if same byte appears, count number of occurrences - something like an rle compression. */
-        /* be sure not to cross the array boundaries */
-        while (pos < movements.size() - 1 && movements[pos] == movements[pos + 1]) {
-            pos++;
-            num++;
-        }
-        data = movements[pos];
         if (data & REPLAY_SUICIDE_MASK)
             str += REPLAY_BDCFF_SUICIDE;
         str += direction_fire_to_bdcff(GdDirectionEnum(data & REPLAY_MOVE_MASK), (data & REPLAY_FIRE_MASK) != 0);
         if (num != 1) {
-            std::ostringstream s;
-
-            s << num;
-            str += s.str();
+            char text[16];
+            g_snprintf(text, sizeof(text), "%u", num);
+            str += text;
         }
     }
 
@@ -33,15 +33,23 @@ class CaveReplay : public Reflective {
 private:
     static const char *direction_to_bdcff(GdDirectionEnum mov);
     static const char *direction_fire_to_bdcff(GdDirectionEnum dir, bool fire);
-    bool load_one_from_bdcff(const std::string &str);
+    bool load_one_from_bdcff(char const *str, size_t length);
     typedef unsigned char movement;
+    /// The movements, run-length encoded. Every run starts with the movement byte.
+    /// If REPLAY_RUN_MASK is set in it, the next byte is the number of iterations (2-255)
+    /// the movement is repeated for; otherwise it is stored for one iteration.
     std::vector<movement> movements;
-    unsigned int current_playing_pos;
+    unsigned int num_movements;         ///< number of iterations stored
+    unsigned int last_run_pos;          ///< position of the last run in movements, to be continued
+    unsigned int current_playing_pos;   ///< position of the run being played
+    unsigned int current_run_played;    ///< number of iterations already played from that run
     enum {
         REPLAY_MOVE_MASK = 0x0f,
         REPLAY_FIRE_MASK = 0x10,
         REPLAY_SUICIDE_MASK = 0x20,
+        REPLAY_RUN_MASK = 0x40,
     };
+    void add_movements(movement data, unsigned count);
 
 public:
     /* reflective */
@@ -59,8 +67,13 @@ public:
     bool get_next_movement(GdDirectionEnum &player_move, bool &player_fire, bool &suicide);
     void rewind();
     unsigned int length() {
-        return movements.size();
+        return num_movements;
     }
+    /// The movements as stored in memory, run-length encoded. For the caveset cache.
+    std::vector<unsigned char> const &get_raw_movements() const {
+        return movements;
+    }
+    void set_raw_movements(unsigned char const *data, size_t count);
 
     GdInt level;            ///< replay for level n
     GdInt seed;                ///< seed the cave is to be rendered with
@@ -33,11 +33,13 @@
 #include "misc/printf.hpp"
 
 std::string CaveRaster::get_bdcff() const {
+    /* imported caves may have zero distances; those are drawn with a distance of 1 */
+    Coordinate d(dist.x != 0 ? int(dist.x) : 1, dist.y != 0 ? int(dist.y) : 1);
     Coordinate number;
-    number.x = ((p2.x - p1.x) / dist.x + 1);
-    number.y = ((p2.y - p1.y) / dist.y + 1);
+    number.x = ((p2.x - p1.x) / d.x + 1);
+    number.y = ((p2.y - p1.y) / d.y + 1);
 
-    return BdcffFormat("Raster") << p1 << number << dist << element;
+    return BdcffFormat("Raster") << p1 << number << d << element;
 }
 
 CaveRaster *CaveRaster::clone_from_bdcff(const std::string &name, std::istream &is) const {
@@ -22,50 +22,207 @@
  */
 
 #include <glib.h>
+#include <algorithm>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 #include "cave/particle.hpp"
 
-ParticleSet::ParticleSet(int count, float size, float opacity, float p0x, float p0y, float dp0x, float dp0y, float v0x, float v0y, float dvx, float dvy, const GdColor &color)
-    : color(color)
-    , life(1000)
-    , is_new(true)
-    , size(size)
-    , opacity(opacity)
-    , particles(count) {
-    for (size_t i = 0; i < particles.size(); ++i) {
-        Particle &p = particles[i];
-        p.px = p0x + g_random_double_range(-dp0x, dp0x);
-        p.py = p0y + g_random_double_range(-dp0y, dp0y);
-        p.vx = v0x + g_random_double_range(-dvx, dvx);
-        p.vy = v0y + g_random_double_range(-dvy, dvy);
+ParticleSystem::ParticleSystem()
+    : next_particle(0)
+    , first_set_info(0)
+    , num_set_infos(0)
+    , random_state(g_random_int() | 1)
+    , count_factor(1.0) {
+    /* the arrays are only allocated when the first particle set is added,
+     * as many caves are rendered without ever showing particles */
+}
+
+
+/* xorshift32. the particles only need something that looks random. */
+float ParticleSystem::random_range(float min, float max) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return min + (max - min) * ((random_state >> 8) * (1.0f / 16777216.0f));
+}
+
+
+/* Find room for count particles in the ring buffer; returns
+ * max_particles, if there is no room without removing older sets. */
+unsigned ParticleSystem::place_for(unsigned count) const {
+    if (num_set_infos == 0)
+        return 0;
+    unsigned head = set_info(0).first, tail = next_particle;
+    if (tail > head) {
+        /* used area is head..tail-1; free space at the end and at the beginning */
+        if (max_particles - tail >= count)
+            return tail;
+        if (head >= count)
+            return 0;
+    } else {
+        /* wrapped around; free space is tail..head-1. if head == tail, the buffer is full. */
+        if (head - tail >= count)
+            return tail;
+    }
+    return max_particles;
+}
+
+
+void ParticleSystem::remove_oldest_set() {
+    g_assert(num_set_infos > 0);
+    first_set_info = (first_set_info + 1) % max_sets;
+    num_set_infos--;
+    if (num_set_infos == 0)
+        next_particle = 0;
+}
+
+
+void ParticleSystem::add(int count, float size, float opacity, float p0x, float p0y, float dp0x, float dp0y, float v0x, float v0y, float dvx, float dvy, const GdColor &color) {
+    if (count <= 0)
+        return;
+    count = std::max(1, int(count * count_factor + 0.5));
+    if (count > max_particles)
+        count = max_particles;
+    if (px.empty()) {
+        px.resize(max_particles);
+        py.resize(max_particles);
+        vx.resize(max_particles);
+        vy.resize(max_particles);
+        set_infos.resize(max_sets);
+    }
+
+    /* make room, removing the oldest sets if needed */
+    if (num_set_infos == max_sets)
+        remove_oldest_set();
+    unsigned first;
+    while ((first = place_for(count)) == max_particles)
+        remove_oldest_set();
+
+    SetInfo &si = set_infos[(first_set_info + num_set_infos) % max_sets];
+    num_set_infos++;
+    si.color = color;
+    si.life = 1000;
+    si.is_new = true;
+    si.size = size;
+    si.opacity = opacity;
+    si.first = first;
+    si.count = count;
+    next_particle = first + count;
+
+    for (unsigned i = first; i < first + count; ++i) {
+        px[i] = p0x + random_range(-dp0x, dp0x);
+        py[i] = p0y + random_range(-dp0y, dp0y);
+        vx[i] = v0x + random_range(-dvx, dvx);
+        vy[i] = v0y + random_range(-dvy, dvy);
     }
 }
 
 
-void ParticleSet::move(int dt_ms) {
+/* p[i] += v[i] * dt, four at a time where possible. */
+static void move_coordinates(float *p, float const *v, unsigned count, float dt) {
+    unsigned i = 0;
+#ifdef __SSE__
+    __m128 dt4 = _mm_set1_ps(dt);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(p + i, _mm_add_ps(_mm_loadu_ps(p + i), _mm_mul_ps(_mm_loadu_ps(v + i), dt4)));
+#endif
+    for (; i < count; ++i)
+        p[i] += v[i] * dt;
+}
+
+
+void ParticleSystem::move(int dt_ms) {
     float dt = dt_ms / 1000.0;
 
-    for (size_t i = 0; i < particles.size(); ++i) {
-        Particle &p = particles[i];
-        p.px += p.vx * dt;
-        p.py += p.vy * dt;
+    for (unsigned n = 0; n < num_set_infos; ++n) {
+        SetInfo &si = set_info(n);
+        move_coordinates(&px[si.first], &vx[si.first], si.count, dt);
+        move_coordinates(&py[si.first], &vy[si.first], si.count, dt);
+        si.life -= dt_ms;
     }
 
-    life -= dt_ms;
+    /* the oldest ones expire first */
+    while (num_set_infos > 0 && set_info(0).life < 0)
+        remove_oldest_set();
 }
 
 
-void ParticleSet::normalize(double factor) {
-    if (!is_new)
-        return;
-    is_new = false;
-
-    size *= factor;
-    for (size_t i = 0; i < particles.size(); ++i) {
-        Particle &p = particles[i];
-        p.px *= factor;
-        p.py *= factor;
-        p.vx *= factor;
-        p.vy *= factor;
+void ParticleSystem::normalize(double factor) {
+    for (unsigned n = 0; n < num_set_infos; ++n) {
+        SetInfo &si = set_info(n);
+        if (!si.is_new)
+            continue;
+        si.is_new = false;
+
+        si.size *= factor;
+        for (unsigned i = si.first; i < si.first + si.count; ++i) {
+            px[i] *= factor;
+            py[i] *= factor;
+            vx[i] *= factor;
+            vy[i] *= factor;
+        }
     }
 }
+
+
+void ParticleSystem::clear() {
+    first_set_info = 0;
+    num_set_infos = 0;
+    next_particle = 0;
+}
+
+
+ParticleSet ParticleSystem::get_set(unsigned n) const {
+    SetInfo const &si = set_info(n);
+    ParticleSet ps;
+    ps.color = si.color;
+    ps.life = si.life;
+    ps.size = si.size;
+    ps.opacity = si.opacity;
+    ps.count = si.count;
+    ps.px = &px[si.first];
+    ps.py = &py[si.first];
+    return ps;
+}
+
+
+const double ParticleGovernor::min_factor = 0.05;
+
+
+ParticleGovernor::ParticleGovernor(double budget_ms)
+    : timer(g_timer_new())
+    , budget_ms(budget_ms)
+    , frame_ms(0)
+    , average_ms(0)
+    , factor(1.0) {
+}
+
+
+ParticleGovernor::~ParticleGovernor() {
+    g_timer_destroy(timer);
+}
+
+
+void ParticleGovernor::start() {
+    g_timer_start(timer);
+}
+
+
+void ParticleGovernor::stop() {
+    frame_ms += g_timer_elapsed(timer, NULL) * 1000.0;
+}
+
+
+void ParticleGovernor::frame_finished(bool had_particles) {
+    /* a moving average, so a single slow frame does not change much */
+    average_ms = average_ms * 0.9 + frame_ms * 0.1;
+    frame_ms = 0;
+
+    if (average_ms > budget_ms) {
+        if (had_particles)
+            factor = std::max(min_factor, factor * 0.95);
+    } else if (average_ms < budget_ms * 0.75)
+        factor = std::min(1.0, factor * 1.02);
+}
@@ -26,63 +26,147 @@
 
 #include "config.h"
 
+#include <glib.h>
 #include <vector>
 #include "cave/colors.hpp"
 
+/// A set of particles created together, as seen by the drawing routines.
+/// The coordinates are stored in the arrays of the ParticleSystem, so this
+/// is only a view, valid until the particle system is changed.
 class ParticleSet {
 public:
-    /// One single particle.
-    struct Particle {
-        float px, py;         ///< Coordinate
-        float vx, vy;         ///< Speed
-    };
+    GdColor color;
+    int life;           ///< lifetime. starts from 1000, goes to 0.
+    float size;         ///< Size of the particles.
+    float opacity;      ///< Opacity between 0 and 1. Values close to 1 not recommended.
+    unsigned count;     ///< Number of particles
+    float const *px;    ///< x coordinates of the particles
+    float const *py;    ///< y coordinates of the particles
+};
+
+
+/// @brief Stores the particles of the explosions and other effects of a cave.
+///
+/// The particles are stored in fixed size arrays, one for each coordinate
+/// and speed component, which are allocated when the first set is added;
+/// after that, adding, moving and removing particles does not allocate
+/// memory. As every set starts with the same lifetime, and they get older
+/// at the same rate, they expire in the order of creation; so the sets and
+/// the particles are stored in ring buffers. If there is no more room,
+/// the oldest sets are removed.
+class ParticleSystem {
+public:
+    ParticleSystem();
 
-    /// This constructor creates a particle set, for the given cave coordinates.
+    /// This creates a particle set, for the given cave coordinates.
     /// 0,0 is the top left corner of the cave; 1,1 is the bottom right corner of
     /// the top left cave cell. (So the max coordinates are the width and height
     /// of the cave.)
-    /// @param cave_x Particle set starting x coordinate in cave coordinates.
-    /// @param cave_y Particle set starting y coordinate in cave coordinates.
-    /// @param dx Half the width of the region, in which originally particles are randomly generated.
-    /// @param dy Half the height of the region, in which originally particles are randomly generated.
-    /// @param vx Maximum original speed.
-    /// @param vy Maximum original speed.
-    ParticleSet(int count, float size, float opacity, float p0x, float p0y, float dp0x, float dp0y, float v0x, float v0y, float dvx, float dvy, const GdColor &color);
-    /// Move the particles.
+    /// @param p0x Particle set starting x coordinate in cave coordinates.
+    /// @param p0y Particle set starting y coordinate in cave coordinates.
+    /// @param dp0x Half the width of the region, in which originally particles are randomly generated.
+    /// @param dp0y Half the height of the region, in which originally particles are randomly generated.
+    /// @param v0x Original speed.
+    /// @param v0y Original speed.
+    /// @param dvx Maximum random difference of the original speed.
+    /// @param dvy Maximum random difference of the original speed.
+    void add(int count, float size, float opacity, float p0x, float p0y, float dp0x, float dp0y, float v0x, float v0y, float dvx, float dvy, const GdColor &color);
+    /// Move the particles, and remove the sets which are too old.
     /// @param dt_ms Time elapsed.
     void move(int dt_ms);
-    /// Scale coordinates to screen cordinates, if is_new is true.
+    /// Scale coordinates of the new sets to screen cordinates.
     /// @param factor The number of pixels per cell on the screen.
     void normalize(double factor);
+    /// Remove all particles.
+    void clear();
+    /// Set the factor, with which the particle counts given to add() are multiplied.
+    /// Sets get at least one particle.
+    void set_count_factor(double factor) {
+        count_factor = factor;
+    }
 
-    typedef std::vector<Particle> container;
-    typedef container::iterator iterator;
-    typedef container::const_iterator const_iterator;
-
-    iterator begin() {
-        return particles.begin();
+    unsigned num_sets() const {
+        return num_set_infos;
     }
-    iterator end() {
-        return particles.end();
+    /// Get the nth set; 0 is the oldest one.
+    ParticleSet get_set(unsigned n) const;
+
+private:
+    enum {
+        max_particles = 16384,
+        max_sets = 1024,
+    };
+
+    struct SetInfo {
+        GdColor color;
+        int life;
+        bool is_new;        ///< New particle set, the coordinates of which must be "normalized" to the cave screen coordinates
+        float size;
+        float opacity;
+        unsigned first, count;
+    };
+
+    /* the particles, in structure-of-arrays form */
+    std::vector<float> px, py, vx, vy;
+    unsigned next_particle;             ///< Place of the next set in the particle arrays
+    std::vector<SetInfo> set_infos;
+    unsigned first_set_info, num_set_infos;
+    guint32 random_state;               ///< Simple and fast random generator for the particles
+    double count_factor;
+
+    float random_range(float min, float max);
+    unsigned place_for(unsigned count) const;
+    void remove_oldest_set();
+    SetInfo &set_info(unsigned n) {
+        return set_infos[(first_set_info + n) % max_sets];
     }
-    const_iterator begin() const {
-        return particles.begin();
+    SetInfo const &set_info(unsigned n) const {
+        return set_infos[(first_set_info + n) % max_sets];
     }
-    const_iterator end() const {
-        return particles.end();
+};
+
+
+
+/// @brief Scales the number of particles to keep the drawing fast enough.
+///
+/// The time spent moving and drawing the particles is measured in every
+/// frame; drawing the cave is not counted, as removing particles would not
+/// make that faster. If the average goes above the budget, the count factor
+/// is decreased; if it is well below, the factor is increased again, up to 1.
+/// The factor is only decreased in frames which had particles.
+class ParticleGovernor {
+public:
+    /// @param budget_ms The time allowed for moving and drawing the particles in a frame.
+    explicit ParticleGovernor(double budget_ms = 5);
+    ~ParticleGovernor();
+
+    /// Start measuring a part of the frame.
+    void start();
+    /// Stop measuring; the elapsed time is added to the time of this frame.
+    void stop();
+    /// Evaluate the time of this frame, and adjust the factor.
+    /// @param had_particles True, if there were particles in this frame.
+    void frame_finished(bool had_particles);
+
+    /// The factor to multiply particle counts with, between min_factor and 1.
+    double get_factor() const {
+        return factor;
     }
-    size_t num_particles() const {
-        return particles.size();
+    /// The average measured frame time, in milliseconds.
+    double get_average_ms() const {
+        return average_ms;
     }
 
-    GdColor color;
-    int life;           ///< lifetime. starts from 1000, goes to 0.
-    bool is_new;        ///< New particle set, the coordinates of which must be "normalized" to the cave screen coordinates
-    float size;         ///< Size of the particles.
-    float opacity;      ///< Opacity between 0 and 1. Values close to 1 not recommended.
-
 private:
-    container particles;
+    ParticleGovernor(ParticleGovernor const &);             // not implemented
+    ParticleGovernor &operator=(ParticleGovernor const &);  // not implemented
+
+    static const double min_factor;
+    GTimer *timer;
+    double budget_ms;
+    double frame_ms;
+    double average_ms;
+    double factor;
 };
 
 #endif
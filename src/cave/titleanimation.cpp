@@ -35,13 +35,15 @@
 #include "cave/colors.hpp"
 #include "cave/cavetypes.hpp"
 #include "cave/titleanimation.hpp"
+#include "misc/parallel.hpp"
 
-std::vector<Pixbuf *> get_title_animation_pixbuf(const GdString &title_screen, const GdString &title_screen_scroll, bool one_frame_only, PixbufFactory &pixbuf_factory) {
-    typedef std::auto_ptr<Pixbuf> PixbufPtr;
+typedef std::auto_ptr<Pixbuf> PixbufPtr;
 
-    std::vector<Pixbuf *> animation;
 
-    PixbufPtr screen, tile;
+/* load the title image and the tile of the scrolling background from the caveset
+ * strings, or the built-in ones if the caveset has none. returns false if the
+ * caveset stores an invalid image. */
+static bool load_title_images(const GdString &title_screen, const GdString &title_screen_scroll, PixbufFactory &pixbuf_factory, PixbufPtr &screen, PixbufPtr &tile) {
     try {
         if (title_screen != "")
             screen = PixbufPtr(pixbuf_factory.create_from_base64(title_screen.c_str()));
@@ -49,12 +51,12 @@ std::vector<Pixbuf *> get_title_animation_pixbuf(const GdString &title_screen, c
             tile = PixbufPtr(pixbuf_factory.create_from_base64(title_screen_scroll.c_str()));
     } catch (std::exception &e) {
         gd_message(CPrintf("Caveset is storing an invalid title screen image: %s") % e.what());
-        return animation;
+        return false;
     }
 
     if (tile.get() != NULL && tile->get_height() > 40) {
         gd_message("Caveset is storing an oversized tile image");
-        tile.release();
+        tile.reset();
     }
 
     /* if no special title image or unable to load that one, load the built-in */
@@ -77,24 +79,45 @@ std::vector<Pixbuf *> get_title_animation_pixbuf(const GdString &title_screen, c
     /* do not allow more than 40 frames of animation */
     g_assert(tile->get_height() < 40);
 
-    /* create a big image, which is one tile larger than the title image size */
-    Pixbuf *bigone = pixbuf_factory.create(screen->get_width(), screen->get_height() + tile->get_height());
-    /* and fill it with the tile. use copy(), so pixbuf data is initialized! */
-    for (int y = 0; y < screen->get_height() + tile->get_height(); y += tile->get_height())
-        for (int x = 0; x < screen->get_width(); x += tile->get_width())
-            tile->copy(*bigone, x, y);
+    return true;
+}
+
 
+/* create a big image, which is one tile larger than the title image size,
+ * and fill it with the tile. */
+static Pixbuf *create_title_background(Pixbuf const &screen, Pixbuf const &tile, PixbufFactory &pixbuf_factory) {
+    Pixbuf *bigone = pixbuf_factory.create(screen.get_width(), screen.get_height() + tile.get_height());
+    /* use copy(), so pixbuf data is initialized! */
+    for (int y = 0; y < screen.get_height() + tile.get_height(); y += tile.get_height())
+        for (int x = 0; x < screen.get_width(); x += tile.get_width())
+            tile.copy(*bigone, x, y);
+    return bigone;
+}
+
+
+/* composite frame n of the animation into dest, which has the size of the title image. */
+static void compose_title_frame(Pixbuf const &background, Pixbuf const &screen, unsigned n, Pixbuf &dest) {
+    // copy part of the big tiled image
+    background.copy(0, n, screen.get_width(), screen.get_height(), dest, 0, 0);
+    // and composite it with the title image
+    screen.blit(dest, 0, 0);
+}
+
+
+std::vector<Pixbuf *> get_title_animation_pixbuf(const GdString &title_screen, const GdString &title_screen_scroll, bool one_frame_only, PixbufFactory &pixbuf_factory) {
+    std::vector<Pixbuf *> animation;
+
+    PixbufPtr screen, tile;
+    if (!load_title_images(title_screen, title_screen_scroll, pixbuf_factory, screen, tile))
+        return animation;
+
+    PixbufPtr bigone(create_title_background(*screen, *tile, pixbuf_factory));
     int framenum = one_frame_only ? 1 : tile->get_height();
     for (int i = 0; i < framenum; i++) {
         Pixbuf *frame = pixbuf_factory.create(screen->get_width(), screen->get_height());
-        // copy part of the big tiled image
-        bigone->copy(0, i, screen->get_width(), screen->get_height(), *frame, 0, 0);
-        // and composite it with the title image
-        screen->blit(*frame, 0, 0);
-        // copy to array
+        compose_title_frame(*bigone, *screen, i, *frame);
         animation.push_back(frame);
     }
-    delete bigone;
 
     return animation;
 }
@@ -113,3 +136,114 @@ std::vector<Pixmap *> get_title_animation_pixmap(const GdString &title_screen, c
 
     return pixmaps;
 }
+
+
+TitleAnimation::TitleAnimation(const GdString &title_screen, const GdString &title_screen_scroll, Screen &screen, bool streaming)
+    : screen(screen)
+    , frame_count(0)
+    , current_frame(-1)
+    , prefetching(false)
+    , prefetch_frame(0)
+    , prefetched(NULL) {
+    if (!streaming) {
+        pixmaps = get_title_animation_pixmap(title_screen, title_screen_scroll, false, screen, screen.pixbuf_factory);
+        frame_count = pixmaps.size();
+        return;
+    }
+
+    PixbufFactory &pixbuf_factory = screen.pixbuf_factory;
+    PixbufPtr tile;
+    if (!load_title_images(title_screen, title_screen_scroll, pixbuf_factory, title, tile)) {
+        title.reset();
+        tile.reset();
+        load_title_images(GdString(), GdString(), pixbuf_factory, title, tile);
+    }
+    background.reset(create_title_background(*title, *tile, pixbuf_factory));
+    composed.reset(pixbuf_factory.create(title->get_width(), title->get_height()));
+    prefetch_composed.reset(pixbuf_factory.create(title->get_width(), title->get_height()));
+    frame_count = tile->get_height();
+    /* no use of a worker thread if there is only a single processor */
+    if (frame_count > 1 && ParallelJobs::get_num_processors() > 1)
+        prefetch_worker.reset(new BackgroundWorker);
+}
+
+
+TitleAnimation::~TitleAnimation() {
+    stop_prefetch();
+    for (unsigned i = 0; i < pixmaps.size(); ++i)
+        delete pixmaps[i];
+}
+
+
+int TitleAnimation::get_width() const {
+    if (!pixmaps.empty())
+        return pixmaps[0]->get_width();
+    return title->get_width() * screen.get_pixmap_scale();
+}
+
+
+int TitleAnimation::get_height() const {
+    if (!pixmaps.empty())
+        return pixmaps[0]->get_height();
+    return title->get_height() * screen.get_pixmap_scale();
+}
+
+
+/* composite frame n in the buffer given, and return the scaled version of it. */
+Pixbuf *TitleAnimation::create_scaled_frame(unsigned n, Pixbuf &buffer) const {
+    compose_title_frame(*background, *title, n, buffer);
+    return screen.pixbuf_factory.create_scaled(buffer, screen.get_pixmap_scale(), screen.get_scaling_type(), screen.get_pal_emulation());
+}
+
+
+/* scales the next frame, on a worker thread. only touches the prefetch buffers. */
+void TitleAnimation::prefetch_job_func(gpointer data) {
+    TitleAnimation *ta = static_cast<TitleAnimation *>(data);
+    ta->prefetched = ta->create_scaled_frame(ta->prefetch_frame, *ta->prefetch_composed);
+}
+
+
+void TitleAnimation::start_prefetch(unsigned n) {
+    stop_prefetch();
+    if (prefetch_worker.get() == NULL)
+        return;
+    prefetch_frame = n;
+    prefetching = true;
+    prefetch_worker->start(prefetch_job_func, this);
+}
+
+
+void TitleAnimation::stop_prefetch() {
+    /* this waits for the worker, if it is just scaling */
+    if (prefetching) {
+        prefetch_worker->cancel();
+        prefetching = false;
+    }
+    delete prefetched;
+    prefetched = NULL;
+}
+
+
+Pixmap &TitleAnimation::get_frame(unsigned n) {
+    g_assert(n < frame_count);
+    if (!pixmaps.empty())
+        return *pixmaps[n];
+
+    if (int(n) != current_frame) {
+        PixbufPtr scaled;
+        if (prefetching && prefetch_frame == n) {
+            prefetch_worker->finish();
+            prefetching = false;
+            scaled.reset(prefetched);
+            prefetched = NULL;
+        } else {
+            stop_prefetch();
+            scaled.reset(create_scaled_frame(n, *composed));
+        }
+        current.reset(screen.create_pixmap_from_pixbuf(*scaled, false));
+        current_frame = n;
+        if (frame_count > 1)
+            start_prefetch((n + 1) % frame_count);
+    }
+    return *current;
+}
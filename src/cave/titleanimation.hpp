@@ -26,13 +26,16 @@
 
 #include "config.h"
 
+#include <glib.h>
 #include <vector>
+#include <memory>
 
 class Pixbuf;
 class Pixmap;
 class Screen;
 class GdString;
 class PixbufFactory;
+class BackgroundWorker;
 
 /**
  * Create and return an array of pixbufs, which contain the title animation, or the first frame only.
@@ -41,4 +44,69 @@ class PixbufFactory;
 std::vector<Pixbuf *> get_title_animation_pixbuf(const GdString &title_screen, const GdString &title_screen_scroll, bool one_frame_only, PixbufFactory &pixbuf_factory);
 std::vector<Pixmap *> get_title_animation_pixmap(const GdString &title_screen, const GdString &title_screen_scroll, bool one_frame_only, Screen &screen, PixbufFactory &pixbuf_factory);
 
+
+/// @ingroup Cave
+///
+/// @brief The title screen animation, scaled for a Screen.
+///
+/// In streaming mode, only the title image and the tiled scrolling background
+/// are stored. The frames are composited into a reused pixbuf when they are
+/// needed, and the next frame is scaled on a worker thread meanwhile; the
+/// thread is started once, with the animation. This
+/// saves the time and memory of scaling all frames up front, which can be
+/// a lot with a big scaling factor and PAL emulation.
+/// Otherwise all frames are created as pixmaps in the constructor.
+class TitleAnimation {
+public:
+    /// @param title_screen The title image of the caveset, or an empty string for the built-in one.
+    /// @param title_screen_scroll The scrolling background of the caveset.
+    /// @param screen The screen to create the pixmaps for.
+    /// @param streaming Create the frames on demand, instead of all of them in the constructor.
+    TitleAnimation(const GdString &title_screen, const GdString &title_screen_scroll, Screen &screen, bool streaming);
+    ~TitleAnimation();
+
+    /// The number of frames in the animation, at least 1.
+    unsigned get_frame_count() const {
+        return frame_count;
+    }
+
+    /// Width of the frames, scaled.
+    int get_width() const;
+    /// Height of the frames, scaled.
+    int get_height() const;
+
+    /// Get a frame of the animation. In streaming mode, the returned pixmap is only
+    /// valid until the next call.
+    Pixmap &get_frame(unsigned n);
+
+private:
+    Screen &screen;
+    unsigned frame_count;
+
+    /// All frames, if not streaming.
+    std::vector<Pixmap *> pixmaps;
+
+    /// The title image and the scrolling background, one tile higher than the title.
+    std::auto_ptr<Pixbuf> title, background;
+    /// Buffers to composite the unscaled frames in; one for the main thread and one for the prefetch.
+    std::auto_ptr<Pixbuf> composed, prefetch_composed;
+    /// The frame last returned by get_frame().
+    std::auto_ptr<Pixmap> current;
+    int current_frame;
+
+    /// Scaling the next frame in the background. No worker if there is a single processor.
+    std::auto_ptr<BackgroundWorker> prefetch_worker;
+    bool prefetching;
+    unsigned prefetch_frame;
+    Pixbuf *prefetched;
+
+    Pixbuf *create_scaled_frame(unsigned n, Pixbuf &buffer) const;
+    static void prefetch_job_func(gpointer data);
+    void start_prefetch(unsigned n);
+    void stop_prefetch();
+
+    TitleAnimation(const TitleAnimation &);                // not implemented
+    TitleAnimation &operator=(const TitleAnimation &);     // not implemented
+};
+
 #endif
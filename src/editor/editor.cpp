@@ -1921,6 +1921,7 @@ select_cave_for_edit(CaveStored *cave) {
 
             /* create list store for caveset */
             cave_list = gtk_list_store_new(NUM_CAVESET_COLUMNS, G_TYPE_POINTER, G_TYPE_STRING, GDK_TYPE_PIXBUF);
+            caveset->create_all_caves();
             for (unsigned n = 0; n < caveset->caves.size(); n++)
                 icon_view_add_cave(cave_list, &caveset->cave(n));
             /* we only connect this signal after adding all caves to the icon view, so it is only activated by the user! */
@@ -4049,6 +4050,8 @@ static void create_cave_editor(CaveSet *cs) {
 
 
 void gd_cave_editor_run(CaveSet *caveset) {
+    /* the caves are edited, so the work which uses them as loaded is done now */
+    caveset->finish_loading();
 start_again:
     restart_editor = false;
     create_cave_editor(caveset);
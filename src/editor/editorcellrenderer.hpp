@@ -52,6 +52,12 @@ private:
     void draw_editor_pixbufs();
     GdkPixbuf *get_element_pixbuf_with_border(int index);
 
+protected:
+    /** The editor draws arrows and the like over some cells. */
+    virtual const char *sheet_cache_variant() const {
+        return "editor";
+    }
+
 public:
     /**
      * @brief Constructor.
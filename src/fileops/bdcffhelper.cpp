@@ -25,9 +25,42 @@
 
 #include <iomanip>
 #include <stdexcept>
+#include <cstring>
+#include <glib.h>
 #include "fileops/bdcffhelper.hpp"
 #include "misc/util.hpp"
 #include "misc/printf.hpp"
+#include "cave/elementproperties.hpp"
+
+/// Check if the line contains the given character.
+bool BdcffLine::contains(char c) const {
+    return memchr(text, c, length) != NULL;
+}
+
+
+/// Check if the line equals the string, ignoring case for ascii characters.
+bool BdcffLine::caseequal(char const *str) const {
+    return g_ascii_strncasecmp(text, str, length) == 0 && str[length] == '\0';
+}
+
+
+/// Check if the line starts with the prefix, ignoring case for ascii characters.
+bool BdcffLine::caseprefix(char const *prefix) const {
+    size_t len = strlen(prefix);
+    return len <= length && g_ascii_strncasecmp(text, prefix, len) == 0;
+}
+
+
+/// Remove leading and trailing spaces, like gd_strchomp().
+void BdcffLine::chomp() {
+    while (length > 0 && text[0] == ' ') {
+        ++text;
+        --length;
+    }
+    while (length > 0 && text[length - 1] == ' ')
+        --length;
+}
+
 
 /// Create the functor which checks if the string
 /// has an attrib= prefix.
@@ -41,6 +74,11 @@ bool HasAttrib::operator()(const std::string &str) const {
     return gd_str_ascii_prefix(str, attrib);
 }
 
+/// Check if the given line has the prefix.
+bool HasAttrib::operator()(const BdcffLine &line) const {
+    return line.caseprefix(attrib.c_str());
+}
+
 
 /// Constructor: split string given by the separator given to attrib and param.
 /// @param str The string to split.
@@ -54,22 +92,33 @@ AttribParam::AttribParam(const std::string &str, char separator) {
 }
 
 
+/// Constructor: split a line given by the separator given to attrib and param.
+/// @param line The line to split.
+/// @param separator Separator between attrib and param; default is =.
+AttribParam::AttribParam(const BdcffLine &line, char separator) {
+    char const *equal = static_cast<char const *>(memchr(line.text, separator, line.length));
+    if (equal == NULL)
+        throw std::runtime_error(SPrintf("No separator in line: '%s'") % line.str());
+    attrib.assign(line.text, equal - line.text);
+    param.assign(equal + 1, line.text + line.length);
+}
+
+
 /// Create a new formatter.
 /// @param F The name of the output string; for example
 ///         give it "Point" if intending to write a line like "Point=1 2 DIRT"
 BdcffFormat::BdcffFormat(const std::string &f)
     :   name(f),
         firstparam(true) {
-    os << std::setprecision(4) << std::fixed;
 }
 
 /// Get the output string.
 /// @return The converted string.
 std::string BdcffFormat::str() const {
     if (name.empty())
-        return os.str();
+        return params;
     else
-        return name + '=' + os.str();
+        return name + '=' + params;
 }
 
 /// Start a new conversion with a new name.
@@ -77,5 +126,91 @@ std::string BdcffFormat::str() const {
 void BdcffFormat::start_new(const std::string &f) {
     name = f;
     firstparam = true;
-    os.str("");     /* clear output */
+    params.clear();     /* clear output */
+}
+
+
+/* integers are converted by hand, as in the "C" locale. */
+void bdcff_append(std::string &out, unsigned i) {
+    char digits[16];
+    char *p = digits + sizeof(digits);
+    do {
+        *--p = '0' + i % 10;
+        i /= 10;
+    } while (i != 0);
+    out.append(p, digits + sizeof(digits));
+}
+
+void bdcff_append(std::string &out, int i) {
+    if (i < 0) {
+        out += '-';
+        bdcff_append(out, 0u - unsigned(i));
+    } else
+        bdcff_append(out, unsigned(i));
+}
+
+/* like an ostream with std::fixed and std::setprecision(4) - but independent of the locale */
+void bdcff_append(std::string &out, double d) {
+    char text[G_ASCII_DTOSTR_BUF_SIZE];
+    out += g_ascii_formatd(text, sizeof(text), "%.4f", d);
+}
+
+void bdcff_append(std::string &out, char const *s) {
+    if (s != NULL)
+        out += s;
+}
+
+void bdcff_append(std::string &out, std::string const &s) {
+    out += s;
+}
+
+void bdcff_append(std::string &out, GdBool const &b) {
+    out += b ? "true" : "false";
+}
+
+void bdcff_append(std::string &out, GdInt const &i) {
+    bdcff_append(out, int(i));
+}
+
+void bdcff_append(std::string &out, GdProbability const &p) {
+    bdcff_append(out, p / 1000000.0);
+}
+
+void bdcff_append(std::string &out, GdElement const &e) {
+    /* some internal elements have no name; write nothing for them, like an ostream would */
+    if (gd_element_properties[e].filename != NULL)
+        out += gd_element_properties[e].filename;
+}
+
+void bdcff_append(std::string &out, Coordinate const &p) {
+    bdcff_append(out, int(p.x));
+    out += ' ';
+    bdcff_append(out, int(p.y));
+}
+
+
+/// Create a writer, which appends the lines to the string given.
+BdcffWriter::BdcffWriter(std::string &out_)
+    :   out(out_),
+        firstparam(true) {
+}
+
+/// Write a complete line.
+void BdcffWriter::line(std::string const &text) {
+    out += text;
+    out += '\n';
+}
+
+/// Start a new line like "Name=". If the name is empty, the line will only contain the parameters.
+void BdcffWriter::start_line(char const *name) {
+    firstparam = true;
+    if (name[0] != '\0') {
+        out += name;
+        out += '=';
+    }
+}
+
+/// Finish the current line.
+void BdcffWriter::end_line() {
+    out += '\n';
 }
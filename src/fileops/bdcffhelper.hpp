@@ -28,10 +28,44 @@
 
 #include <string>
 #include <list>
+#include <vector>
 #include <sstream>
+#include <iomanip>
+
+#include "cave/cavetypes.hpp"
 
 #define BDCFF_VERSION "0.5"
 
+/**
+ * A line of a BDCFF file, which is not copied from the buffer the file
+ * was loaded to, but points into it. The buffer must outlive the line.
+ */
+class BdcffLine {
+public:
+    char const *text;
+    unsigned length;
+
+    BdcffLine(char const *text_, unsigned length_) : text(text_), length(length_) {}
+    bool empty() const {
+        return length == 0;
+    }
+    char operator[](unsigned i) const {
+        return text[i];
+    }
+    bool contains(char c) const;
+    bool caseequal(char const *str) const;
+    bool caseprefix(char const *prefix) const;
+    void chomp();
+    /** Create a copy of the line as a string. */
+    std::string str() const {
+        return std::string(text, length);
+    }
+};
+
+/// The lines of a section of a BDCFF file, as read by the loader.
+typedef std::vector<BdcffLine> BdcffLines;
+
+
 /**
  *  Functor which checks if a string has another string as its prefix.
  *  eg, it will return true for "SlimePermeability=0.1" begins with "SlimePermeability"
@@ -42,6 +76,7 @@ class HasAttrib {
 public:
     explicit HasAttrib(const std::string &attrib_);
     bool operator()(const std::string &str) const;
+    bool operator()(const BdcffLine &line) const;
 };
 
 
@@ -54,38 +89,9 @@ public:
     std::string attrib;
     std::string param;
     explicit AttribParam(const std::string &str, char separator = '=');
+    explicit AttribParam(const BdcffLine &line, char separator = '=');
 };
 
-typedef std::list<std::string> BdcffSection;
-typedef BdcffSection::iterator BdcffSectionIterator;
-typedef BdcffSection::const_iterator BdcffSectionConstIterator;
-
-/**
- * A structure, which stores the lines of text in a bdcff file; and has a list
- * of these strings for each section.
- *
- * The main format of the bdcff file.
- * Contains: bdcff section; highscore for caveset, map codes, caveset properties, and caves data.
- * Caves data contains: highscore for cave, cave properties, maybe map, maybe objects, maybe replays, maybe demo (=legacy replay).
- */
-struct BdcffFile {
-    struct CaveInfo {
-        BdcffSection highscore;
-        BdcffSection properties;
-        BdcffSection map;
-        BdcffSection objects;
-        std::list<BdcffSection> replays;
-        BdcffSection demo;
-    };
-
-    BdcffSection bdcff;
-    BdcffSection highscore;
-    BdcffSection mapcodes;
-    BdcffSection caveset_properties;
-    std::list<CaveInfo> caves;
-};
-
-
 /** A class which helps outputting BDCFF lines like "Point=x y z".
  *
  * It stores a name (Point), and can be fed with parameters
@@ -95,7 +101,7 @@ struct BdcffFile {
  */
 class BdcffFormat {
 private:
-    std::ostringstream os;  ///< for conversion
+    std::string params;     ///< the parameters converted so far
     std::string name;       ///< name of parameter, eg. Size
     bool firstparam;        ///< used internally do determine if a space is needed
 
@@ -110,6 +116,30 @@ public:
     }
 };
 
+
+/* Append a parameter of a BDCFF line to a string.
+ * These give the same output as the operator<< of the types, but the common
+ * ones are converted without creating an ostringstream. */
+void bdcff_append(std::string &out, int i);
+void bdcff_append(std::string &out, unsigned i);
+void bdcff_append(std::string &out, double d);
+void bdcff_append(std::string &out, char const *s);
+void bdcff_append(std::string &out, std::string const &s);
+void bdcff_append(std::string &out, GdBool const &b);
+void bdcff_append(std::string &out, GdInt const &i);
+void bdcff_append(std::string &out, GdProbability const &p);
+void bdcff_append(std::string &out, GdElement const &e);
+void bdcff_append(std::string &out, Coordinate const &p);
+
+/** Append any other type to the string, using its operator<<. */
+template <typename T>
+void bdcff_append(std::string &out, T const &param) {
+    std::ostringstream os;
+    os << std::setprecision(4) << std::fixed << param;
+    out += os.str();
+}
+
+
 /**
  * @brief Feed next output parameter to the formatter.
  * @param param The variable to write.
@@ -119,10 +149,46 @@ template <typename T>
 BdcffFormat &BdcffFormat::operator<<(const T &param) {
     /* if this is not the first parameter, add a space */
     if (!firstparam)
-        os << ' ';
+        params += ' ';
+    else
+        firstparam = false;
+    bdcff_append(params, param);
+    return *this;
+}
+
+
+/**
+ * Writes BDCFF lines to the end of a string.
+ *
+ * Like BdcffFormat, but the lines are not created as separate strings; the
+ * name and the parameters are appended to the output at once. Every line is
+ * terminated by a newline character.
+ */
+class BdcffWriter {
+private:
+    std::string &out;       ///< the output
+    bool firstparam;        ///< used internally do determine if a space is needed
+
+public:
+    explicit BdcffWriter(std::string &out_);
+    void line(std::string const &text);
+    void start_line(char const *name);
+    template <typename T> BdcffWriter &operator<<(const T &param);
+    void end_line();
+};
+
+/**
+ * @brief Append the next parameter to the current line.
+ * @param param The variable to write.
+ * @return Itself, for linking << a << b << c.
+ */
+template <typename T>
+BdcffWriter &BdcffWriter::operator<<(const T &param) {
+    if (!firstparam)
+        out += ' ';
     else
         firstparam = false;
-    os << param;
+    bdcff_append(out, param);
     return *this;
 }
 
@@ -24,6 +24,10 @@
 #include "config.h"
 
 #include <glib.h>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <deque>
 
 #include "fileops/bdcffload.hpp"
 
@@ -36,6 +40,8 @@
 #include "misc/printf.hpp"
 #include "misc/util.hpp"
 #include "misc/autogfreeptr.hpp"
+#include "misc/trace.hpp"
+#include "misc/parallel.hpp"
 #include "cave/elementproperties.hpp"
 #include "settings.hpp"
 
@@ -44,106 +50,239 @@
 #include "cave/object/caveobjectfillrect.hpp" /* bdcff intermission hack - adding a cavefillrect */
 
 
+/// An index of the identifiers of a property description array, to find
+/// the properties of a BDCFF attribute quickly. Identifiers are compared
+/// case-insensitively. It is an open-addressing hash table, which stores the
+/// numbers of the descriptions which have a given identifier, in their order.
+class PropertyIndex {
+public:
+    explicit PropertyIndex(PropertyDescription const *prop_desc);
+    /// Find the descriptions for an identifier.
+    /// @param count Set to the number of descriptions found.
+    /// @return The numbers of the descriptions; only valid if count is not zero.
+    unsigned const *find(const std::string &identifier, unsigned &count) const;
+    /// Get the index for a description array. It is created at the first call,
+    /// and kept until the program exits; so this can only be used for static arrays.
+    static PropertyIndex const &get(PropertyDescription const *prop_desc);
+
+private:
+    struct Entry {
+        char const *identifier;
+        std::vector<unsigned> descriptions;
+    };
+    std::vector<Entry> entries;
+    std::vector<int> slots;     ///< Entry numbers, or -1 for an empty slot; the size is a power of two
+
+    static unsigned hash(char const *str);
+    unsigned find_slot(char const *identifier) const;
+};
+
+
+/* fnv-1a hash of the lowercase string */
+unsigned PropertyIndex::hash(char const *str) {
+    unsigned h = 2166136261u;
+    for (; *str != '\0'; ++str) {
+        h ^= (unsigned char) g_ascii_tolower(*str);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+/* the slot of the identifier, or the empty slot where it should be. */
+unsigned PropertyIndex::find_slot(char const *identifier) const {
+    unsigned mask = slots.size() - 1;
+    unsigned slot = hash(identifier) & mask;
+    while (slots[slot] != -1 && g_ascii_strcasecmp(entries[slots[slot]].identifier, identifier) != 0)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+
+PropertyIndex::PropertyIndex(PropertyDescription const *prop_desc) {
+    unsigned count = 0;
+    while (prop_desc[count].identifier != NULL)
+        ++count;
+    /* at most half full */
+    unsigned size = 16;
+    while (size < count * 2)
+        size *= 2;
+    slots.resize(size, -1);
+    for (unsigned i = 0; i < count; ++i) {
+        unsigned slot = find_slot(prop_desc[i].identifier);
+        if (slots[slot] == -1) {
+            slots[slot] = entries.size();
+            entries.push_back(Entry());
+            entries.back().identifier = prop_desc[i].identifier;
+        }
+        entries[slots[slot]].descriptions.push_back(i);
+    }
+}
+
+
+unsigned const *PropertyIndex::find(const std::string &identifier, unsigned &count) const {
+    int entry = slots[find_slot(identifier.c_str())];
+    if (entry == -1) {
+        count = 0;
+        return NULL;
+    }
+    count = entries[entry].descriptions.size();
+    return &entries[entry].descriptions[0];
+}
+
+
+static StaticMutex property_index_mutex = GD_STATIC_MUTEX_INIT;
+
+PropertyIndex const &PropertyIndex::get(PropertyDescription const *prop_desc) {
+    static std::map<PropertyDescription const *, PropertyIndex *> indexes;
+
+    StaticMutexLock lock(property_index_mutex);
+    PropertyIndex *&index = indexes[prop_desc];
+    if (index == NULL)
+        index = new PropertyIndex(prop_desc);
+    return *index;
+}
+
+
+/// Splits the parameters of a BDCFF line at the spaces, like g_strsplit_set()
+/// would do, but without allocating memory for every word.
+/// Consecutive spaces give empty words; an empty string has no words.
+class ParamSplitter {
+public:
+    explicit ParamSplitter(const std::string &param)
+        : param(param), pos(0), more(!param.empty()) {
+        set_word();
+    }
+    /// True, if there is a current word.
+    bool has_word() const {
+        return more;
+    }
+    /// The current word.
+    const std::string &get_word() const {
+        return word;
+    }
+    void next() {
+        size_t space = param.find(' ', pos);
+        if (space == std::string::npos)
+            more = false;
+        else {
+            pos = space + 1;
+            set_word();
+        }
+    }
+
+private:
+    const std::string &param;
+    size_t pos;
+    bool more;
+    std::string word;   ///< Reused for every word
+
+    void set_word() {
+        size_t space = param.find(' ', pos);
+        word.assign(param, pos, space == std::string::npos ? std::string::npos : space - pos);
+    }
+};
+
+
 /// @todo remove
 bool struct_set_property(Reflective &str, const std::string &attrib, const std::string &param, int ratio, PropertyDescription const *prop_desc) {
-    int paramindex = 0;
+    unsigned count;
+    unsigned const *descriptions = PropertyIndex::get(prop_desc).find(attrib, count);
+    if (count == 0)
+        return false;
 
-    char **params = g_strsplit_set(param.c_str(), " ", -1);
-    int paramcount = g_strv_length(params);
-    bool identifier_found = false;
+    ParamSplitter params(param);
 
-    /* check all known tags. do not exit this loop if identifier_found==true...
-       as there are more lines in the array which have the same identifier. */
+    /* process all descriptions with this identifier, as there
+       are more lines in the array which have the same identifier. */
     bool was_string = false;
-    for (unsigned i = 0; prop_desc[i].identifier != NULL; i++)
-        if (gd_str_ascii_caseequal(prop_desc[i].identifier, attrib)) {
-            /* found the identifier */
-            identifier_found = true;
-            std::auto_ptr<GetterBase> const &prop = prop_desc[i].prop;
-            if (prop_desc[i].type == GD_TYPE_STRING) {
-                /* strings are treated different, as occupy the whole length of the line */
-                str.get<GdString>(prop) = param;
-                was_string = true;  /* remember this to skip checking the number of parameters at the end of the function */
-                continue;
-            }
-
-            if (prop_desc[i].type == GD_TYPE_LONGSTRING) {
-                AutoGFreePtr<char> compressed(g_strcompress(param.c_str()));
-                str.get<GdString>(prop) = compressed;
-                was_string = true;  /* remember this to skip checking the number of parameters at the end of the function */
-                continue;
-            }
+    for (unsigned n = 0; n < count; n++) {
+        unsigned i = descriptions[n];
+        std::auto_ptr<GetterBase> const &prop = prop_desc[i].prop;
+        if (prop_desc[i].type == GD_TYPE_STRING) {
+            /* strings are treated different, as occupy the whole length of the line */
+            str.get<GdString>(prop) = param;
+            was_string = true;  /* remember this to skip checking the number of parameters at the end of the function */
+            continue;
+        }
 
-            /* not a string, so use scanf calls */
-            /* try to read as many words, as there are elements in this property (array) */
-            /* ALSO, if no more parameters to process, exit loop */
-            for (unsigned j = 0; j < prop->count && params[paramindex] != NULL; j++) {
-                bool success = false;
+        if (prop_desc[i].type == GD_TYPE_LONGSTRING) {
+            AutoGFreePtr<char> compressed(g_strcompress(param.c_str()));
+            str.get<GdString>(prop) = compressed;
+            was_string = true;  /* remember this to skip checking the number of parameters at the end of the function */
+            continue;
+        }
 
-                switch (prop_desc[i].type) {
-                    case GD_TYPE_BOOLEAN:
-                        success = read_from_string(params[paramindex], str.get<GdBool>(prop));
-                        /* if we are processing an array, fill other values with these. if there are other values specified, those will be overwritten. */
-                        break;
-                    case GD_TYPE_INT:
-                        if (prop_desc[i].flags & GD_BDCFF_RATIO_TO_CAVE_SIZE)
-                            success = read_from_string(params[paramindex], str.get<GdInt>(prop), ratio); /* saved as double, ratio to cave size */
-                        else
-                            success = read_from_string(params[paramindex], str.get<GdInt>(prop));
-                        break;
-                    case GD_TYPE_INT_LEVELS:
-                        if (prop_desc[i].flags & GD_BDCFF_RATIO_TO_CAVE_SIZE)
-                            success = read_from_string(params[paramindex], str.get<GdIntLevels>(prop)[j], ratio); /* saved as double, ratio to cave size */
-                        else
-                            success = read_from_string(params[paramindex], str.get<GdIntLevels>(prop)[j]);
-                        if (success) /* copy to other if array */
-                            for (unsigned k = j + 1; k < prop->count; k++)
-                                str.get<GdIntLevels>(prop)[k] = str.get<GdIntLevels>(prop)[j];
-                        break;
-                    case GD_TYPE_PROBABILITY:
-                        success = read_from_string(params[paramindex], str.get<GdProbability>(prop));
-                        break;
-                    case GD_TYPE_PROBABILITY_LEVELS:
-                        success = read_from_string(params[paramindex], str.get<GdProbabilityLevels>(prop)[j]);
-                        if (success) /* copy to other if array */
-                            for (unsigned k = j + 1; k < prop->count; k++)
-                                str.get<GdProbabilityLevels>(prop)[k] = str.get<GdProbabilityLevels>(prop)[j];
-                        break;
-                    case GD_TYPE_ELEMENT:
-                        success = read_from_string(params[paramindex], str.get<GdElement>(prop));
-                        break;
-                    case GD_TYPE_DIRECTION:
-                        success = read_from_string(params[paramindex], str.get<GdDirection>(prop));
-                        break;
-                    case GD_TYPE_SCHEDULING:
-                        success = read_from_string(params[paramindex], str.get<GdScheduling>(prop));
-                        break;
+        /* not a string, so use scanf calls */
+        /* try to read as many words, as there are elements in this property (array) */
+        /* ALSO, if no more parameters to process, exit loop */
+        for (unsigned j = 0; j < prop->count && params.has_word(); j++) {
+            bool success = false;
+            std::string const &word = params.get_word();
 
-                    case GD_TYPE_LONGSTRING:    /* processed above */
-                    case GD_TYPE_STRING:        /* processed above */
-                    case GD_TYPE_COLOR:         /* processed elsewhere */
-                    case GD_TYPE_EFFECT:        /* processed elsewhere */
-                    case GD_TYPE_COORDINATE:    /* caves do not have */
-                    case GD_TYPE_BOOLEAN_LEVELS:    /* caves do not have */
-                    case GD_TAB:                /* ui */
-                    case GD_LABEL:              /* ui */
-                        g_assert_not_reached();
-                        break;
-                }
+            switch (prop_desc[i].type) {
+                case GD_TYPE_BOOLEAN:
+                    success = read_from_string(word, str.get<GdBool>(prop));
+                    /* if we are processing an array, fill other values with these. if there are other values specified, those will be overwritten. */
+                    break;
+                case GD_TYPE_INT:
+                    if (prop_desc[i].flags & GD_BDCFF_RATIO_TO_CAVE_SIZE)
+                        success = read_from_string(word, str.get<GdInt>(prop), ratio); /* saved as double, ratio to cave size */
+                    else
+                        success = read_from_string(word, str.get<GdInt>(prop));
+                    break;
+                case GD_TYPE_INT_LEVELS:
+                    if (prop_desc[i].flags & GD_BDCFF_RATIO_TO_CAVE_SIZE)
+                        success = read_from_string(word, str.get<GdIntLevels>(prop)[j], ratio); /* saved as double, ratio to cave size */
+                    else
+                        success = read_from_string(word, str.get<GdIntLevels>(prop)[j]);
+                    if (success) /* copy to other if array */
+                        for (unsigned k = j + 1; k < prop->count; k++)
+                            str.get<GdIntLevels>(prop)[k] = str.get<GdIntLevels>(prop)[j];
+                    break;
+                case GD_TYPE_PROBABILITY:
+                    success = read_from_string(word, str.get<GdProbability>(prop));
+                    break;
+                case GD_TYPE_PROBABILITY_LEVELS:
+                    success = read_from_string(word, str.get<GdProbabilityLevels>(prop)[j]);
+                    if (success) /* copy to other if array */
+                        for (unsigned k = j + 1; k < prop->count; k++)
+                            str.get<GdProbabilityLevels>(prop)[k] = str.get<GdProbabilityLevels>(prop)[j];
+                    break;
+                case GD_TYPE_ELEMENT:
+                    success = read_from_string(word, str.get<GdElement>(prop));
+                    break;
+                case GD_TYPE_DIRECTION:
+                    success = read_from_string(word, str.get<GdDirection>(prop));
+                    break;
+                case GD_TYPE_SCHEDULING:
+                    success = read_from_string(word, str.get<GdScheduling>(prop));
+                    break;
 
-                if (success)
-                    paramindex++;   /* go to next parameter to process */
-                else
-                    gd_warning(CPrintf("invalid parameter '%s' for attribute %s") % params[paramindex] % attrib);
+                case GD_TYPE_LONGSTRING:    /* processed above */
+                case GD_TYPE_STRING:        /* processed above */
+                case GD_TYPE_COLOR:         /* processed elsewhere */
+                case GD_TYPE_EFFECT:        /* processed elsewhere */
+                case GD_TYPE_COORDINATE:    /* caves do not have */
+                case GD_TYPE_BOOLEAN_LEVELS:    /* caves do not have */
+                case GD_TAB:                /* ui */
+                case GD_LABEL:              /* ui */
+                    g_assert_not_reached();
+                    break;
             }
+
+            if (success)
+                params.next();   /* go to next parameter to process */
+            else
+                gd_warning(CPrintf("invalid parameter '%s' for attribute %s") % word % attrib);
         }
+    }
     /* if we found the identifier, but still could not process all parameters... */
     /* of course, not for strings, as the whole line is the string */
-    if (identifier_found && !was_string && paramindex < paramcount)
-        gd_message(CPrintf("excess parameters for attribute '%s': '%s'") % attrib % params[paramindex]);
-    g_strfreev(params);
+    if (!was_string && params.has_word())
+        gd_message(CPrintf("excess parameters for attribute '%s': '%s'") % attrib % params.get_word());
 
-    return identifier_found;
+    return true;
 }
 
 
@@ -170,16 +309,20 @@ static bool replay_process_tag(CaveReplay &replay, const std::string &attrib, co
 }
 
 
-static bool cave_process_tags_func(CaveStored &cave, const std::string &attrib, const std::string &param) {
-    char **params = g_strsplit_set(param.c_str(), " ", -1);
-    /// @todo make an autoptr-like class for this stuff
-    struct Finally {
-        char **params;
-        Finally(char **params) : params(params) {}
-        ~Finally() { g_strfreev(params); }
-    } finally(params);
-    int paramcount = g_strv_length(params);
+/// Split the parameters of a line into words, for the tags which are processed by hand.
+/// @param words Array to store the words to.
+/// @param max The size of the array; words after these are only counted.
+/// @return The number of words in the parameters, which may be more than max.
+static unsigned split_params(const std::string &param, std::string words[], unsigned max) {
+    unsigned count = 0;
+    for (ParamSplitter params(param); params.has_word(); params.next(), ++count)
+        if (count < max)
+            words[count] = params.get_word();
+    return count;
+}
+
 
+static bool cave_process_tags_func(CaveStored &cave, const std::string &attrib, const std::string &param) {
     /* compatibility with old snapexplosions flag */
     if (gd_str_ascii_caseequal(attrib, "SnapExplosions")) {
         GdBool b;
@@ -218,7 +361,9 @@ static bool cave_process_tags_func(CaveStored &cave, const std::string &attrib,
     /* compatibility with old AmoebaProperties flag */
     if (gd_str_ascii_caseequal(attrib, "AmoebaProperties")) {
         GdElement elem1 = O_STONE, elem2 = O_DIAMOND;
-        bool success = read_from_string(params[0], elem1) && read_from_string(params[1], elem2);
+        std::string params[2];
+        unsigned paramcount = split_params(param, params, G_N_ELEMENTS(params));
+        bool success = paramcount >= 2 && read_from_string(params[0], elem1) && read_from_string(params[1], elem2);
         if (success) {
             cave.amoeba_too_big_effect = elem1;
             cave.amoeba_enclosed_effect = elem2;
@@ -232,6 +377,8 @@ static bool cave_process_tags_func(CaveStored &cave, const std::string &attrib,
         /* Colors=[border background] foreground1 foreground2 foreground3 [amoeba slime] */
         bool ok = true;
         GdColor cb, c0, c1, c2, c3, c4, c5;
+        std::string params[7];
+        unsigned paramcount = split_params(param, params, G_N_ELEMENTS(params));
 
         if (paramcount == 3) {
             // only color1,2,3
@@ -282,7 +429,8 @@ static bool cave_process_tags_func(CaveStored &cave, const std::string &attrib,
     /* effects are also handled in an ugly way in bdcff */
     if (gd_str_ascii_caseequal(attrib, "Effect")) {
         /* an effect command has two parameters */
-        if (paramcount == 2) {
+        std::string params[2];
+        if (split_params(param, params, G_N_ELEMENTS(params)) == 2) {
             bool success = false;
             PropertyDescription const *descriptor = cave.get_description_array();
 
@@ -344,15 +492,15 @@ static bool cave_process_tags_func(CaveStored &cave, const std::string &attrib,
 /// @param lines The list of lines to find the attrib in.
 /// @param name The name of the attribute to find.
 /// @return true, if the property is found. If found, it is also processed and removed.
-static bool cave_process_specific_tag(CaveStored &cave, BdcffSection &lines, const std::string &name) {
-    BdcffSectionIterator it = find_if(lines.begin(), lines.end(), HasAttrib(name));
+static bool cave_process_specific_tag(CaveStored &cave, BdcffLines &lines, const std::string &name) {
+    BdcffLines::iterator it = find_if(lines.begin(), lines.end(), HasAttrib(name));
     bool found = it != lines.end();
     if (found) {
         try {
             AttribParam ap(*it);        // split into attrib and param
             cave_process_tags_func(cave, ap.attrib, ap.param);
         } catch (std::exception &e) {
-            gd_warning(CPrintf("Cannot parse: %s") % *it);
+            gd_warning(CPrintf("Cannot parse: %s") % it->str());
         }
         lines.erase(it);            // erase after processing
     }
@@ -364,9 +512,7 @@ static bool cave_process_specific_tag(CaveStored &cave, BdcffSection &lines, con
 /// For example, the name is processed first, to be able to show all error messages with the cave name context.
 /// Then the engine tag is processed - well, because bdcff sucks.
 /// Then the size - to make sure ratios are read correctly - bdcff sucks.
-static void cave_process_all_tags(CaveStored &cave, BdcffSection &lines) {
-    BdcffSectionIterator it;
-
+static void cave_process_all_tags(CaveStored &cave, BdcffLines &lines) {
     // first check cave name, so we can report errors correctly (saying that CaveStored xy: error foobar)
     cave_process_specific_tag(cave, lines, "Name");
     SetLoggerContextForFunction scf((cave.name == "") ? SPrintf("<unnamed cave>") : (SPrintf("Cave '%s'") % cave.name));
@@ -400,16 +546,16 @@ static void cave_process_all_tags(CaveStored &cave, BdcffSection &lines) {
     }
 
     // process remaining tags - most of them do not require special care.
-    for (BdcffSectionConstIterator it = lines.begin(); it != lines.end(); ++it) {
+    for (BdcffLines::const_iterator it = lines.begin(); it != lines.end(); ++it) {
         try {
             AttribParam ap(*it);
             if (!cave_process_tags_func(cave, ap.attrib, ap.param)) {
                 gd_message(CPrintf("unknown tag '%s'") % ap.attrib);
-                cave.unknown_tags += *it;
+                cave.unknown_tags.append(it->text, it->length);
                 cave.unknown_tags += '\n';
             }
         } catch (std::exception &e) {
-            gd_warning(CPrintf("Cannot parse line: %s") % *it);
+            gd_warning(CPrintf("Cannot parse line: %s") % it->str());
         }
     }
 }
@@ -428,9 +574,31 @@ static bool add_highscore(HighScoreTable &hs, const std::string &name, const std
     return true;
 }
 
-static BdcffFile parse_bdcff_sections(const char *file_contents) {
-    BdcffFile file;
-    std::istringstream is(file_contents);
+/// The lines of a BDCFF file, sorted into sections, as read by the loader.
+/// The lines point into the file contents, which must outlive this.
+struct BdcffLoadedFile {
+    struct CaveInfo {
+        BdcffLines highscore;
+        BdcffLines properties;
+        BdcffLines map;
+        BdcffLines objects;
+        std::list<BdcffLines> replays;
+        std::list<BdcffLines> demos;    ///< The lines of a demo are to be joined
+    };
+
+    BdcffLines bdcff;
+    BdcffLines highscore;
+    BdcffLines mapcodes;
+    BdcffLines caveset_properties;
+    std::deque<CaveInfo> caves;
+};
+
+
+/// Split the file contents into lines, and sort them into sections.
+/// The lines are not copied, only their positions in the buffer are stored.
+/// The contents need not be terminated by a zero.
+static BdcffLoadedFile parse_bdcff_sections(const char *file_contents, size_t length) {
+    BdcffLoadedFile file;
     enum ReadState {
         Start,          ///< should be nothing here.
         Bdcff,          ///< inside [bdcff], eg. version=0.5
@@ -446,15 +614,19 @@ static BdcffFile parse_bdcff_sections(const char *file_contents) {
         CaveMap         ///< map-encoded cave
     } state;
 
-    std::string line;
     state = Start;
     bool bailout = false;
-    for (int lineno = 1; !bailout && getline(is, line); lineno++) {
-        SetLoggerContextForFunction scf(SPrintf("Line %d") % lineno);
-
-        size_t found_r;
-        while ((found_r = line.find('\r')) != std::string::npos)
-            line.erase(found_r, 1);     /* remove windows-nightmare \r-s */
+    char const *next = file_contents;
+    char const *const end = file_contents + length;
+    for (int lineno = 1; !bailout && next != end; lineno++) {
+        char const *eol = (char const *) memchr(next, '\n', end - next);
+        if (eol == NULL)
+            eol = end;
+        BdcffLine line(next, eol - next);
+        next = (eol != end) ? eol + 1 : eol;
+
+        while (!line.empty() && line[line.length - 1] == '\r')
+            line.length--;              /* remove windows-nightmare \r-s */
         if (line.empty())
             continue;                   /* skip empty lines */
 
@@ -463,22 +635,24 @@ static BdcffFile parse_bdcff_sections(const char *file_contents) {
 
         /* STARTING WITH A BRACKET [ IS A SECTION */
         if (line[0] == '[') {
-            if (gd_str_ascii_caseequal(line, "[BDCFF]")) {
+            /* only here, as creating the context for every line would be slow */
+            SetLoggerContextForFunction scf(SPrintf("Line %d") % lineno);
+            if (line.caseequal("[BDCFF]")) {
                 if (state != Start) {
                     gd_critical("first section should be [BDCFF]. Bailing out!");
                     bailout = true;
                 }
                 state = Bdcff;
-            } else if (gd_str_ascii_caseequal(line, "[/BDCFF]")) {
+            } else if (line.caseequal("[/BDCFF]")) {
                 state = Start;
-            } else if (gd_str_ascii_caseequal(line, "[game]")) {
+            } else if (line.caseequal("[game]")) {
                 if (state != Bdcff)
                     gd_warning("[game] should be inside [BDCFF]");
                 state = Game;
-            } else if (gd_str_ascii_caseequal(line, "[/game]")) {
+            } else if (line.caseequal("[/game]")) {
                 if (state != Game)
                     gd_warning("[/game] not in [game] section");
-            } else if (gd_str_ascii_caseequal(line, "[mapcodes]")) {
+            } else if (line.caseequal("[mapcodes]")) {
                 switch (state) {
                     case Game:
                         state = GameMapCodes;
@@ -491,7 +665,7 @@ static BdcffFile parse_bdcff_sections(const char *file_contents) {
                         state = BdcffMapCodes;
                         break;
                 }
-            } else if (gd_str_ascii_caseequal(line, "[/mapcodes]")) {
+            } else if (line.caseequal("[/mapcodes]")) {
                 switch (state) {
                     case GameMapCodes:
                         state = Game;
@@ -503,25 +677,25 @@ static BdcffFile parse_bdcff_sections(const char *file_contents) {
                         gd_warning("[/mapcodes] not after [mapcodes]");
                         state = Game;
                 }
-            } else if (gd_str_ascii_caseequal(line, "[cave]")) {
+            } else if (line.caseequal("[cave]")) {
                 if (state != Game)
                     gd_warning("[cave] allowed only in [game] section");
                 state = Cave;
-                file.caves.push_back(BdcffFile::CaveInfo());    /* new empty space for a cave */
-            } else if (gd_str_ascii_caseequal(line, "[/cave]")) {
+                file.caves.push_back(BdcffLoadedFile::CaveInfo());    /* new empty space for a cave */
+            } else if (line.caseequal("[/cave]")) {
                 if (state != Cave)
                     gd_warning("[/cave] tag without starting [cave]");
                 state = Game;
-            } else if (gd_str_ascii_caseequal(line, "[map]")) {
+            } else if (line.caseequal("[map]")) {
                 if (state != Cave)
                     gd_warning("[map] section only allowed inside [cave]");
                 else    /* else: do not enter map reading when not in a cave! */
                     state = CaveMap;
-            } else if (gd_str_ascii_caseequal(line, "[/map]")) {
+            } else if (line.caseequal("[/map]")) {
                 if (state != CaveMap)
                     gd_warning("[/map] tag without starting [map]");
                 state = Cave;
-            } else if (gd_str_ascii_caseequal(line, "[highscore]")) {
+            } else if (line.caseequal("[highscore]")) {
                 /* can be inside game or cave */
                 if (state == Game)
                     state = GameHighScore;
@@ -531,7 +705,7 @@ static BdcffFile parse_bdcff_sections(const char *file_contents) {
                     gd_critical("[highscore] section only allowed inside [game] and [cave]. This confuses the parser, bailing out!");
                     bailout = true;
                 }
-            } else if (gd_str_ascii_caseequal(line, "[/highscore]")) {
+            } else if (line.caseequal("[/highscore]")) {
                 if (state == GameHighScore)
                     state = Game;
                 else if (state == CaveHighScore)
@@ -540,66 +714,66 @@ static BdcffFile parse_bdcff_sections(const char *file_contents) {
                     gd_critical("[/highscore] only allowed after starting [highscore]. This confuses the parser, bailing out!");
                     bailout = true;
                 }
-            } else if (gd_str_ascii_caseequal(line, "[objects]")) {
+            } else if (line.caseequal("[objects]")) {
                 if (state != Cave)
                     gd_warning("[objects] tag only allowed in [cave]");
                 if (file.caves.empty()) {
                     gd_warning("[replay] tag does not belong to any cave!");
-                    file.caves.push_back(BdcffFile::CaveInfo());
+                    file.caves.push_back(BdcffLoadedFile::CaveInfo());
                 }
                 state = CaveObjects;
-            } else if (gd_str_ascii_caseequal(line, "[/objects]")) {
+            } else if (line.caseequal("[/objects]")) {
                 if (state != CaveObjects)
                     gd_warning("[/objects] tag without starting [objects] tag");
                 state = Cave;
-            } else if (gd_str_ascii_caseequal(line, "[demo]")) {
+            } else if (line.caseequal("[demo]")) {
                 if (state != Cave)
                     gd_warning("[demo] tag only allowed in [cave]");
                 if (file.caves.empty()) {
                     gd_warning("[demo] tag does not belong to any cave!");
-                    file.caves.push_back(BdcffFile::CaveInfo());
+                    file.caves.push_back(BdcffLoadedFile::CaveInfo());
                 }
                 state = CaveDemo;
-                file.caves.back().demo.push_back("");   /* push an empty string, lines will be added */
-            } else if (gd_str_ascii_caseequal(line, "[/demo]")) {
+                file.caves.back().demos.push_back(BdcffLines());   /* lines will be added */
+            } else if (line.caseequal("[/demo]")) {
                 if (state != CaveDemo)
                     gd_warning("[/demo] tag without starting [demo] tag");
                 state = Cave;
-            } else if (gd_str_ascii_caseequal(line, "[replay]")) {
+            } else if (line.caseequal("[replay]")) {
                 if (state != Cave)
                     gd_warning("[replay] tag only allowed in [cave]");
                 if (file.caves.empty()) {
                     gd_warning("[replay] tag does not belong to any cave!");
-                    file.caves.push_back(BdcffFile::CaveInfo());
+                    file.caves.push_back(BdcffLoadedFile::CaveInfo());
                 }
                 state = CaveSReplay;
-                file.caves.back().replays.push_back(BdcffSection());
-            } else if (gd_str_ascii_caseequal(line, "[/replay]")) {
+                file.caves.back().replays.push_back(BdcffLines());
+            } else if (line.caseequal("[/replay]")) {
                 if (state != CaveSReplay)
                     gd_warning("[/replay] tag without starting [replay] tag");
                 state = Cave;
             }
             /* GOSH i hate bdcff */
-            else if (gd_str_ascii_prefix(line, "[level=")) {
+            else if (line.caseprefix("[level=")) {
                 /* dump this thing in the object list. */
                 if (state != CaveObjects)
                     gd_message("[level] tag only allowed inside [objects] section. Ignored.");
                 else
                     file.caves.back().objects.push_back(line);
-            } else if (gd_str_ascii_caseequal(line, "[/level]")) {
+            } else if (line.caseequal("[/level]")) {
                 /* dump this thing in the object list. */
                 if (state != CaveObjects)
                     gd_message("[/level] tag only allowed inside [objects] section. Ignored.");
                 else
                     file.caves.back().objects.push_back(line);
             } else
-                gd_warning(CPrintf("unknown section: \"%s\"") % line);
+                gd_warning(CPrintf("unknown section: \"%s\"") % line.str());
 
             continue;
         }
 
         /* OK, processed the section tags. */
-        /* now copy the line to the correct part of the BdcffFile object. */
+        /* now store the line in the correct part of the BdcffLoadedFile object. */
 
         /* first, check if we are at a map line. no stripping of spaces then! */
         if (state == CaveMap) {
@@ -608,13 +782,15 @@ static BdcffFile parse_bdcff_sections(const char *file_contents) {
         }
 
         /* if not a map, we may strip spaces. do it here. */
-        gd_strchomp(line);
+        line.chomp();
 
         switch (state) {
-            case Start: /* should be nothing here. */
-                gd_critical(CPrintf("nothing allowed outside [BDCFF]: %s") % line);
+            case Start: { /* should be nothing here. */
+                SetLoggerContextForFunction scf(SPrintf("Line %d") % lineno);
+                gd_critical(CPrintf("nothing allowed outside [BDCFF]: %s") % line.str());
                 bailout = true;
                 break;
+            }
 
             case Bdcff: /* inside [bdcff], eg. version=0.5 */
                 file.bdcff.push_back(line);
@@ -643,7 +819,7 @@ static BdcffFile parse_bdcff_sections(const char *file_contents) {
 
             case CaveDemo:      /* old styled demo (replay), just movements, no random data & the like */
                 /* does not contain anything to check for! */
-                file.caves.back().demo.back() += line + ' ';
+                file.caves.back().demos.back().push_back(line);
                 break;
 
             case CaveHighScore: /* highscores for a cave */
@@ -667,19 +843,227 @@ static BdcffFile parse_bdcff_sections(const char *file_contents) {
     return file;
 }
 
-CaveSet load_from_bdcff(const char *contents) {
-    // this may throw, but we do not catch
-    BdcffFile file = parse_bdcff_sections(contents);
 
-    /* this cave will store the default properties, specified in the [game] section for caves. */
-    /* especially the pain-in-the-ass engine tag. */
-    CaveStored default_cave;
+/// Creates the caves of a BDCFF file from the lines of their sections.
+/// For lazy loading, it keeps a copy of the file contents, as the lines point into it.
+class BdcffCaveSource : public LazyCaveSource {
+public:
+    BdcffCaveSource();
+    char const *copy_contents(char const *contents, size_t length);
+    virtual CaveStored *create_cave(unsigned i) const;
+    virtual bool cave_has_levels(unsigned i) const;
 
+    BdcffLoadedFile file;
+    /// This cave stores the default properties, specified in the [game] section for caves.
+    CaveStored default_cave;
     CharToElementTable ctet;
+    /// Set for files without a version, see create_cave().
+    bool intermission_hack;
+
+private:
+    std::string contents;
+};
+
+
+BdcffCaveSource::BdcffCaveSource()
+    :   intermission_hack(false) {
+}
+
+
+/// Store a copy of the file contents, so the caves can be created after
+/// the buffer of the caller is freed. A mapped file is not kept instead, as
+/// the file could be modified or truncated by another program meanwhile.
+/// @return The copy, which is to be split into sections.
+char const *BdcffCaveSource::copy_contents(char const *contents, size_t length) {
+    this->contents.assign(contents, length);
+    return this->contents.data();
+}
+
+
+/// Create a cave from its sections: the properties, highscores, map, objects and replays.
+CaveStored *BdcffCaveSource::create_cave(unsigned i) const {
+    BdcffLoadedFile::CaveInfo const &info = file.caves.at(i);
+    std::auto_ptr<CaveStored> pcave(new CaveStored(default_cave));
+    CaveStored &cave = *pcave;          /* use it as a reference, too */
+
+    /* the tags are removed from the list when processed, so work on a copy */
+    BdcffLines properties(info.properties);
+    cave_process_all_tags(cave, properties);
+
+    /* process cave highscore. if not using bdcff highscore, simply ignore. */
+    if (gd_use_bdcff_highscore) {
+        for (BdcffLines::const_iterator hit = info.highscore.begin(); hit != info.highscore.end(); ++hit) {
+            /* stored as <score> <space> <name> */
+            try {
+                AttribParam ap(*hit, ' ');
+                if (!add_highscore(cave.highscore, ap.param, ap.attrib))
+                    gd_message(CPrintf("Invalid highscore: '%s'") % hit->str());
+            } catch (std::exception &e) {
+                gd_message(CPrintf("Invalid highscore line: '%s'") % hit->str());
+            }
+        }
+    }
+
+    /* at the end, when read all tags (especially the size= tag) */
+    /* process map, if any. */
+    /* only report if map read is bigger than size= specified. */
+    /* some old bdcff files use smaller intermissions than the one specified. */
+    if (!info.map.empty()) {
+        /* yes, we have a map. */
+        /* create map and fill with initial border, in case that map strings are shorter or somewhat */
+        cave.map.set_size(cave.w, cave.h, cave.initial_border);
+
+        if (int(info.map.size()) != cave.height())
+            gd_warning(CPrintf("map error: cave height=%d (%d visible), map height=%u") % cave.height() % (cave.y2 - cave.y1 + 1) % info.map.size());
+
+        BdcffLines::const_iterator mit;  /* to iterate through map lines */
+        int y;
+        for (y = 0, mit = info.map.begin(); y < cave.h && mit != info.map.end(); ++mit, ++y) {
+            int linelen = mit->length;
+
+            for (int x = 0; x < std::min(linelen, signed(cave.w)); x++)
+                cave.map(x, y) = ctet.get((*mit)[x]);
+        }
+    }
+
+    /* process cave objects */
+    GdBoolLevels levels;
+    for (unsigned n = 0; n < 5; ++n)
+        levels[n] = true;
+    for (BdcffLines::const_iterator oit = info.objects.begin(); oit != info.objects.end(); ++oit) {
+        // process [levels] tags for objects, or process objects.
+        // [level] tags are badly designed in bdcff, as they are
+        // not really "sections", but properties of objects.
+        // yet, they are stored in sections. huge fail.
+        if (oit->caseequal("[/Level]")) {
+            for (unsigned n = 0; n < 5; ++n)
+                levels[n] = true;
+        } else if (oit->caseprefix("[Level=")) {
+            std::istringstream is(oit->str().substr(7));
+            for (unsigned n = 0; n < 5; ++n)
+                levels[n] = false;
+            int i;
+            while (is >> i) {
+                if (i - 1 >= 0 && i - 1 < 5)
+                    levels[i - 1] = true;
+                else {
+                    gd_warning(CPrintf("Invalid [Levels=xxx] specification"));
+                    for (unsigned n = 0; n < 5; ++n)
+                        levels[n] = true;
+                    break;
+                }
+                char c;
+                is >> c; // read comma
+            }
+        } else {
+            CaveObject *newobj = CaveObject::create_from_bdcff(oit->str());
+            if (newobj) {
+                for (unsigned n = 0; n < 5; ++n)
+                    newobj->seen_on[n] = levels[n];
+                cave.objects.push_back_adopt(newobj);
+            } else
+                gd_warning(CPrintf("invalid object specification: %s") % oit->str());
+        }
+    }
+
+    /* process replays */
+    for (std::list<BdcffLines>::const_iterator rit = info.replays.begin(); rit != info.replays.end(); ++rit) {
+        cave.replays.push_back(CaveReplay());       /* push an empty replay */
+        CaveReplay &replay = cave.replays.back(); /* and work on that object */
+
+        replay.saved = true; /* set "saved" flag, so this replay will be written when the caveset is saved again */
+        /* and process its contents */
+        for (BdcffLines::const_iterator lines_it = rit->begin(); lines_it != rit->end(); ++lines_it) {
+            if (lines_it->contains('=')) {
+                AttribParam ap(*lines_it);
+                replay_process_tag(replay, ap.attrib, ap.param);
+            } else
+                replay_process_tag(replay, "Movements", lines_it->str()); /* try to interpret it as a bdcff replay */
+        }
+    }
+
+    /* process demos */
+    for (std::list<BdcffLines>::const_iterator dit = info.demos.begin(); dit != info.demos.end(); ++dit) {
+        cave.replays.push_back(CaveReplay());       /* push an empty replay */
+        CaveReplay &replay = cave.replays.back(); /* and work on that object */
+
+        replay.saved = true; /* set "saved" flag, so this replay will be written when the caveset is saved again */
+        replay.player_name = "???";
+        std::string movements;
+        for (BdcffLines::const_iterator lines_it = dit->begin(); lines_it != dit->end(); ++lines_it) {
+            movements.append(lines_it->text, lines_it->length);
+            movements += ' ';
+        }
+        replay_process_tag(replay, "Movements", movements);  /* try to interpret it as a bdcff replay */
+    }
+
+    /* old bdcff files hack. explanation follows. */
+    /* there were 40x22 caves in c64 bd, intermissions were also 40x22, but the visible */
+    /* part was the upper left corner, 20x12. 40x22 caves are needed, as 20x12 caves would */
+    /* look different (random cave elements needs the correct size.) */
+    /* also, in older bdcff files, there is no size= tag. caves default to 40x22 and 20x12. */
+    /* even the explicit drawrect and other drawing instructions, which did set up intermissions */
+    /* to be 20x12, are deleted. very very bad decision. */
+    /* here we try to detect and correct this. */
+    /* only applies to intermissions */
+    /* not applied to mapped caves, as maps are filled with initial border, if the map read is smaller */
+    if (intermission_hack && cave.intermission && cave.map.empty()) {
+        /* we do not set the cave to 20x12, rather to 40x22 with 20x12 visible. */
+        cave.w = 40;
+        cave.h = 22;
+        cave.x1 = 0;
+        cave.y1 = 0;
+        cave.x2 = 19;
+        cave.y2 = 11;
+
+        /* and cover the invisible area */
+        cave.objects.push_back_adopt(new CaveFillRect(Coordinate(0, 11), Coordinate(39, 21), cave.initial_border, cave.initial_border));
+        cave.objects.push_back_adopt(new CaveFillRect(Coordinate(19, 0), Coordinate(39, 21), cave.initial_border, cave.initial_border));
+    }
+
+    // check for replays which are problematic
+    gd_cave_check_replays(cave, true, false, false);
+
+    return pcave.release();
+}
+
+
+/// Only the properties are needed to know if a cave has levels, so
+/// the objects, the map and the replays are not processed for this.
+bool BdcffCaveSource::cave_has_levels(unsigned i) const {
+    /* messages are reported when the cave is really created */
+    Logger ignore_messages(true);
+    CaveStored cave(default_cave);
+    BdcffLines properties(file.caves.at(i).properties);
+    cave_process_all_tags(cave, properties);
+    return cave.has_levels();
+}
+
+
+/// Load a caveset from the contents of a BDCFF file.
+/// @param contents The contents of the file; not necessarily terminated by a zero.
+/// @param length The length of the contents.
+/// @param lazy If true, only the caveset properties are processed here;
+///     the caves are created from the lines of their sections when first accessed.
+///     The contents are copied, so the buffer can be freed after this.
+CaveSet load_from_bdcff(const char *contents, size_t length, bool lazy) {
+    TraceSpan span("load_from_bdcff", "io");
+
+    SmartPtr<BdcffCaveSource> source(new BdcffCaveSource);
+    if (lazy)
+        contents = source->copy_contents(contents, length);
+    // this may throw, but we do not catch
+    source->file = parse_bdcff_sections(contents, length);
+    BdcffLoadedFile const &file = source->file;
+
+    /* the default cave stores the default properties, specified in the [game] section for caves. */
+    /* especially the pain-in-the-ass engine tag. */
+    CaveStored &default_cave = source->default_cave;
+    CharToElementTable &ctet = source->ctet;
     std::string version_read = "0.32";  /* assume version to be 0.32, also when the file does not specify it explicitly */
 
     /* PROCESS BDCFF PROPERTIES */
-    for (BdcffSectionConstIterator it = file.bdcff.begin(); it != file.bdcff.end(); ++it) {
+    for (BdcffLines::const_iterator it = file.bdcff.begin(); it != file.bdcff.end(); ++it) {
         AttribParam ap(*it);
 
         if (gd_str_ascii_caseequal(ap.attrib, "Version"))
@@ -695,7 +1079,7 @@ CaveSet load_from_bdcff(const char *contents) {
     CaveSet cs;
 
     /* PROCESS CAVESET PROPERTIES */
-    for (BdcffSectionConstIterator it = file.caveset_properties.begin(); it != file.caveset_properties.end(); ++it) {
+    for (BdcffLines::const_iterator it = file.caveset_properties.begin(); it != file.caveset_properties.end(); ++it) {
         AttribParam ap(*it);
 
         if (gd_str_ascii_caseequal(ap.attrib, "Caves"))
@@ -713,7 +1097,7 @@ CaveSet load_from_bdcff(const char *contents) {
 
 
     /* PROCESS CAVESET PROPERTIES */
-    for (BdcffSectionConstIterator it = file.caveset_properties.begin(); it != file.caveset_properties.end(); ++it) {
+    for (BdcffLines::const_iterator it = file.caveset_properties.begin(); it != file.caveset_properties.end(); ++it) {
         AttribParam ap(*it);
 
         if (gd_str_ascii_caseequal(ap.attrib, "Caves"))
@@ -732,20 +1116,20 @@ CaveSet load_from_bdcff(const char *contents) {
     /* PROCESS CAVESET HIGHSCORE */
     /* if not using bdcff highscore, simply ignore it. */
     if (gd_use_bdcff_highscore) {
-        for (BdcffSectionConstIterator it = file.highscore.begin(); it != file.highscore.end(); ++it) {
+        for (BdcffLines::const_iterator it = file.highscore.begin(); it != file.highscore.end(); ++it) {
             /* stored as <score> <space> <name> */
             try {
                 AttribParam ap(*it, ' ');
                 if (!add_highscore(cs.highscore, ap.param, ap.attrib))
-                    gd_message(CPrintf("Invalid highscore: '%s'") % *it);
+                    gd_message(CPrintf("Invalid highscore: '%s'") % it->str());
             } catch (std::exception &e) {
-                gd_message(CPrintf("Invalid highscore line: '%s'") % *it);
+                gd_message(CPrintf("Invalid highscore line: '%s'") % it->str());
             }
         }
     }
 
     /* PROCESS CAVESET MAPCODES */
-    for (BdcffSectionConstIterator it = file.mapcodes.begin(); it != file.mapcodes.end(); ++it) {
+    for (BdcffLines::const_iterator it = file.mapcodes.begin(); it != file.mapcodes.end(); ++it) {
         AttribParam ap(*it);
 
         if (gd_str_ascii_caseequal(ap.attrib, "Length")) {
@@ -761,156 +1145,26 @@ CaveSet load_from_bdcff(const char *contents) {
     }
 
     /* PROCESS CAVES */
-    /* xxx const iterator cannot be used */
-    for (std::list<BdcffFile::CaveInfo>::iterator it = file.caves.begin(); it != file.caves.end(); ++it) {
-        CaveStored *pcave = new CaveStored(default_cave);
-        CaveStored &cave = *pcave;          /* use it as a reference, too */
-
-        cs.caves.push_back_adopt(pcave);   /* add new cave */
-
-        cave_process_all_tags(cave, it->properties);
-
-        /* process cave highscore. if not using bdcff highscore, simply ignore. */
-        if (gd_use_bdcff_highscore) {
-            for (BdcffSectionConstIterator hit = it->highscore.begin(); hit != it->highscore.end(); ++hit) {
-                /* stored as <score> <space> <name> */
-                try {
-                    AttribParam ap(*hit, ' ');
-                    if (!add_highscore(cave.highscore, ap.param, ap.attrib))
-                        gd_message(CPrintf("Invalid highscore: '%s'") % *hit);
-                } catch (std::exception &e) {
-                    gd_message(CPrintf("Invalid highscore line: '%s'") % *hit);
-                }
-            }
-        }
-
-        /* at the end, when read all tags (especially the size= tag) */
-        /* process map, if any. */
-        /* only report if map read is bigger than size= specified. */
-        /* some old bdcff files use smaller intermissions than the one specified. */
-        if (!it->map.empty()) {
-            /* yes, we have a map. */
-            /* create map and fill with initial border, in case that map strings are shorter or somewhat */
-            cave.map.set_size(cave.w, cave.h, cave.initial_border);
-
-            if (int(it->map.size()) != cave.height())
-                gd_warning(CPrintf("map error: cave height=%d (%d visible), map height=%u") % cave.height() % (cave.y2 - cave.y1 + 1) % it->map.size());
-
-            BdcffSectionConstIterator mit;  /* to iterate through map lines */
-            int y;
-            for (y = 0, mit = it->map.begin(); y < cave.h && mit != it->map.end(); ++mit, ++y) {
-                int linelen = mit->size();
-
-                for (int x = 0; x < std::min(linelen, signed(cave.w)); x++)
-                    cave.map(x, y) = ctet.get((*mit)[x]);
-            }
-        }
-
-        /* process cave objects */
-        GdBoolLevels levels;
-        for (unsigned n = 0; n < 5; ++n)
-            levels[n] = true;
-        for (BdcffSectionConstIterator oit = it->objects.begin(); oit != it->objects.end(); ++oit) {
-            // process [levels] tags for objects, or process objects.
-            // [level] tags are badly designed in bdcff, as they are
-            // not really "sections", but properties of objects.
-            // yet, they are stored in sections. huge fail.
-            if (*oit == "[/Level]") {
-                for (unsigned n = 0; n < 5; ++n)
-                    levels[n] = true;
-            } else if (gd_str_ascii_prefix(*oit, "[Level=")) {
-                std::istringstream is(oit->substr(oit->find('=') + 1));
-                for (unsigned n = 0; n < 5; ++n)
-                    levels[n] = false;
-                int i;
-                while (is >> i) {
-                    if (i - 1 >= 0 && i - 1 < 5)
-                        levels[i - 1] = true;
-                    else {
-                        gd_warning(CPrintf("Invalid [Levels=xxx] specification"));
-                        for (unsigned n = 0; n < 5; ++n)
-                            levels[n] = true;
-                        break;
-                    }
-                    char c;
-                    is >> c; // read comma
-                }
-            } else {
-                CaveObject *newobj = CaveObject::create_from_bdcff(*oit);
-                if (newobj) {
-                    for (unsigned n = 0; n < 5; ++n)
-                        newobj->seen_on[n] = levels[n];
-                    cave.objects.push_back_adopt(newobj);
-                } else
-                    gd_warning(CPrintf("invalid object specification: %s") % *oit);
-            }
-        }
-
-        /* process replays */
-        for (std::list<BdcffSection>::const_iterator rit = it->replays.begin(); rit != it->replays.end(); ++rit) {
-            cave.replays.push_back(CaveReplay());       /* push an empty replay */
-            CaveReplay &replay = cave.replays.back(); /* and work on that object */
-
-            replay.saved = true; /* set "saved" flag, so this replay will be written when the caveset is saved again */
-            /* and process its contents */
-            for (BdcffSectionConstIterator lines_it = rit->begin(); lines_it != rit->end(); ++lines_it) {
-                if (lines_it->find('=') != std::string::npos) {
-                    AttribParam ap(*lines_it);
-                    replay_process_tag(replay, ap.attrib, ap.param);
-                } else
-                    replay_process_tag(replay, "Movements", *lines_it); /* try to interpret it as a bdcff replay */
-            }
-        }
-
-        /* process demos */
-        for (BdcffSectionConstIterator dit = it->demo.begin(); dit != it->demo.end(); ++dit) {
-            cave.replays.push_back(CaveReplay());       /* push an empty replay */
-            CaveReplay &replay = cave.replays.back(); /* and work on that object */
-
-            replay.saved = true; /* set "saved" flag, so this replay will be written when the caveset is saved again */
-            replay.player_name = "???";
-            replay_process_tag(replay, "Movements", *dit);  /* try to interpret it as a bdcff replay */
-        }
-    }
-
-    /* old bdcff files hack. explanation follows. */
-    /* there were 40x22 caves in c64 bd, intermissions were also 40x22, but the visible */
-    /* part was the upper left corner, 20x12. 40x22 caves are needed, as 20x12 caves would */
-    /* look different (random cave elements needs the correct size.) */
-    /* also, in older bdcff files, there is no size= tag. caves default to 40x22 and 20x12. */
-    /* even the explicit drawrect and other drawing instructions, which did set up intermissions */
-    /* to be 20x12, are deleted. very very bad decision. */
-    /* here we try to detect and correct this. */
+    /* there were no version numbers in old bdcff files; see the intermission hack in create_cave(). */
     if (version_read == "0.32") {
         gd_message("No BDCFF version, or 0.32. Using unspecified-intermission-size hack.");
-
-        for (unsigned int i = 0; i < cs.caves.size(); ++i) {
-            CaveStored &cav = cs.cave(i);
-
-            /* only applies to intermissions */
-            /* not applied to mapped caves, as maps are filled with initial border, if the map read is smaller */
-            if (cav.intermission && cav.map.empty()) {
-                /* we do not set the cave to 20x12, rather to 40x22 with 20x12 visible. */
-                cav.w = 40;
-                cav.h = 22;
-                cav.x1 = 0;
-                cav.y1 = 0;
-                cav.x2 = 19;
-                cav.y2 = 11;
-
-                /* and cover the invisible area */
-                cav.objects.push_back_adopt(new CaveFillRect(Coordinate(0, 11), Coordinate(39, 21), cav.initial_border, cav.initial_border));
-                cav.objects.push_back_adopt(new CaveFillRect(Coordinate(19, 0), Coordinate(39, 21), cav.initial_border, cav.initial_border));
-            }
-        }
+        source->intermission_hack = true;
     }
 
     if (version_read != BDCFF_VERSION)
         gd_warning(CPrintf("BDCFF version %s, loaded caveset may have errors.") % version_read);
 
-    // check for replays which are problematic
-    for (unsigned int i = 0; i < cs.caves.size(); ++i)
-        gd_cave_check_replays(cs.cave(i), true, false, false);
+    if (lazy)
+        cs.set_lazy_caves(source, file.caves.size());
+    else {
+        /* the caves are independent of each other, so they are created in parallel */
+        std::vector<unsigned> indices;
+        for (unsigned int i = 0; i < file.caves.size(); ++i)
+            indices.push_back(i);
+        std::vector<CaveStored *> caves = source->create_caves(indices);
+        for (unsigned int i = 0; i < caves.size(); ++i)
+            cs.caves.push_back_adopt(caves[i]);
+    }
 
     // return the created caveset.
     return cs;
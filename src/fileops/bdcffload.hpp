@@ -25,13 +25,14 @@
 
 #include "config.h"
 
+#include <cstddef>
 #include <string>
 
 class CaveSet;
 class Reflective;
 struct PropertyDescription;
 
-CaveSet load_from_bdcff(const char *contents);
+CaveSet load_from_bdcff(const char *contents, size_t length, bool lazy = false);
 
 bool struct_set_property(Reflective &str, const std::string &attrib, const std::string &param, int ratio, PropertyDescription const *prop_desc);
 
@@ -38,24 +38,31 @@
 
 
 /// write highscore to a bdcff file
-static void write_highscore_func(std::list<std::string> &out, HighScoreTable const &scores) {
-    for (unsigned int i = 0; i < scores.size(); i++)
-        out.push_back(BdcffFormat() << scores[i].score << scores[i].name);
+static void write_highscore_func(BdcffWriter &out, HighScoreTable const &scores) {
+    for (unsigned int i = 0; i < scores.size(); i++) {
+        out.start_line("");
+        out << scores[i].score << scores[i].name;
+        out.end_line();
+    }
 }
 
 
 /// Save properties of a reflective object in bdcff format.
 /// Used to save caves, cavesets, replays.
-/// @param out The list of output strings to append to.
+/// @param out The writer to write the lines to.
 /// @param str The reflective object.
 /// @param str_def Another reflective object, which is of the same type. Default values are taken from that,
 ///                 i.e. if a property in str has the same value as in str_def, it is not saved.
 /// @param ratio The cave size, for ratio types. Set to cave->w*cave->h when calling.
+/// @param omit The identifier of a property not to write at all, or NULL.
 /// @todo rename
-void save_properties(std::list<std::string> &out, Reflective &str, Reflective &str_def, int ratio, PropertyDescription const *prop_desc) {
+void save_properties(BdcffWriter &out, Reflective &str, Reflective &str_def, int ratio, PropertyDescription const *prop_desc, char const *omit) {
     bool should_write = false;
+    bool omitted = false;
     const char *identifier = NULL;
-    BdcffFormat line;
+    /* the line of the current identifier is collected here, as lines of strings may be written meanwhile */
+    std::string pending;
+    BdcffWriter line(pending);
 
     /* for all properties */
     for (unsigned i = 0; prop_desc[i].identifier != NULL; i++) {
@@ -70,21 +77,21 @@ void save_properties(std::list<std::string> &out, Reflective &str, Reflective &s
         // if it is a string, write as one line. do not even write identifier if no string, as default is empty.
         if (prop_desc[i].type == GD_TYPE_STRING) {
             if (str.get<GdString>(prop) != "")
-                out.push_back(BdcffFormat(prop_desc[i].identifier) << str.get<GdString>(prop));
+                out.line(BdcffFormat(prop_desc[i].identifier) << str.get<GdString>(prop));
             continue;
         }
         // long string - also as one line. escape newlines.
         if (prop_desc[i].type == GD_TYPE_LONGSTRING) {
             if (str.get<GdString>(prop) != "") {
                 AutoGFreePtr<char> escaped(g_strescape(str.get<GdString>(prop).c_str(), NULL));
-                out.push_back(BdcffFormat(prop_desc[i].identifier) << escaped);
+                out.line(BdcffFormat(prop_desc[i].identifier) << (char const *) escaped);
             }
             continue;
         }
         // effects are also stored in a different fashion.
         if (prop_desc[i].type == GD_TYPE_EFFECT) {
             if (str.get<GdElement>(prop) != str_def.get<GdElement>(prop))
-                out.push_back(BdcffFormat("Effect") << prop_desc[i].identifier << str.get<GdElement>(prop));
+                out.line(BdcffFormat("Effect") << prop_desc[i].identifier << str.get<GdElement>(prop));
             continue;
         }
 
@@ -94,15 +101,21 @@ void save_properties(std::list<std::string> &out, Reflective &str, Reflective &s
         if (!identifier || strcmp(prop_desc[i].identifier, identifier) != 0) {
             // write lines only which carry information other than the default settings
             if (should_write)
-                out.push_back(line);
+                out.line(pending);
 
-            line.start_new(prop_desc[i].identifier);
+            pending.clear();
+            line.start_line(prop_desc[i].identifier);
             should_write = false;
+            omitted = omit != NULL && g_ascii_strcasecmp(prop_desc[i].identifier, omit) == 0;
 
             // remember identifier
             identifier = prop_desc[i].identifier;
         }
 
+        // the omitted property is never written
+        if (omitted)
+            continue;
+
         // if we always save this identifier, remember now
         if (prop_desc[i].flags & GD_ALWAYS_SAVE)
             should_write = true;
@@ -175,64 +188,49 @@ void save_properties(std::list<std::string> &out, Reflective &str, Reflective &s
     }
     /* write remaining data */
     if (should_write)
-        out.push_back(line);
-}
-
-
-static void save_own_properties(std::list<std::string> &out, Reflective &str, Reflective &str_def, int ratio) {
-    save_properties(out, str, str_def, ratio, str.get_description_array());
+        out.line(pending);
 }
 
 
-/* remove a line from the list of strings. */
-/* the prefix should be a property; add an equal sign! so properties which have names like
-   "slime" and "slimeproperties" won't match each other. */
-static void cave_properties_remove(std::list<std::string> &out, const char *attrib) {
-    out.remove_if(HasAttrib(attrib));
+static void save_own_properties(BdcffWriter &out, Reflective &str, Reflective &str_def, int ratio, char const *omit = NULL) {
+    save_properties(out, str, str_def, ratio, str.get_description_array(), omit);
 }
 
 
-static BdcffSection save_replay_func(CaveReplay &replay) {
-    BdcffSection out;
+static void save_replay_func(BdcffWriter &out, CaveReplay &replay) {
     CaveReplay default_values;                          // an empty replay to store default values
+    out.line("");
+    out.line("[replay]");
     save_own_properties(out, replay, default_values, 0);    // 0 is for ratio, here it is not used
-    out.push_back(BdcffFormat("Movements") << replay.movements_to_bdcff());
-
-    return out;
+    out.start_line("Movements");
+    out << replay.movements_to_bdcff();
+    out.end_line();
+    out.line("[/replay]");
 }
 
 
-/// Output properties of a CaveStored to a BdcffFile::CaveInfo structure.
-/// Saves everything; properties, map, objects.
-static BdcffFile::CaveInfo caveset_save_cave_func(CaveStored &cave) {
-    BdcffFile::CaveInfo out;
-
-    write_highscore_func(out.highscore, cave.highscore);
-
-    // first add the properties to the list.
-    // later, some are deleted (slime permeability, for example) - this is needed because of the inconsistencies of the bdcff.
-    CaveStored default_values;
-    save_own_properties(out.properties, cave, default_values, cave.w * cave.h);
-
-    // here come properties which are handled explicitly. these cannot be handled easily above,
-    // as they have some special meaning. for example, slime_permeability=x sets permeability to
-    // x, and sets predictable to false. bdcff format is simply inconsistent in these aspects.
+/// Write a cave to the bdcff file: its properties, map, objects, highscores and replays.
+static void caveset_save_cave_func(BdcffWriter &out, CaveStored &cave) {
+    out.line("");
+    out.line("[cave]");
 
+    // the properties are written first.
     // slime permeability is always set explicitly, as it also sets predictability.
-    // both have the ALWAYS_SAVE flags, so now they are in the array regardless of their values.
-    if (cave.slime_predictable)
-        // if slime is predictable, remove permeab. flag, as that would imply unpredictable slime.
-        cave_properties_remove(out.properties, "SlimePermeability");
-    else
-        // if slime is UNpredictable, remove permeabc64 flag, as that would imply predictable slime.
-        cave_properties_remove(out.properties, "SlimePermeabilityC64");
+    // both have the ALWAYS_SAVE flags, so they would be written regardless of their values;
+    // but only one of them is needed, because of the inconsistencies of the bdcff.
+    // if slime is predictable, omit permeab. flag, as that would imply unpredictable slime.
+    // if slime is UNpredictable, omit permeabc64 flag, as that would imply predictable slime.
+    CaveStored default_values;
+    save_own_properties(out, cave, default_values, cave.w * cave.h, cave.slime_predictable ? "SlimePermeability" : "SlimePermeabilityC64");
 
     // save unknown tags as they are. somewhat hackish - writes a string with multi-lines.
     if (cave.unknown_tags != "")
-        out.properties.push_back(cave.unknown_tags);
+        out.line(cave.unknown_tags);
 
     // is cave has a map
     if (!cave.map.empty()) {
+        out.line("");
+        out.line("[map]");
         std::string line(cave.w, ' ');      // creates a string of length w filled with ' '
         // save map
         for (int y = 0; y < cave.h; ++y) {
@@ -242,68 +240,61 @@ static BdcffFile::CaveInfo caveset_save_cave_func(CaveStored &cave) {
                 g_assert(gd_element_properties[cave.map(x, y)].character_new != 0);
                 line[x] = gd_element_properties[cave.map(x, y)].character_new;
             }
-            out.map.push_back(line);
+            out.line(line);
         }
+        out.line("[/map]");
     }
 
     // save drawing objects
-    for (CaveObjectStore::const_iterator it = cave.objects.begin(); it != cave.objects.end(); ++it) {
-        CaveObject const *object = *it;  /* eh */
-
-        // not for all levels?
-        if (!object->is_seen_on_all()) {
-            std::string line = "[Level=";
-            bool once = false;  // will be true if already written one number
-            for (int i = 0; i < 5; i++) {
-                if (object->seen_on[i]) {
-                    if (once)   // if written at least one number so far, we need a comma
-                        line += ',';
-                    line += char('1' + i); // level number, ascii character 1, 2, 3, 4 or 5
-                    once = true;
+    if (!cave.objects.empty()) {
+        out.line("");
+        out.line("[objects]");
+        for (CaveObjectStore::const_iterator it = cave.objects.begin(); it != cave.objects.end(); ++it) {
+            CaveObject const *object = *it;  /* eh */
+
+            // not for all levels?
+            if (!object->is_seen_on_all()) {
+                std::string line = "[Level=";
+                bool once = false;  // will be true if already written one number
+                for (int i = 0; i < 5; i++) {
+                    if (object->seen_on[i]) {
+                        if (once)   // if written at least one number so far, we need a comma
+                            line += ',';
+                        line += char('1' + i); // level number, ascii character 1, 2, 3, 4 or 5
+                        once = true;
+                    }
                 }
+                line += ']';
+                out.line(line);
             }
-            line += ']';
-            out.objects.push_back(line);
+            out.line(object->get_bdcff());
+            // again, not for all? then save closing tag, too
+            if (!object->is_seen_on_all())
+                out.line("[/Level]");
         }
-        out.objects.push_back(object->get_bdcff());
-        // again, not for all? then save closing tag, too
-        if (!object->is_seen_on_all())
-            out.objects.push_back("[/Level]");
+        out.line("[/objects]");
+    }
 
+    if (cave.highscore.size() > 0) {
+        out.line("");
+        out.line("[highscore]");
+        write_highscore_func(out, cave.highscore);
+        out.line("[/highscore]");
     }
 
-    // save replays
+    // save replays; each replay has its own group
     for (std::list<CaveReplay>::iterator r_it = cave.replays.begin(); r_it != cave.replays.end(); ++r_it)
         if (r_it->saved)
-            out.replays.push_back(save_replay_func(*r_it));
-
-    return out;
-}
-
+            save_replay_func(out, *r_it);
 
-/// Add a group of properties to a bdcff file.
-/// A new line is started, then the group name is written like [group].
-/// Then the properties, and the closing [/group].
-/// Only creates group, if it won't be empty.
-/// @param name The name of the group in te bdcff file.
-/// @param in The list of properties to save to the file. Will be cleared after this.
-/// @param out The list of strings, which will be the bdcff file. Writes to this list.
-static void add_group(std::string name, std::list<std::string> &in, std::list<std::string> &out) {
-    if (!in.empty()) {
-        out.push_back("");
-        out.push_back("[" + name + "]");
-        // Move all lines from the list 'in' to the end of list 'out'
-        out.splice(out.end(), in);
-        out.push_back("[/" + name + "]");
-    }
+    out.line("[/cave]");
 }
 
-/// Save caveset in BDCFF format to a list of strings.
-void save_to_bdcff(CaveSet &caveset, std::list<std::string> &out) {
 
-    BdcffFile outfile;
-
-    outfile.bdcff.push_back(BdcffFormat("Version") << BDCFF_VERSION);
+/// Save caveset in BDCFF format.
+/// The lines of the file are appended to the string, each terminated by a newline.
+void save_to_bdcff(CaveSet &caveset, std::string &output) {
+    BdcffWriter out(output);
 
     /* check if we need an own mapcode table ------ */
     /* copy original characters to character_new fields; new elements will be added to that one */
@@ -312,6 +303,7 @@ void save_to_bdcff(CaveSet &caveset, std::list<std::string> &out) {
     CharToElementTable ctet;            // create a new table
     for (unsigned int i = 0; i < O_MAX; i++)
         gd_element_properties[i].character_new = gd_element_properties[i].character;
+    caveset.create_all_caves();
     for (unsigned int i = 0; i < caveset.caves.size(); i++) {
         CaveStored &cave = caveset.cave(i);
 
@@ -328,52 +320,48 @@ void save_to_bdcff(CaveSet &caveset, std::list<std::string> &out) {
                 }
         }
     }
+
+    out.line("[BDCFF]");
+    out.start_line("Version");
+    out << BDCFF_VERSION;
+    out.end_line();
+
     // this flag was set above if we need to write mapcodes
     if (write_mapcodes) {
-        outfile.mapcodes.push_back(BdcffFormat("Length") << 1);
+        out.line("");
+        out.line("[mapcodes]");
+        out.start_line("Length");
+        out << 1;
+        out.end_line();
         for (unsigned int i = 0; i < O_MAX; i++) {
             // if no character assigned by specification BUT (AND) we assigned one
-            if (gd_element_properties[i].character == 0 && gd_element_properties[i].character_new != 0)
+            if (gd_element_properties[i].character == 0 && gd_element_properties[i].character_new != 0) {
                 // write something like ".=DIRT".
-                outfile.mapcodes.push_back(BdcffFormat(std::string(1, gd_element_properties[i].character_new)) << gd_element_properties[i].filename);
+                out.line(BdcffFormat(std::string(1, gd_element_properties[i].character_new)) << gd_element_properties[i].filename);
+            }
         }
+        out.line("[/mapcodes]");
     }
 
     // caveset data
-    write_highscore_func(outfile.highscore, caveset.highscore);
+    out.line("");
+    out.line("[game]");
     CaveSet default_caveset;  // temporary object holds default values
-    save_own_properties(outfile.caveset_properties, caveset, default_caveset, 0);
-    outfile.caveset_properties.push_back(BdcffFormat("Levels") << 5);
+    save_own_properties(out, caveset, default_caveset, 0);
+    out.start_line("Levels");
+    out << 5;
+    out.end_line();
+    if (caveset.highscore.size() > 0) {
+        out.line("");
+        out.line("[highscore]");
+        write_highscore_func(out, caveset.highscore);
+        out.line("[/highscore]");
+    }
 
     // caves data
     for (unsigned int i = 0; i < caveset.caves.size(); ++i)
-        outfile.caves.push_back(caveset_save_cave_func(caveset.cave(i)));
-
-    // now convert it to an output file.
-    // move all strings created to the output list of strings in sections.
-    out.push_back("[BDCFF]");
-    out.splice(out.end(), outfile.bdcff);           // bdcff version string
-    add_group("mapcodes", outfile.mapcodes, out);
-
-    out.push_back("");
-    out.push_back("[game]");
-    out.splice(out.end(), outfile.caveset_properties);      // game (caveset) properties)
-    add_group("highscore", outfile.highscore, out);         // game highscores
-
-    // data of caves
-    for (std::list<BdcffFile::CaveInfo>::iterator it = outfile.caves.begin(); it != outfile.caves.end(); ++it) {
-        out.push_back("");
-        out.push_back("[cave]");
-        out.splice(out.end(), it->properties);  // cave properties
-        add_group("map", it->map, out);
-        add_group("objects", it->objects, out);
-        add_group("highscore", it->highscore, out);
-        // each replay has its own group
-        for (std::list<BdcffSection>::iterator rit = it->replays.begin(); rit != it->replays.end(); ++rit)
-            add_group("replay", *rit, out);
-        out.push_back("[/cave]");
-    }
+        caveset_save_cave_func(out, caveset.cave(i));
 
-    out.push_back("[/game]");
-    out.push_back("[/BDCFF]");
+    out.line("[/game]");
+    out.line("[/BDCFF]");
 }
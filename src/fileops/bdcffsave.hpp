@@ -26,14 +26,14 @@
 #include "config.h"
 
 #include <string>
-#include <list>
 
 class CaveSet;
 class Reflective;
+class BdcffWriter;
 struct PropertyDescription;
 
-void save_to_bdcff(CaveSet &caveset, std::list<std::string> &out);
+void save_to_bdcff(CaveSet &caveset, std::string &out);
 
-void save_properties(std::list<std::string> &out, Reflective &str, Reflective &str_def, int ratio, PropertyDescription const *prop_desc);
+void save_properties(BdcffWriter &out, Reflective &str, Reflective &str_def, int ratio, PropertyDescription const *prop_desc, char const *omit = NULL);
 
 #endif
@@ -769,8 +769,10 @@ std::vector<unsigned char> load_memory_dump(unsigned char const *file, size_t le
     };
     std::vector<unsigned char> memory(65536);
 
-    if (memcmp(vicemagic, file, sizeof(vicemagic)) == 0) {
+    if (length >= sizeof(vicemagic) && memcmp(vicemagic, file, sizeof(vicemagic)) == 0) {
         /* FOUND a vice snapshot file. */
+        if (length < 0x80 + 65536)
+            throw std::runtime_error("VICE snapshot file is too short.");
         gd_debug("File is a VICE snapshot.");
         memcpy(&memory[0], file + 0x80, 65536);
         return memory;
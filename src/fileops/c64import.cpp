@@ -31,6 +31,7 @@
 #include "misc/logger.hpp"
 #include "misc/printf.hpp"
 #include "misc/util.hpp"
+#include "misc/trace.hpp"
 #include "cave/elementproperties.hpp"
 #include "cave/object/caveobjectcopypaste.hpp"
 #include "cave/object/caveobjectfillrect.hpp"
@@ -2000,6 +2001,7 @@ C64Import::GdCavefileFormat C64Import::imported_get_format(const guint8 *buf) {
 /// Loads the caveset from a memory buffer.
 /// @return a vector of newly created caves.
 std::vector<CaveStored *> C64Import::caves_import_from_buffer(const guint8 *buf, int length) {
+    TraceSpan span("C64Import::caves_import_from_buffer", "io");
     gboolean numbering;
     int intermissionnum, num;
     int cavelength;
@@ -0,0 +1,674 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fileops/cavesetcache.hpp"
+#include "fileops/mappedfile.hpp"
+#include "fileops/loadfile.hpp"
+#include "cave/caveset.hpp"
+#include "cave/colors.hpp"
+#include "cave/elementproperties.hpp"
+#include "cave/object/caveobject.hpp"
+#include "misc/autogfreeptr.hpp"
+#include "misc/logger.hpp"
+#include "misc/printf.hpp"
+#include "misc/smartptr.hpp"
+#include "misc/trace.hpp"
+#include "misc/util.hpp"
+#include "settings.hpp"
+
+
+/* the cache files are kept in this subdirectory of the config dir. */
+#define CAVESET_CACHE_DIR "cavesetcache"
+/* file format: the header below, then the offset, the length and the flags
+ * of each cave record as 32-bit integers, then the records. the caveset record holds
+ * the caveset properties and highscores; a cave record holds the properties,
+ * highscores, map, objects and replays of a cave. integers are stored in the
+ * byte order of the machine, as the cache is never moved to another one. */
+static char const caveset_cache_magic[4] = { 'G', 'D', 'C', 'V' };
+static guint32 const caveset_cache_version = 4;
+/* flags of the cave records */
+static guint32 const cave_record_has_levels = 1;
+
+struct CavesetCacheHeader {
+    char magic[4];
+    guint32 version;
+    char schema[32];            ///< md5 of the data layout, see cache_schema()
+    char source[32];            ///< md5 of the caveset file contents
+    guint32 source_length;
+    guint32 settings;           ///< settings which change the caveset loaded, see cache_settings()
+    guint32 caveset_offset;
+    guint32 caveset_length;
+    guint32 num_caves;
+    guint32 checksum;           ///< the checksum of the caves, see CaveSet::checksum()
+};
+
+/// An entry of the table of the cave records.
+struct CavesetCacheRecord {
+    guint32 offset;
+    guint32 length;
+    guint32 flags;
+};
+
+
+/// Appends data to the contents of a cache file.
+class CacheWriter {
+private:
+    std::vector<char> &out;
+public:
+    explicit CacheWriter(std::vector<char> &out) : out(out) {}
+    void write_bytes(void const *data, size_t length) {
+        char const *p = static_cast<char const *>(data);
+        out.insert(out.end(), p, p + length);
+    }
+    void write_int(gint32 i) {
+        write_bytes(&i, sizeof(i));
+    }
+    void write_string(std::string const &s) {
+        write_int(s.size());
+        write_bytes(s.data(), s.size());
+    }
+};
+
+
+/// Reads the data of a record of a cache file.
+/// Throws an exception, if trying to read past the end of the record.
+class CacheReader {
+private:
+    char const *pos, *end;
+public:
+    CacheReader(char const *data, size_t length) : pos(data), end(data + length) {}
+    char const *read_bytes(size_t length) {
+        if (size_t(end - pos) < length)
+            throw std::runtime_error("record too short");
+        char const *p = pos;
+        pos += length;
+        return p;
+    }
+    gint32 read_int() {
+        gint32 i;
+        memcpy(&i, read_bytes(sizeof(i)), sizeof(i));
+        return i;
+    }
+    std::string read_string() {
+        gint32 length = read_int();
+        if (length < 0)
+            throw std::runtime_error("invalid string length");
+        return std::string(read_bytes(length), length);
+    }
+    /// Read an enum value, which must be less than count.
+    gint32 read_enum(gint32 count) {
+        gint32 i = read_int();
+        if (i < 0 || i >= count)
+            throw std::runtime_error("invalid enum value");
+        return i;
+    }
+};
+
+
+/* write all properties of a reflective object, in the order of the description array. */
+static void write_properties(CacheWriter &out, Reflective &str, PropertyDescription const *prop_desc) {
+    for (unsigned i = 0; prop_desc[i].identifier != NULL; i++) {
+        std::auto_ptr<GetterBase> const &prop = prop_desc[i].prop;
+
+        switch (prop_desc[i].type) {
+            case GD_TAB:
+            case GD_LABEL:
+                /* used only by the gui, nothing to do */
+                break;
+            case GD_TYPE_STRING:
+            case GD_TYPE_LONGSTRING:
+                out.write_string(str.get<GdString>(prop));
+                break;
+            case GD_TYPE_INT:
+                out.write_int(str.get<GdInt>(prop));
+                break;
+            case GD_TYPE_INT_LEVELS:
+                for (unsigned j = 0; j < prop->count; j++)
+                    out.write_int(str.get<GdIntLevels>(prop)[j]);
+                break;
+            case GD_TYPE_PROBABILITY:
+                out.write_int(str.get<GdProbability>(prop));
+                break;
+            case GD_TYPE_PROBABILITY_LEVELS:
+                for (unsigned j = 0; j < prop->count; j++)
+                    out.write_int(str.get<GdProbabilityLevels>(prop)[j]);
+                break;
+            case GD_TYPE_BOOLEAN:
+                out.write_int(str.get<GdBool>(prop));
+                break;
+            case GD_TYPE_BOOLEAN_LEVELS:
+                for (unsigned j = 0; j < prop->count; j++)
+                    out.write_int(str.get<GdBoolLevels>(prop)[j]);
+                break;
+            case GD_TYPE_COORDINATE:
+                out.write_int(str.get<Coordinate>(prop).x);
+                out.write_int(str.get<Coordinate>(prop).y);
+                break;
+            case GD_TYPE_ELEMENT:
+            case GD_TYPE_EFFECT:
+                out.write_int(str.get<GdElement>(prop));
+                break;
+            case GD_TYPE_COLOR:
+                out.write_bytes(&str.get<GdColor>(prop), sizeof(GdColor));
+                break;
+            case GD_TYPE_DIRECTION:
+                out.write_int(str.get<GdDirection>(prop));
+                break;
+            case GD_TYPE_SCHEDULING:
+                out.write_int(str.get<GdScheduling>(prop));
+                break;
+        }
+    }
+}
+
+
+/* read the properties written by write_properties(). */
+static void read_properties(CacheReader &in, Reflective &str, PropertyDescription const *prop_desc) {
+    for (unsigned i = 0; prop_desc[i].identifier != NULL; i++) {
+        std::auto_ptr<GetterBase> const &prop = prop_desc[i].prop;
+
+        switch (prop_desc[i].type) {
+            case GD_TAB:
+            case GD_LABEL:
+                break;
+            case GD_TYPE_STRING:
+            case GD_TYPE_LONGSTRING:
+                str.get<GdString>(prop) = in.read_string();
+                break;
+            case GD_TYPE_INT:
+                str.get<GdInt>(prop) = in.read_int();
+                break;
+            case GD_TYPE_INT_LEVELS:
+                for (unsigned j = 0; j < prop->count; j++)
+                    str.get<GdIntLevels>(prop)[j] = in.read_int();
+                break;
+            case GD_TYPE_PROBABILITY:
+                str.get<GdProbability>(prop) = in.read_int();
+                break;
+            case GD_TYPE_PROBABILITY_LEVELS:
+                for (unsigned j = 0; j < prop->count; j++)
+                    str.get<GdProbabilityLevels>(prop)[j] = in.read_int();
+                break;
+            case GD_TYPE_BOOLEAN:
+                str.get<GdBool>(prop) = in.read_int() != 0;
+                break;
+            case GD_TYPE_BOOLEAN_LEVELS:
+                for (unsigned j = 0; j < prop->count; j++)
+                    str.get<GdBoolLevels>(prop)[j] = in.read_int() != 0;
+                break;
+            case GD_TYPE_COORDINATE:
+                str.get<Coordinate>(prop).x = in.read_int();
+                str.get<Coordinate>(prop).y = in.read_int();
+                break;
+            case GD_TYPE_ELEMENT:
+            case GD_TYPE_EFFECT:
+                str.get<GdElement>(prop) = GdElementEnum(in.read_enum(O_MAX_INDEX));
+                break;
+            case GD_TYPE_COLOR:
+                memcpy(&str.get<GdColor>(prop), in.read_bytes(sizeof(GdColor)), sizeof(GdColor));
+                break;
+            case GD_TYPE_DIRECTION:
+                str.get<GdDirection>(prop) = GdDirectionEnum(in.read_enum(MV_MAX));
+                break;
+            case GD_TYPE_SCHEDULING:
+                str.get<GdScheduling>(prop) = GdSchedulingEnum(in.read_enum(GD_SCHEDULING_MAX));
+                break;
+        }
+    }
+}
+
+
+static void write_highscore(CacheWriter &out, HighScoreTable const &scores) {
+    out.write_int(scores.size());
+    for (unsigned i = 0; i < scores.size(); i++) {
+        out.write_string(scores[i].name);
+        out.write_int(scores[i].score);
+    }
+}
+
+
+static void read_highscore(CacheReader &in, HighScoreTable &scores) {
+    gint32 count = in.read_int();
+    for (gint32 i = 0; i < count; i++) {
+        std::string name = in.read_string();
+        scores.add(name, in.read_int());
+    }
+}
+
+
+static void write_caveset(CacheWriter &out, CaveSet &caveset) {
+    write_properties(out, caveset, caveset.get_description_array());
+    write_highscore(out, caveset.highscore);
+    out.write_string(caveset.filename);
+    out.write_int(caveset.last_selected_cave);
+    out.write_int(caveset.last_selected_level);
+}
+
+
+static void read_caveset(CacheReader &in, CaveSet &caveset) {
+    read_properties(in, caveset, caveset.get_description_array());
+    read_highscore(in, caveset.highscore);
+    caveset.filename = in.read_string();
+    caveset.last_selected_cave = in.read_int();
+    caveset.last_selected_level = in.read_int();
+}
+
+
+static void write_cave(CacheWriter &out, CaveStored &cave) {
+    write_properties(out, cave, cave.get_description_array());
+    write_properties(out, cave, CaveStored::cave_statistics_data);
+    write_highscore(out, cave.highscore);
+
+    /* the map, if any, with 16 bits per cell */
+    int w = cave.map.width(), h = cave.map.height();
+    out.write_int(w);
+    out.write_int(h);
+    if (!cave.map.empty()) {
+        std::vector<guint16> cells(w * h);
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                cells[y * w + x] = cave.map(x, y);
+        out.write_bytes(&cells[0], cells.size() * sizeof(guint16));
+    }
+
+    /* the objects are stored with their bdcff description */
+    out.write_int(cave.objects.size());
+    for (CaveObjectStore::const_iterator it = cave.objects.begin(); it != cave.objects.end(); ++it) {
+        CaveObject const *object = *it;
+        for (unsigned j = 0; j < G_N_ELEMENTS(object->seen_on); j++)
+            out.write_int(object->seen_on[j]);
+        out.write_string(object->get_bdcff());
+    }
+
+    out.write_int(cave.replays.size());
+    for (std::list<CaveReplay>::iterator it = cave.replays.begin(); it != cave.replays.end(); ++it) {
+        write_properties(out, *it, it->get_description_array());
+        out.write_int(it->saved);
+        out.write_int(it->wrong_checksum);
+        std::vector<unsigned char> const &movements = it->get_raw_movements();
+        out.write_int(movements.size());
+        if (!movements.empty())
+            out.write_bytes(&movements[0], movements.size());
+    }
+}
+
+
+static void read_cave(CacheReader &in, CaveStored &cave) {
+    read_properties(in, cave, cave.get_description_array());
+    read_properties(in, cave, CaveStored::cave_statistics_data);
+    read_highscore(in, cave.highscore);
+
+    int w = in.read_int(), h = in.read_int();
+    if (w < 0 || h < 0)
+        throw std::runtime_error("invalid map size");
+    if (w != 0 && h != 0) {
+        cave.map.set_size(w, h);
+        char const *cells = in.read_bytes(w * h * sizeof(guint16));
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x) {
+                guint16 cell;
+                memcpy(&cell, cells + (y * w + x) * sizeof(guint16), sizeof(guint16));
+                if (cell >= O_MAX)
+                    throw std::runtime_error("invalid element in map");
+                cave.map(x, y) = GdElementEnum(cell);
+            }
+    }
+
+    gint32 num_objects = in.read_int();
+    for (gint32 i = 0; i < num_objects; i++) {
+        GdBoolLevels seen_on;
+        for (unsigned j = 0; j < G_N_ELEMENTS(seen_on); j++)
+            seen_on[j] = in.read_int() != 0;
+        CaveObject *object = CaveObject::create_from_bdcff(in.read_string());
+        if (object == NULL)
+            throw std::runtime_error("invalid object");
+        for (unsigned j = 0; j < G_N_ELEMENTS(seen_on); j++)
+            object->seen_on[j] = seen_on[j];
+        cave.push_back_adopt(object);
+    }
+
+    gint32 num_replays = in.read_int();
+    for (gint32 i = 0; i < num_replays; i++) {
+        cave.replays.push_back(CaveReplay());
+        CaveReplay &replay = cave.replays.back();
+        read_properties(in, replay, replay.get_description_array());
+        replay.saved = in.read_int() != 0;
+        replay.wrong_checksum = in.read_int() != 0;
+        gint32 length = in.read_int();
+        if (length < 0)
+            throw std::runtime_error("invalid replay length");
+        replay.set_raw_movements((unsigned char const *) in.read_bytes(length), length);
+    }
+}
+
+
+/* append the layout of the properties to the schema. */
+static void describe_properties(std::string &schema, PropertyDescription const *prop_desc) {
+    for (unsigned i = 0; prop_desc[i].identifier != NULL; i++)
+        if (prop_desc[i].type != GD_TAB && prop_desc[i].type != GD_LABEL)
+            schema += SPrintf("%s:%d:%d;") % prop_desc[i].identifier % int(prop_desc[i].type) % prop_desc[i].prop->count;
+    schema += '\n';
+}
+
+
+/* the md5 hash of everything which determines the layout of the records:
+ * the property descriptions, the element names and the size of the colors.
+ * if a new version of the program changes any of these, old cache files are not used. */
+static std::string cache_schema() {
+    std::string schema;
+    describe_properties(schema, CaveSet().get_description_array());
+    describe_properties(schema, CaveStored().get_description_array());
+    describe_properties(schema, CaveStored::cave_statistics_data);
+    describe_properties(schema, CaveReplay().get_description_array());
+    for (unsigned i = 0; i < O_MAX; i++) {
+        if (gd_element_properties[i].filename != NULL)
+            schema += gd_element_properties[i].filename;
+        schema += ',';
+    }
+    schema += SPrintf("\n%d\n") % int(sizeof(GdColor));
+    return gd_tostring_free(g_compute_checksum_for_string(G_CHECKSUM_MD5, schema.c_str(), -1));
+}
+
+
+/* these settings change the caveset loaded, so a cache file is only valid with the same ones. */
+static guint32 cache_settings() {
+    return (gd_import_as_all_caves_selectable ? 1 : 0) | (gd_use_bdcff_highscore ? 2 : 0);
+}
+
+
+/* the absolute name of a caveset file. */
+static std::string absolute_filename(char const *filename) {
+    if (g_path_is_absolute(filename))
+        return filename;
+    AutoGFreePtr<char> currentdir(g_get_current_dir());
+    return gd_tostring_free(g_build_path(G_DIR_SEPARATOR_S, (char *) currentdir, filename, NULL));
+}
+
+
+/* the name of the cache file of a caveset file. the hash of the absolute file name is used. */
+static std::string cache_filename(char const *filename) {
+    std::string absolute = absolute_filename(filename);
+    AutoGFreePtr<char> hash(g_compute_checksum_for_string(G_CHECKSUM_MD5, absolute.c_str(), -1));
+    AutoGFreePtr<char> fname(g_strdup_printf("%s.cache", (char *) hash));
+    return gd_tostring_free(g_build_path(G_DIR_SEPARATOR_S, gd_user_config_dir.c_str(), CAVESET_CACHE_DIR, (char *) fname, NULL));
+}
+
+
+/// A memory mapped cache file, from which the caves are created when needed.
+class CachedCaveSource : public LazyCaveSource {
+public:
+    CachedCaveSource(MappedFile *file, std::string const &filename, std::string const &source_filename);
+    bool open(unsigned char const *contents, size_t length);
+    CacheReader caveset_record() const {
+        return CacheReader(data + header.caveset_offset, header.caveset_length);
+    }
+    unsigned num_caves() const {
+        return header.num_caves;
+    }
+    unsigned checksum() const {
+        return header.checksum;
+    }
+    virtual CaveStored *create_cave(unsigned i) const;
+    virtual bool cave_has_levels(unsigned i) const;
+
+private:
+    std::auto_ptr<MappedFile> file;
+    std::string filename;
+    std::string source_filename;    ///< The caveset file, to load the caves from if their records are damaged
+    mutable volatile gint damaged;  ///< Set when the first damaged record is found, which is reported only once
+    char const *data;
+    size_t length;
+    CavesetCacheHeader header;
+    std::vector<CavesetCacheRecord> caves;
+
+    CachedCaveSource(const CachedCaveSource &);                // not implemented
+    CachedCaveSource &operator=(const CachedCaveSource &);     // not implemented
+
+    CaveStored *create_cave_from_source(unsigned i) const;
+};
+
+
+CachedCaveSource::CachedCaveSource(MappedFile *file, std::string const &filename, std::string const &source_filename)
+    :   file(file),
+        filename(filename),
+        source_filename(source_filename),
+        damaged(0),
+        data((char const *) file->get_contents()),
+        length(file->get_length()) {
+}
+
+
+/** Check the header of the cache file, and read the table of the cave records.
+ * @return true, if the cache file belongs to the given caveset file contents, and is usable. */
+bool CachedCaveSource::open(unsigned char const *contents, size_t length) {
+    if (this->length < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, caveset_cache_magic, sizeof(caveset_cache_magic)) != 0 || header.version != caveset_cache_version)
+        return false;
+    if (header.source_length != length || header.settings != cache_settings())
+        return false;
+    /* compare the hash of the caveset file contents - this is how we know it is not modified */
+    AutoGFreePtr<char> source(g_compute_checksum_for_data(G_CHECKSUM_MD5, contents, length));
+    if (memcmp(header.source, (char *) source, sizeof(header.source)) != 0)
+        return false;
+    if (memcmp(header.schema, cache_schema().c_str(), sizeof(header.schema)) != 0)
+        return false;
+
+    /* read table, and check if all records are inside the file */
+    if (header.num_caves > (this->length - sizeof(header)) / sizeof(CavesetCacheRecord))
+        return false;
+    if (header.caveset_offset > this->length || header.caveset_length > this->length - header.caveset_offset)
+        return false;
+    caves.resize(header.num_caves);
+    for (unsigned i = 0; i < header.num_caves; ++i) {
+        memcpy(&caves[i], data + sizeof(header) + i * sizeof(CavesetCacheRecord), sizeof(CavesetCacheRecord));
+        if (caves[i].offset > this->length || caves[i].length > this->length - caves[i].offset)
+            return false;
+    }
+    return true;
+}
+
+
+CaveStored *CachedCaveSource::create_cave(unsigned i) const {
+    std::auto_ptr<CaveStored> cave(new CaveStored);
+    try {
+        CacheReader in(data + caves.at(i).offset, caves.at(i).length);
+        read_cave(in, *cave);
+    } catch (std::exception &e) {
+        /* the cache file is deleted, so the caveset file will be loaded the next time.
+         * this time the cave is loaded from the caveset file. */
+        if (g_atomic_int_compare_and_exchange(&damaged, 0, 1)) {
+            gd_critical(CPrintf("Damaged caveset cache file %s: %s") % filename % e.what());
+            g_unlink(filename.c_str());
+        }
+        return create_cave_from_source(i);
+    }
+    return cave.release();
+}
+
+
+/** Load a cave from the caveset file, for which the cache file was made.
+ * The caveset file is loaded again; as the cache file is checked to belong to its
+ * contents, it must be the same as before. This is only needed if a record is damaged,
+ * so the time it takes does not matter. Throws an exception, if the file is modified
+ * since, or cannot be loaded. */
+CaveStored *CachedCaveSource::create_cave_from_source(unsigned i) const {
+    MappedFile source(source_filename.c_str());
+    AutoGFreePtr<char> hash(g_compute_checksum_for_data(G_CHECKSUM_MD5, source.get_contents(), source.get_length()));
+    if (source.get_length() != header.source_length || memcmp(header.source, (char *) hash, sizeof(header.source)) != 0)
+        throw std::runtime_error(SPrintf("Caveset file %s is modified since loading") % source_filename);
+    CaveSet caveset = create_from_buffer(source.get_contents(), source.get_length(), source_filename.c_str());
+    if (i >= caveset.caves.size())
+        throw std::runtime_error(SPrintf("Caveset file %s has no cave %d") % source_filename % (i + 1));
+    return new CaveStored(caveset.cave(i));
+}
+
+
+bool CachedCaveSource::cave_has_levels(unsigned i) const {
+    return (caves.at(i).flags & cave_record_has_levels) != 0;
+}
+
+
+/**
+ * Load a caveset from the cache file of a caveset file.
+ * Only the caveset properties are read; the caves are created when first accessed.
+ * @param filename The name of the caveset file.
+ * @param contents The contents of the caveset file, to check if the cache is up to date.
+ * @param length The length of the contents.
+ * @param caveset The caveset to load to. Only changed if the cache is used.
+ * @return true, if the cache file exists and is up to date, and the caveset was loaded.
+ */
+bool load_caveset_from_cache(char const *filename, unsigned char const *contents, size_t length, CaveSet &caveset) {
+    if (gd_user_config_dir.empty())
+        return false;
+    TraceSpan span("load_caveset_from_cache", "io");
+
+    std::string cache_name = cache_filename(filename);
+    if (!g_file_test(cache_name.c_str(), G_FILE_TEST_IS_REGULAR))
+        return false;
+    SmartPtr<CachedCaveSource> source;
+    try {
+        source = SmartPtr<CachedCaveSource>(new CachedCaveSource(new MappedFile(cache_name.c_str()), cache_name, absolute_filename(filename)));
+    } catch (std::exception &e) {
+        gd_debug(CPrintf("Unable to open caveset cache file %s: %s") % cache_name % e.what());
+        return false;
+    }
+    if (!source->open(contents, length))
+        return false;
+
+    CaveSet loaded;
+    try {
+        CacheReader in = source->caveset_record();
+        read_caveset(in, loaded);
+    } catch (std::exception &e) {
+        gd_debug(CPrintf("Damaged caveset cache file %s: %s") % cache_name % e.what());
+        return false;
+    }
+    loaded.set_lazy_caves(source, source->num_caves());
+    loaded.set_checksum(source->checksum());
+    caveset = loaded;
+    return true;
+}
+
+
+/**
+ * Save a caveset to the cache file of a caveset file.
+ * @param filename The name of the caveset file, which was loaded.
+ * @param source The md5 hash of the contents of the caveset file.
+ * @param length The length of the contents.
+ * @param caveset The caveset loaded from the file.
+ */
+static void save_caveset_to_cache(std::string const &filename, std::string const &source, size_t length, CaveSet &caveset) {
+    TraceSpan span("save_caveset_to_cache", "io");
+
+    CavesetCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, caveset_cache_magic, sizeof(caveset_cache_magic));
+    header.version = caveset_cache_version;
+    memcpy(header.schema, cache_schema().c_str(), sizeof(header.schema));
+    memcpy(header.source, source.c_str(), sizeof(header.source));
+    header.source_length = length;
+    header.settings = cache_settings();
+    header.num_caves = caveset.caves.size();
+    caveset.create_all_caves();
+    /* the caves are all created now; calculating the checksum here saves rendering them
+     * for the highscore file name every time the caveset is loaded. */
+    header.checksum = caveset.checksum();
+
+    /* the header and the table are filled when the records are already written */
+    std::vector<char> out(sizeof(header) + header.num_caves * sizeof(CavesetCacheRecord));
+    CacheWriter writer(out);
+    header.caveset_offset = out.size();
+    write_caveset(writer, caveset);
+    header.caveset_length = out.size() - header.caveset_offset;
+    for (unsigned i = 0; i < header.num_caves; ++i) {
+        CavesetCacheRecord record;
+        CaveStored &cave = caveset.cave(i);
+        record.offset = out.size();
+        write_cave(writer, cave);
+        record.length = out.size() - record.offset;
+        record.flags = cave.has_levels() ? cave_record_has_levels : 0;
+        memcpy(&out[sizeof(header) + i * sizeof(record)], &record, sizeof(record));
+    }
+    memcpy(&out[0], &header, sizeof(header));
+
+    AutoGFreePtr<char> dir(g_build_path(G_DIR_SEPARATOR_S, gd_user_config_dir.c_str(), CAVESET_CACHE_DIR, NULL));
+    g_mkdir_with_parents(dir, 0700);
+    GError *error = NULL;
+    if (!g_file_set_contents(cache_filename(filename.c_str()).c_str(), &out[0], out.size(), &error)) {
+        gd_debug(CPrintf("Unable to save caveset cache: %s") % error->message);
+        g_error_free(error);
+    }
+}
+
+
+/// Saves the cache file of a caveset file, when the caves are first needed.
+class PendingCacheSave : public PendingLoad {
+public:
+    PendingCacheSave(char const *filename, unsigned char const *contents, size_t length)
+        :   filename(filename),
+            source(gd_tostring_free(g_compute_checksum_for_data(G_CHECKSUM_MD5, contents, length))),
+            length(length) {
+    }
+    virtual void finish(CaveSet &caveset) {
+        /* an edited caveset is not the one loaded from the file anymore */
+        if (caveset.edited)
+            return;
+        try {
+            save_caveset_to_cache(filename, source, length, caveset);
+        } catch (std::exception &e) {
+            gd_debug(CPrintf("Unable to save caveset cache: %s") % e.what());
+        }
+    }
+
+private:
+    std::string filename;
+    std::string source;     ///< The md5 hash of the contents of the caveset file
+    size_t length;
+};
+
+
+/**
+ * Save a caveset to the cache file of a caveset file, when its caves are first needed.
+ * Saving the cache creates all caves, so it is left to CaveSet::finish_loading().
+ * @param filename The name of the caveset file, which was loaded.
+ * @param contents The contents of the caveset file. Only its hash is kept.
+ * @param length The length of the contents.
+ * @param caveset The caveset loaded from the file.
+ */
+void save_caveset_to_cache_later(char const *filename, unsigned char const *contents, size_t length, CaveSet &caveset) {
+    if (gd_user_config_dir.empty())
+        return;
+    caveset.add_pending_load(SmartPtr<PendingLoad>(new PendingCacheSave(filename, contents, length)));
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef CAVESETCACHE_HPP_INCLUDED
+#define CAVESETCACHE_HPP_INCLUDED
+
+#include "config.h"
+
+#include <cstddef>
+
+class CaveSet;
+
+/// @file fileops/cavesetcache.hpp
+/// A binary cache of loaded cavesets.
+///
+/// After a caveset file is loaded, the fully loaded caveset (caves, objects,
+/// replays and highscores) is saved in a binary format to the configuration
+/// directory. As this creates all caves, it is done only when they are first
+/// needed; see CaveSet::finish_loading(). The cache file is identified by the name of the caveset file, and
+/// it remembers the hash of the file contents; so if the file is modified, the
+/// cache is not used. The caveset file is always the source of truth.
+///
+/// The cache file is memory mapped when loading, and only the caveset data is
+/// read at once. The caves are created when they are first accessed; see
+/// LazyCaveSource.
+
+bool load_caveset_from_cache(char const *filename, unsigned char const *contents, size_t length, CaveSet &caveset);
+void save_caveset_to_cache_later(char const *filename, unsigned char const *contents, size_t length, CaveSet &caveset);
+
+#endif
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "fileops/cavesetcatalog.hpp"
+#include "fileops/loadfile.hpp"
+#include "fileops/mappedfile.hpp"
+#include "cave/caveset.hpp"
+#include "cave/caverendered.hpp"
+#include "cave/elementproperties.hpp"
+#include "misc/autogfreeptr.hpp"
+#include "misc/logger.hpp"
+#include "misc/printf.hpp"
+#include "misc/util.hpp"
+#include "settings.hpp"
+
+
+#define CATALOG_INI_FILE "cavesetcatalog.ini"
+#define CATALOG_GROUP "Catalog"
+/* increment this if the meaning of the entries changes */
+static int const catalog_version = 1;
+
+
+CavesetCatalogEntry::CavesetCatalogEntry()
+    :   mtime(0),
+        size(0),
+        loadable(false),
+        num_caves(0),
+        thumbnail_width(0),
+        thumbnail_height(0) {
+    for (unsigned i = 0; i < ThumbnailColors; ++i)
+        colors[i] = 0;
+}
+
+
+/// Get the modification time and the size of a file.
+/// @return false, if the file does not exist or is not a regular file.
+bool CavesetCatalogEntry::stat_file(char const *path, gint64 &mtime, gint64 &size) {
+    struct stat st;
+    if (g_stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+        return false;
+    mtime = st.st_mtime;
+    size = st.st_size;
+    return true;
+}
+
+
+/* the color of an element in the thumbnail: the index of one of the c64 colors. */
+static char thumbnail_color(GdElementEnum e) {
+    if (e == O_SPACE)
+        return '0';
+    if (e == O_AMOEBA || e == O_AMOEBA_2)
+        return '4';
+    if (e == O_SLIME)
+        return '5';
+    if (gd_element_properties[e].flags & P_DIRT)
+        return '1';
+    if (gd_element_properties[e].flags & P_NON_EXPLODABLE)     /* steel walls */
+        return '3';
+    return '2';
+}
+
+
+/**
+ * Create the catalog entry of a file, by loading it.
+ * This may be called on a worker thread.
+ * @param path The name of the file.
+ * @return The entry. If the file could not be loaded, the loadable flag is false.
+ */
+CavesetCatalogEntry CavesetCatalogEntry::create(char const *path) {
+    CavesetCatalogEntry entry;
+    /* stat first; if the file is modified while loading, the entry will be outdated, and created again */
+    if (!stat_file(path, entry.mtime, entry.size))
+        return entry;
+
+    /* messages are not interesting here; they are shown when the file is really loaded */
+    Logger ignore_messages(true);
+    try {
+        /* not loaded through the caveset cache; there is no need to save a cache file for every file browsed */
+        MappedFile file(path);
+        CaveSet caveset = create_from_buffer(file.get_contents(), file.get_length(), path);
+        entry.name = caveset.name;
+        entry.author = caveset.author;
+        entry.num_caves = caveset.caves.size();
+        if (caveset.has_caves()) {
+            CaveRendered rendered(caveset.cave(0), 0, 0);
+            GdColor const colors[ThumbnailColors] = { rendered.color0, rendered.color1, rendered.color2, rendered.color3, rendered.color4, rendered.color5 };
+            for (unsigned i = 0; i < ThumbnailColors; ++i)
+                entry.colors[i] = colors[i].get_uint_0rgb();
+
+            /* the visible part of the cave, shrunk if too big */
+            int w = rendered.x2 - rendered.x1 + 1, h = rendered.y2 - rendered.y1 + 1;
+            int step = std::max((w + ThumbnailMaxWidth - 1) / ThumbnailMaxWidth, (h + ThumbnailMaxHeight - 1) / ThumbnailMaxHeight);
+            step = std::max(step, 1);
+            entry.thumbnail_width = w / step;
+            entry.thumbnail_height = h / step;
+            for (unsigned y = 0; y < entry.thumbnail_height; ++y)
+                for (unsigned x = 0; x < entry.thumbnail_width; ++x)
+                    entry.thumbnail += thumbnail_color(rendered.map(rendered.x1 + x * step, rendered.y1 + y * step));
+        }
+        entry.loadable = true;
+    } catch (std::exception &e) {
+        /* not loadable */
+    }
+    return entry;
+}
+
+
+CavesetCatalog::CavesetCatalog()
+    :   modified(false) {
+}
+
+
+static std::string catalog_filename() {
+    return gd_tostring_free(g_build_path(G_DIR_SEPARATOR_S, gd_user_config_dir.c_str(), CATALOG_INI_FILE, NULL));
+}
+
+
+/* get a string from the key file, or an empty string */
+static std::string keyfile_get_string(GKeyFile *keyfile, const char *group, const char *key) {
+    AutoGFreePtr<char> result(g_key_file_get_string(keyfile, group, key, NULL));
+    return result != NULL ? std::string(result) : std::string();
+}
+
+
+/// Load the catalog from the configuration directory.
+/// Invalid entries are skipped; if the file is of an other version, the catalog is left empty.
+void CavesetCatalog::load() {
+    entries.clear();
+    modified = false;
+    if (gd_user_config_dir.empty())
+        return;
+
+    GKeyFile *ini = g_key_file_new();
+    if (!g_key_file_load_from_file(ini, catalog_filename().c_str(), G_KEY_FILE_NONE, NULL)
+            || g_key_file_get_integer(ini, CATALOG_GROUP, "Version", NULL) != catalog_version) {
+        g_key_file_free(ini);
+        return;
+    }
+
+    char **groups = g_key_file_get_groups(ini, NULL);
+    for (unsigned i = 0; groups[i] != NULL; ++i) {
+        char const *group = groups[i];
+        std::string path = keyfile_get_string(ini, group, "Path");
+        if (path.empty())
+            continue;
+
+        CavesetCatalogEntry entry;
+        entry.mtime = g_ascii_strtoll(keyfile_get_string(ini, group, "MTime").c_str(), NULL, 10);
+        entry.size = g_ascii_strtoll(keyfile_get_string(ini, group, "Size").c_str(), NULL, 10);
+        entry.loadable = g_key_file_get_boolean(ini, group, "Loadable", NULL) != FALSE;
+        if (entry.loadable) {
+            entry.name = keyfile_get_string(ini, group, "Name");
+            entry.author = keyfile_get_string(ini, group, "Author");
+            entry.num_caves = g_key_file_get_integer(ini, group, "Caves", NULL);
+            gsize num_colors = 0;
+            AutoGFreePtr<gint> colors(g_key_file_get_integer_list(ini, group, "Colors", &num_colors, NULL));
+            if (num_colors != CavesetCatalogEntry::ThumbnailColors)
+                continue;
+            for (unsigned c = 0; c < num_colors; ++c)
+                entry.colors[c] = guint32(colors[c]) & 0xffffff;
+            entry.thumbnail_width = g_key_file_get_integer(ini, group, "ThumbnailWidth", NULL);
+            entry.thumbnail_height = g_key_file_get_integer(ini, group, "ThumbnailHeight", NULL);
+            entry.thumbnail = keyfile_get_string(ini, group, "Thumbnail");
+            /* check the thumbnail, as it will be drawn */
+            if (entry.thumbnail_width > CavesetCatalogEntry::ThumbnailMaxWidth || entry.thumbnail_height > CavesetCatalogEntry::ThumbnailMaxHeight
+                    || entry.thumbnail.size() != entry.thumbnail_width * entry.thumbnail_height
+                    || entry.thumbnail.find_first_not_of("012345") != std::string::npos)
+                continue;
+        }
+        entries[path] = entry;
+    }
+    g_strfreev(groups);
+    g_key_file_free(ini);
+}
+
+
+/// Save the catalog to the configuration directory, if it has new entries.
+/// The entries of the files deleted, moved or modified since are dropped first.
+void CavesetCatalog::save() {
+    if (gd_user_config_dir.empty())
+        return;
+
+    for (std::map<std::string, CavesetCatalogEntry>::iterator it = entries.begin(); it != entries.end(); ) {
+        gint64 mtime, size;
+        if (!CavesetCatalogEntry::stat_file(it->first.c_str(), mtime, size) || it->second.mtime != mtime || it->second.size != size) {
+            entries.erase(it++);
+            modified = true;
+        } else
+            ++it;
+    }
+    if (!modified)
+        return;
+
+    GKeyFile *ini = g_key_file_new();
+    g_key_file_set_integer(ini, CATALOG_GROUP, "Version", catalog_version);
+    unsigned n = 0;
+    for (std::map<std::string, CavesetCatalogEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it, ++n) {
+        CavesetCatalogEntry const &entry = it->second;
+        std::string group = SPrintf("File %u") % n;
+        g_key_file_set_string(ini, group.c_str(), "Path", it->first.c_str());
+        g_key_file_set_string(ini, group.c_str(), "MTime", CPrintf("%d") % entry.mtime);
+        g_key_file_set_string(ini, group.c_str(), "Size", CPrintf("%d") % entry.size);
+        g_key_file_set_boolean(ini, group.c_str(), "Loadable", entry.loadable);
+        if (!entry.loadable)
+            continue;
+        g_key_file_set_string(ini, group.c_str(), "Name", entry.name.c_str());
+        g_key_file_set_string(ini, group.c_str(), "Author", entry.author.c_str());
+        g_key_file_set_integer(ini, group.c_str(), "Caves", entry.num_caves);
+        gint colors[CavesetCatalogEntry::ThumbnailColors];
+        for (unsigned c = 0; c < CavesetCatalogEntry::ThumbnailColors; ++c)
+            colors[c] = entry.colors[c];
+        g_key_file_set_integer_list(ini, group.c_str(), "Colors", colors, CavesetCatalogEntry::ThumbnailColors);
+        g_key_file_set_integer(ini, group.c_str(), "ThumbnailWidth", entry.thumbnail_width);
+        g_key_file_set_integer(ini, group.c_str(), "ThumbnailHeight", entry.thumbnail_height);
+        g_key_file_set_string(ini, group.c_str(), "Thumbnail", entry.thumbnail.c_str());
+    }
+
+    AutoGFreePtr<gchar> data(g_key_file_to_data(ini, NULL, NULL));
+    g_key_file_free(ini);
+    g_mkdir_with_parents(gd_user_config_dir.c_str(), 0700);
+    GError *error = NULL;
+    if (!g_file_set_contents(catalog_filename().c_str(), data, -1, &error)) {
+        gd_debug(CPrintf("Unable to save caveset catalog: %s") % error->message);
+        g_error_free(error);
+        return;
+    }
+    modified = false;
+}
+
+
+/// Find the entry of a file.
+/// @return The entry, or NULL if the file is not in the catalog or it is modified since.
+CavesetCatalogEntry const *CavesetCatalog::find(std::string const &path, gint64 mtime, gint64 size) const {
+    std::map<std::string, CavesetCatalogEntry>::const_iterator it = entries.find(path);
+    if (it == entries.end() || it->second.mtime != mtime || it->second.size != size)
+        return NULL;
+    return &it->second;
+}
+
+
+/// Add or replace the entry of a file.
+void CavesetCatalog::store(std::string const &path, CavesetCatalogEntry const &entry) {
+    entries[path] = entry;
+    modified = true;
+}
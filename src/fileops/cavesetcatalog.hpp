@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef CAVESETCATALOG_HPP_INCLUDED
+#define CAVESETCATALOG_HPP_INCLUDED
+
+#include "config.h"
+
+#include <glib.h>
+#include <map>
+#include <string>
+
+/// @file fileops/cavesetcatalog.hpp
+/// An index of caveset files, for the file selector.
+///
+/// To show the name, the author and the number of caves of a caveset file,
+/// it must be loaded. The catalog remembers these, and a tiny thumbnail
+/// of the first cave, in a file in the configuration directory. An entry is
+/// identified by the path of the file, and is used only if the modification
+/// time and the size of the file are not changed since.
+
+/// Information about a caveset file.
+struct CavesetCatalogEntry {
+    enum {
+        ThumbnailMaxWidth = 40,
+        ThumbnailMaxHeight = 22,
+        ThumbnailColors = 6,
+    };
+
+    CavesetCatalogEntry();
+
+    gint64 mtime;               ///< Modification time of the file when the entry was created
+    gint64 size;                ///< Size of the file when the entry was created
+    bool loadable;              ///< False, if the file could not be loaded; then the others are not set
+    std::string name;
+    std::string author;
+    unsigned num_caves;
+    /// The colors of the first cave, as 0xRRGGBB values: the background, and c64 colors 1-5.
+    guint32 colors[ThumbnailColors];
+    unsigned thumbnail_width, thumbnail_height;
+    /// The index of the color of each cell of the first cave, row by row, as '0' to '5' characters.
+    std::string thumbnail;
+
+    static bool stat_file(char const *path, gint64 &mtime, gint64 &size);
+    static CavesetCatalogEntry create(char const *path);
+};
+
+/// The catalog of caveset files, loaded from and saved to the configuration directory.
+class CavesetCatalog {
+public:
+    CavesetCatalog();
+    void load();
+    void save();
+    CavesetCatalogEntry const *find(std::string const &path, gint64 mtime, gint64 size) const;
+    void store(std::string const &path, CavesetCatalogEntry const &entry);
+
+private:
+    std::map<std::string, CavesetCatalogEntry> entries;
+    bool modified;
+};
+
+#endif
@@ -50,32 +50,43 @@ static std::string filename_for_cave_highscores(CaveSet const & caveset) {
 
 /** Save highscores and playing stat of the current caveset to the configuration directory. */
 void save_highscore(CaveSet const & caveset) {
-    std::list<std::string> out;
+    /* if the caveset is not finished loading, its highscores may not be loaded yet.
+     * but then the caves were not played either, so the file is up to date. */
+    if (!caveset.is_loading_finished())
+        return;
+
+    std::string saved;
+    BdcffWriter out(saved);
     CaveStored defaultcave;     /* for the reflective comparison */
 
     /* caveset: only highscore */
-    out.push_back(SPrintf("; Caveset: %s") % caveset.name);
-    out.push_back(SPrintf("Index=%d") % -1);
-    for (unsigned int i = 0; i < caveset.highscore.size(); i++)
-        out.push_back(BdcffFormat("Highscore") << caveset.highscore[i].score << caveset.highscore[i].name);
-    out.push_back("");
+    out.line(SPrintf("; Caveset: %s") % caveset.name);
+    out.line(SPrintf("Index=%d") % -1);
+    for (unsigned int i = 0; i < caveset.highscore.size(); i++) {
+        out.start_line("Highscore");
+        out << caveset.highscore[i].score << caveset.highscore[i].name;
+        out.end_line();
+    }
+    out.line("");
     
     /* for all caves: stat & highscore */
     for (unsigned int i = 0; i < caveset.caves.size(); ++i) {
-        CaveStored *cave = caveset.caves.at(i);
-        out.push_back(SPrintf("; Cave: %s") % cave->name);
-        out.push_back(SPrintf("Index=%d") % i);
-        for (unsigned int i = 0; i < cave->highscore.size(); i++)
-            out.push_back(BdcffFormat("Highscore") << cave->highscore[i].score << cave->highscore[i].name);
+        CaveStored *cave = &caveset.cave(i);
+        out.line(SPrintf("; Cave: %s") % cave->name);
+        out.line(SPrintf("Index=%d") % i);
+        for (unsigned int i = 0; i < cave->highscore.size(); i++) {
+            out.start_line("Highscore");
+            out << cave->highscore[i].score << cave->highscore[i].name;
+            out.end_line();
+        }
         save_properties(out, *cave, defaultcave, 0, CaveStored::cave_statistics_data);
-        out.push_back("");
+        out.line("");
     }
 
     /* write to file */
     std::ofstream outfile;
     outfile.open(filename_for_cave_highscores(caveset).c_str());
-    for (std::list<std::string>::const_iterator it = out.begin(); it != out.end(); ++it)
-        outfile << *it << std::endl;
+    outfile.write(saved.data(), saved.size());
     outfile.close();
 }
 
@@ -110,10 +121,10 @@ bool load_highscore(CaveSet & caveset) {
             if (caveindex == -1)
                 caveset.highscore.add(scorename.param, score);
             else
-                caveset.caves.at(caveindex)->highscore.add(scorename.param, score);
+                caveset.cave(caveindex).highscore.add(scorename.param, score);
         }
         else {
-            if (!struct_set_property(*caveset.caves.at(caveindex), ap.attrib, ap.param, 0, CaveStored::cave_statistics_data)) {
+            if (!struct_set_property(caveset.cave(caveindex), ap.attrib, ap.param, 0, CaveStored::cave_statistics_data)) {
                 gd_debug(CPrintf("No such property: %s") % ap.attrib);
             }
         }
@@ -121,3 +132,30 @@ bool load_highscore(CaveSet & caveset) {
     infile.close();
     return true;
 }
+
+
+/* loads the highscores, when the caves of the caveset are first needed. */
+class PendingHighscoreLoad : public PendingLoad {
+public:
+    virtual void finish(CaveSet &caveset) {
+        try {
+            load_highscore(caveset);
+        } catch (std::exception &e) {
+            gd_warning(CPrintf("Unable to load highscores: %s") % e.what());
+        }
+    }
+};
+
+
+/**
+ * Load highscores from the configuration directory, when the caves of the caveset are first needed.
+ * The name of the highscore file is given by the checksum of the caves, and calculating it creates
+ * all caves. So the highscores are loaded at once only if the checksum is already known, for
+ * example because the caveset was loaded from the cache. Otherwise it is left to CaveSet::finish_loading().
+ */
+void load_highscore_later(CaveSet & caveset) {
+    if (caveset.cached_checksum_valid && caveset.is_loading_finished())
+        load_highscore(caveset);
+    else
+        caveset.add_pending_load(SmartPtr<PendingLoad>(new PendingHighscoreLoad));
+}
@@ -29,5 +29,6 @@ class CaveSet;
 
 void save_highscore(CaveSet const & caveset);
 bool load_highscore(CaveSet & caveset);
+void load_highscore_later(CaveSet & caveset);
 
 #endif
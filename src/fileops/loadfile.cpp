@@ -24,20 +24,25 @@
 #include "fileops/loadfile.hpp"
 
 #include <glib/gi18n.h>
+#include <cstring>
 #include <stdexcept>
-#include <fstream>
 #include "cave/caveset.hpp"
 #include "fileops/binaryimport.hpp"
 #include "fileops/brcimport.hpp"
 #include "fileops/c64import.hpp"
 #include "fileops/bdcffload.hpp"
+#include "fileops/cavesetcache.hpp"
+#include "fileops/mappedfile.hpp"
 #include "misc/logger.hpp"
 #include "misc/util.hpp"
 #include "misc/autogfreeptr.hpp"
+#include "misc/trace.hpp"
+#include "settings.hpp"
 
 
 /** load some caveset from the binary data in the buffer.
- * the length may be -1, if the caller is pretty sure of what he's doing. */
+ * the length may be -1, if the caller is pretty sure of what he's doing.
+ * the buffer need not be terminated by a zero, and it can be freed after loading. */
 CaveSet create_from_buffer(const unsigned char *buffer, int length, char const *filename) {
     /* set logging context to filename */
     SetLoggerContextForFunction finally(gd_tostring_free(g_filename_display_basename(filename)));
@@ -71,7 +76,8 @@ CaveSet create_from_buffer(const unsigned char *buffer, int length, char const *
 
     /* try to load as BDCFF */
     if (g_str_has_suffix(filename, ".bd") || g_str_has_suffix(filename, ".BD")) {
-        CaveSet newcaves = load_from_bdcff((char const *) buffer);
+        size_t bdcff_length = length != -1 ? length : strlen((char const *) buffer);
+        CaveSet newcaves = load_from_bdcff((char const *) buffer, bdcff_length, true);
         newcaves.last_selected_cave = newcaves.first_selectable_cave_index();
         /* remember filename, as the input is a bdcff file */
         if (g_path_is_absolute(filename)) {
@@ -99,39 +105,27 @@ CaveSet create_from_buffer(const unsigned char *buffer, int length, char const *
 
 /**
  * Create a caveset by loading it from a file.
+ * The file is memory mapped, and the loaders work on its contents directly.
+ * The caveset does not refer to the file after loading; it is unmapped when returning.
  * @param filename The name of the file, which can be BDCFF or other binary formats.
  * @return The caveset loaded. If impossible to load, throws an exception.
  */
 CaveSet load_caveset_from_file(const char *filename) {
-    std::vector<unsigned char> contents = load_file_to_vector(filename);
-    /* -1 because the loader adds a terminating zero */
-    return create_from_buffer(&contents[0], contents.size() - 1, filename);
-}
-
-
-/**
- * Load a file to an array of bytes.
- * @param filename The name of the file.
- * @return The file loaded. If impossible to load, throws an exception.
- */
-std::vector<unsigned char> load_file_to_vector(char const *filename) {
-    /* open file */
-    std::ifstream is;
-    is.open(filename, std::ios::in | std::ios::binary);
-    if (!is)
-        throw std::runtime_error(_("Unable to open file."));
-    /* check size */
-    is.seekg(0, is.end);
-    int filesize = is.tellg();
-    is.seekg(0, is.beg);
-    if (filesize > (2 * 1 << 20))
-        throw std::runtime_error(_("File bigger than 2MiB, refusing to load."));
-    /* read file. the vector will be one bytes bigger, so it can be added a terminating zero char. */
-    std::vector<unsigned char> contents(filesize + 1);
-    if (!is.read((char *) &contents[0], filesize))
-        throw std::runtime_error(_("Unable to read file."));
-    is.close();
-    contents[filesize] = '\0';
-
-    return contents;
+    TraceSpan span("load_caveset_from_file", "io");
+    MappedFile file(filename);
+    unsigned char const *contents = file.get_contents();
+    size_t length = file.get_length();
+    /* the importers of the binary formats use int lengths */
+    if (length > size_t(G_MAXINT))
+        throw std::runtime_error(_("File too big."));
+
+    /* if loaded before, and the file is not modified, use the cache. */
+    CaveSet caveset;
+    if (gd_caveset_cache && load_caveset_from_cache(filename, contents, length, caveset))
+        return caveset;
+
+    caveset = create_from_buffer(contents, length, filename);
+    if (gd_caveset_cache)
+        save_caveset_to_cache_later(filename, contents, length, caveset);
+    return caveset;
 }
@@ -26,11 +26,8 @@
 
 #include "config.h"
 
-#include <vector>
-
 class CaveSet;
 
-std::vector<unsigned char> load_file_to_vector(char const *filename);
 CaveSet load_caveset_from_file(const char *filename);
 CaveSet create_from_buffer(const unsigned char *buffer, int length, char const *filename = "");
 
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <stdexcept>
+
+#include "fileops/mappedfile.hpp"
+
+
+/// Map a file to memory for reading.
+/// @param filename The name of the file.
+/// If the file cannot be opened, throws an exception.
+MappedFile::MappedFile(char const *filename) {
+    GError *error = NULL;
+    file = g_mapped_file_new(filename, FALSE, &error);
+    if (file == NULL) {
+        g_error_free(error);
+        throw std::runtime_error(_("Unable to open file."));
+    }
+    length = g_mapped_file_get_length(file);
+    /* glib returns NULL for an empty file; point to something, so users can take the address of the contents */
+    static unsigned char const empty[] = "";
+    contents = length != 0 ? (unsigned char const *) g_mapped_file_get_contents(file) : empty;
+}
+
+
+MappedFile::~MappedFile() {
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=22)
+    g_mapped_file_unref(file);
+#else
+    g_mapped_file_free(file);
+#endif
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef MAPPEDFILE_HPP_INCLUDED
+#define MAPPEDFILE_HPP_INCLUDED
+
+#include "config.h"
+
+#include <glib.h>
+#include <cstddef>
+
+/// @file fileops/mappedfile.hpp
+/// A read-only, memory mapped view of a file.
+
+/// The contents of a file, memory mapped for reading.
+///
+/// The contents are not copied to memory, and they are not terminated by a
+/// zero byte; the users must use get_length() to stay within the file.
+/// Share it with a SmartPtr if the contents are needed after the file is loaded.
+class MappedFile {
+public:
+    explicit MappedFile(char const *filename);
+    ~MappedFile();
+    /// The contents of the file. Not zero terminated.
+    unsigned char const *get_contents() const {
+        return contents;
+    }
+    /// The length of the file in bytes.
+    size_t get_length() const {
+        return length;
+    }
+
+private:
+    GMappedFile *file;
+    unsigned char const *contents;
+    size_t length;
+
+    MappedFile(const MappedFile &);                // not implemented
+    MappedFile &operator=(const MappedFile &);     // not implemented
+};
+
+#endif
@@ -34,10 +34,6 @@ void Activity::timer_event(int ms_elapsed) {
 }
 
 
-void Activity::timer2_event() {
-}
-
-
 void Activity::keypress_event(KeyCode keycode, int gfxlib_keycode) {
 }
 
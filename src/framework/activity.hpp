@@ -70,13 +70,6 @@ private:
      * usually not real milliseconds, but the interval of the timer used
      * by the App. */
     virtual void timer_event(int ms_elapsed);
-    /**
-     * This is another timer, which is seldom used. It is called only in
-     * replay video saving mode, and implemented only by the
-     * ReplaySaverActivity class. The timer2 events are generated there
-     * by the SDL_Mixer library, to use the audio mixing routine for the
-     * cave replay to be totally in sync with the framerate of the game. */
-    virtual void timer2_event();
     /**
      * A key pressed, sent to the Activity.
      * @param keycode a unicode character code, or some special key (see KeyCodeSpecialKey)
@@ -101,6 +101,8 @@ void RestartWithTitleScreenCommand::execute() {
 void ShowHighScoreCommand::execute() {
     std::string text;
 
+    app->caveset->finish_loading();     /* so the highscores are loaded */
+
     // TRANSLATORS: showing highscore, categories
     text += SPrintf("%c%s: %c%s\n") % GD_COLOR_INDEX_WHITE % _("Caveset") % GD_COLOR_INDEX_YELLOW % app->caveset->name;
 
@@ -128,6 +130,7 @@ void ShowHighScoreCommand::execute() {
 
 
 void ShowStatisticsCommand::execute() {
+    app->caveset->finish_loading();     /* so the statistics are loaded */
     bool has_levels = app->caveset->has_levels();
     
     /* count number of properties, and make a format string as well */
@@ -238,7 +241,7 @@ void OpenFileCommand::execute() {
 
     try {
         *app->caveset = load_caveset_from_file(filename.c_str());
-        load_highscore(*app->caveset);
+        load_highscore_later(*app->caveset);
         /* start a new title screen */
         app->enqueue_command(new RestartWithTitleScreenCommand(app));
     } catch (std::exception &e) {
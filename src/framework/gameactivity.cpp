@@ -34,6 +34,7 @@
 #include "sound/sound.hpp"
 #include "input/gameinputhandler.hpp"
 #include "misc/helptext.hpp"
+#include "misc/frametimes.hpp"
 #include "settings.hpp"
 
 
@@ -125,10 +126,12 @@ void GameActivity::shown_event() {
      * gameactivity can use the escape key as an exit key, and after the activity
      * exists, this activity might think that the cave is to be restarted. */
     (bool) app->gameinput->restart();
+    gd_frame_times.start_recording();
 }
 
 
 void GameActivity::hidden_event() {
+    gd_frame_times.stop_recording();
     app->game_active(false);
 }
 
@@ -163,6 +166,9 @@ void GameActivity::keypress_event(KeyCode keycode, int gfxlib_keycode) {
             else
                 app->show_message(_("No snapshot saved."));
             break;
+        case FrameTimesKey:
+            gamerenderer.toggle_frame_times();
+            break;
         case CaveVariablesKey:
             app->show_text_and_do_command(_("Cave Information"), info_and_variables_of_cave(game->original_cave, game->played_cave.get()));
             break;
@@ -60,6 +60,7 @@ public:
         TakeSnapshotKey = App::F3,
         RevertToSnapshotKey = App::F4,
         PauseKey = ' ',
+        FrameTimesKey = App::F7,
         CaveVariablesKey = App::F8,
     };
 
@@ -28,6 +28,8 @@
 
 #include <SDL/SDL_mixer.h>
 #include <glib/gi18n.h>
+#include <cstring>
+#include <algorithm>
 
 #include "framework/replaysaveractivity.hpp"
 #include "framework/app.hpp"
@@ -39,78 +41,27 @@
 #include "cave/titleanimation.hpp"
 #include "cave/caveset.hpp"
 #include "misc/logger.hpp"
+#include "misc/frametimes.hpp"
 #include "settings.hpp"
-#include "sdl/sdlpixbuf.hpp"
 
-class SDLInmemoryPixmap: public Pixmap {
-protected:
-    SDL_Surface *surface;
-
-    SDLInmemoryPixmap(const SDLInmemoryPixmap &);               // copy ctor not implemented
-    SDLInmemoryPixmap &operator=(const SDLInmemoryPixmap &);    // operator= not implemented
-
-public:
-    SDLInmemoryPixmap(SDL_Surface *surface_) : surface(surface_) {}
-    ~SDLInmemoryPixmap() {
-        SDL_FreeSurface(surface);
-    }
-
-    virtual int get_width() const {
-        return surface->w;
-    }
-    virtual int get_height() const {
-        return surface->h;
-    }
-};
-
-
-Pixmap *SDLInmemoryScreen::create_pixmap_from_pixbuf(Pixbuf const &pb, bool keep_alpha) const {
-    SDL_Surface *to_copy = static_cast<SDLPixbuf const &>(pb).get_surface();
-    SDL_Surface *newsurface = SDL_CreateRGBSurface(keep_alpha ? SDL_SRCALPHA : 0, to_copy->w, to_copy->h, 32,
-                              surface->format->Rmask, surface->format->Gmask, surface->format->Bmask, surface->format->Amask);
-    SDL_SetAlpha(to_copy, 0, SDL_ALPHA_OPAQUE);
-    SDL_BlitSurface(to_copy, NULL, newsurface, NULL);
-    return new SDLInmemoryPixmap(newsurface);
-}
-
-
-void SDLInmemoryScreen::set_title(char const *) {
-    /* do nothing, not a real window */
-}
-
-
-void SDLInmemoryScreen::configure_size() {
-    if (surface)
-        SDL_FreeSurface(surface);
-    surface = SDL_CreateRGBSurface(SDL_SRCALPHA, w, h, 32, Pixbuf::rmask, Pixbuf::gmask, Pixbuf::bmask, Pixbuf::amask);
-    Uint32 col = SDL_MapRGBA(surface->format, 0, 0, 0, SDL_ALPHA_OPAQUE);
-    SDL_FillRect(surface, NULL, col);
-}
-
-
-SDLInmemoryScreen::~SDLInmemoryScreen() {
-    SDL_FreeSurface(surface);
-}
-
-
-void SDLInmemoryScreen::save(char const *filename) {
-    IMG_SavePNG(filename, surface, 2);        // 2 = not too much compression, but a bit faster than the default
-}
-
-
-Pixbuf const *SDLInmemoryScreen::create_pixbuf_screenshot() const {
-    SDL_Surface *sub = SDL_CreateRGBSurfaceFrom(surface->pixels,
-                       w, h, 32, surface->pitch, surface->format->Rmask, surface->format->Gmask, surface->format->Bmask, 0);
-    return new SDLPixbuf(sub);
-}
+/* every frame is this much game time; 25fps */
+static int const frame_ms = 40;
 
 
 ReplaySaverActivity::ReplaySaverActivity(App *app, CaveStored *cave, CaveReplay *replay, std::string const &filename_prefix)
     :
     Activity(app),
+    wavlen(0),
+    frame(0),
+    failed_frames(0),
+    finished(false),
+    frequency(44100), channels(2), bits(16),
     filename_prefix(filename_prefix),
+    wavfile(NULL),
+    filling(0),
     game(GameControl::new_replay(app->caveset, cave, replay)),
-    pf(),
+    loader(),
+    pf(&loader),
     pm(pf),
     fm(pm, ""),
     cellrenderer(pm, gd_theme),
@@ -119,19 +70,28 @@ ReplaySaverActivity::ReplaySaverActivity(App *app, CaveStored *cave, CaveReplay
     pm.set_size(cell_size * GAME_RENDERER_SCREEN_SIZE_X, cell_size * GAME_RENDERER_SCREEN_SIZE_Y, false);
     gamerenderer.screen_initialized();
     gamerenderer.set_show_replay_sign(false);
+    /* save settings and install own settings */
+    saved_gd_show_name_of_game = gd_show_name_of_game;
+    gd_show_name_of_game = true;
+    /* two batches: one is rendered while the other one is saved. the main thread
+     * renders, so one worker less is needed than the number of processors. */
+    unsigned batch_size = 2 * ParallelJobs::get_num_processors();
+    for (unsigned i = 0; i < G_N_ELEMENTS(batches); ++i) {
+        batches[i].width = pm.get_width();
+        batches[i].height = pm.get_height();
+        batches[i].count = 0;
+        batches[i].frames.resize(batch_size);
+        batches[i].failed = 0;
+    }
     std::string wav_filename = filename_prefix + ".wav";
     wavfile = fopen(wav_filename.c_str(), "wb");
     if (!wavfile) {
         gd_critical(CPrintf("Cannot open %s for sound output") % wav_filename);
+        finished = true;
         app->enqueue_command(new PopActivityCommand(app));
         return;
     }
     fseek(wavfile, 44, SEEK_SET);    /* 44bytes offset: start of data in a wav file */
-    wavlen = 0;
-    frame = 0;
-    /* save settings and install own settings */
-    saved_gd_show_name_of_game = gd_show_name_of_game;
-    gd_show_name_of_game = true;
 }
 
 
@@ -141,53 +101,57 @@ void ReplaySaverActivity::shown_event() {
     delete animation[0];
     gd_music_stop();
 
-    /* enable own timer and sound saver */
+    /* enable own sound mixing */
     install_own_mixer();
 }
 
 
 ReplaySaverActivity::~ReplaySaverActivity() {
-    Mix_SetPostMix(NULL, NULL);    /* remove wav file saver */
+    /* the batches must be saved before anything else is destroyed */
+    finish_saving_batch();
     uninstall_own_mixer();
-    gd_sound_off();
-
-    /* write wav header, as now we now its final size. */
-    fseek(wavfile, 0, SEEK_SET);
-    Uint32 out32;
-    Uint16 out16;
-
-    int i = 0;
-    i += fwrite("RIFF", 1, 4, wavfile);  /* "RIFF" */
-    out32 = GUINT32_TO_LE(wavlen + 36);
-    i += fwrite(&out32, 1, 4, wavfile);  /* 4 + 8+subchunk1size + 8+subchunk2size */
-    i += fwrite("WAVE", 1, 4, wavfile);  /* "WAVE" */
-
-    i += fwrite("fmt ", 1, 4, wavfile); /* "fmt " */
-    out32 = GUINT32_TO_LE(16);
-    i += fwrite(&out32, 1, 4, wavfile); /* fmt chunk size=16 bytes */
-    out16 = GUINT16_TO_LE(1);
-    i += fwrite(&out16, 1, 2, wavfile); /* 1=pcm */
-    out16 = GUINT16_TO_LE(channels);
-    i += fwrite(&out16, 1, 2, wavfile);
-    out32 = GUINT32_TO_LE(frequency);
-    i += fwrite(&out32, 1, 4, wavfile);
-    out32 = GUINT32_TO_LE(frequency * bits / 8 * channels);
-    i += fwrite(&out32, 1, 4, wavfile); /* byterate */
-    out16 = GUINT16_TO_LE(bits / 8 * channels);
-    i += fwrite(&out16, 1, 2, wavfile); /* blockalign */
-    out16 = GUINT16_TO_LE(bits);
-    i += fwrite(&out16, 1, 2, wavfile); /* bitspersample */
-
-    i += fwrite("data", 1, 4, wavfile); /* "data" */
-    out32 = GUINT32_TO_LE(wavlen);
-    i += fwrite(&out32, 1, 4, wavfile);  /* actual data length */
-    fclose(wavfile);
-
-    if (i != 44)
-        gd_critical("Could not write wav header to file!");
-
-    std::string message = SPrintf(_("Saved %d video frames and %dMiB of audio data to %s_*.png and %s.wav.")) % (frame + 1) % (wavlen / 1048576) % filename_prefix % filename_prefix;
-    app->show_message(_("Replay Saved"), message);
+
+    if (wavfile) {
+        /* write wav header, as now we now its final size. */
+        fseek(wavfile, 0, SEEK_SET);
+        Uint32 out32;
+        Uint16 out16;
+
+        int i = 0;
+        i += fwrite("RIFF", 1, 4, wavfile);  /* "RIFF" */
+        out32 = GUINT32_TO_LE(wavlen + 36);
+        i += fwrite(&out32, 1, 4, wavfile);  /* 4 + 8+subchunk1size + 8+subchunk2size */
+        i += fwrite("WAVE", 1, 4, wavfile);  /* "WAVE" */
+
+        i += fwrite("fmt ", 1, 4, wavfile); /* "fmt " */
+        out32 = GUINT32_TO_LE(16);
+        i += fwrite(&out32, 1, 4, wavfile); /* fmt chunk size=16 bytes */
+        out16 = GUINT16_TO_LE(1);
+        i += fwrite(&out16, 1, 2, wavfile); /* 1=pcm */
+        out16 = GUINT16_TO_LE(channels);
+        i += fwrite(&out16, 1, 2, wavfile);
+        out32 = GUINT32_TO_LE(frequency);
+        i += fwrite(&out32, 1, 4, wavfile);
+        out32 = GUINT32_TO_LE(frequency * bits / 8 * channels);
+        i += fwrite(&out32, 1, 4, wavfile); /* byterate */
+        out16 = GUINT16_TO_LE(bits / 8 * channels);
+        i += fwrite(&out16, 1, 2, wavfile); /* blockalign */
+        out16 = GUINT16_TO_LE(bits);
+        i += fwrite(&out16, 1, 2, wavfile); /* bitspersample */
+
+        i += fwrite("data", 1, 4, wavfile); /* "data" */
+        out32 = GUINT32_TO_LE(wavlen);
+        i += fwrite(&out32, 1, 4, wavfile);  /* actual data length */
+        fclose(wavfile);
+
+        if (i != 44)
+            gd_critical("Could not write wav header to file!");
+
+        if (failed_frames > 0)
+            gd_critical(CPrintf("Could not save %d video frames!") % failed_frames);
+        std::string message = SPrintf(_("Saved %d video frames and %dMiB of audio data to %s_*.png and %s.wav.")) % frame % (wavlen / 1048576) % filename_prefix % filename_prefix;
+        app->show_message(_("Replay Saved"), message);
+    }
 
     // restore settings
     gd_show_name_of_game = saved_gd_show_name_of_game;
@@ -215,31 +179,17 @@ void ReplaySaverActivity::install_own_mixer() {
     gd_sound_44khz_mixing = true;
     gd_sound_16bit_mixing = true;
     gd_sound_stereo = true;
-    // select the dummy driver, as it accepts any format, and we have control
+    // select the dummy driver, as it accepts any format, and the sound card is not needed
     g_setenv("SDL_AUDIODRIVER", "dummy", TRUE);
-    gd_sound_init(44100 / 25);  /* so the buffer will be 1/25th of a second. and we get our favourite 25hz interrupt from the mixer. */
-
-    /* query audio format from sdl */
-    Uint16 format;
-    Mix_QuerySpec(&frequency, &format, &channels);
-    if (frequency != 44100)      /* something must be really going wrong. */
-        gd_critical("Cannot initialize mixer to 44100Hz mixing. The replay saver will not work correctly!");
-
-    switch (format) {
-        case AUDIO_U8:
-        case AUDIO_S8:
-            bits = 8;
-            break;
-        case AUDIO_U16LSB:
-        case AUDIO_S16LSB:
-        case AUDIO_U16MSB:
-        case AUDIO_S16MSB:
-            bits = 16;
-            break;
-        default:
-            g_assert_not_reached();
+    if (!gd_sound_init_offline())
+        gd_critical("Cannot initialize offline sound mixing. The replay will be saved without sound.");
+    else {
+        /* query audio format from sdl */
+        Uint16 format;
+        Mix_QuerySpec(&frequency, &format, &channels);
+        if (frequency != 44100)      /* something must be really going wrong. */
+            gd_critical("Cannot initialize mixer to 44100Hz mixing. The replay saver will not work correctly!");
     }
-    Mix_SetPostMix(mixfunc, this);
 }
 
 
@@ -261,25 +211,6 @@ void ReplaySaverActivity::uninstall_own_mixer() {
 }
 
 
-/* this function saves the wav file, and also does the timing! */
-void ReplaySaverActivity::mixfunc(void *udata, Uint8 *stream, int len) {
-    ReplaySaverActivity *rs = static_cast<ReplaySaverActivity *>(udata);
-
-    if (!rs->wavfile)
-        return;
-    if (fwrite(stream, 1, len, rs->wavfile) != size_t(len))
-        gd_critical("Cannot write to wav file!");
-
-    // push a user event -> to do the timing
-    SDL_Event ev;
-    ev.type = SDL_USEREVENT + 1;
-    SDL_PushEvent(&ev);
-
-    rs->wavlen += len;
-}
-
-#include <typeinfo>
-
 void ReplaySaverActivity::redraw_event(bool full) const {
     app->clear_screen();
 
@@ -292,35 +223,112 @@ void ReplaySaverActivity::redraw_event(bool full) const {
     // center coordinates
     int x = (app->screen->get_width() - pm.get_width()) / 2;
     int y = (app->screen->get_height() - pm.get_height()) / 2;
-    Pixbuf const *pb = pm.create_pixbuf_screenshot();
+    // the app screen needs a pixbuf of its own factory; they have the same pixel format.
+    std::auto_ptr<Pixbuf> pb(app->screen->pixbuf_factory.create(pm.get_width(), pm.get_height()));
+    pm.get_pixbuf().copy(*pb, 0, 0);
     app->screen->blit_pixbuf(*pb, x, y, false);
-    delete pb;
 
     app->screen->drawing_finished();
 }
 
 
-void ReplaySaverActivity::timer2_event() {
+void ReplaySaverActivity::save_frame_job(unsigned job, gpointer data) {
+    FrameBatch *batch = static_cast<FrameBatch *>(data);
+    PendingFrame &pending = batch->frames[job];
+    SDL_Surface *surface = SDL_CreateRGBSurfaceFrom(&pending.pixels[0], batch->width, batch->height, 32, batch->width * sizeof(guint32),
+                           Pixbuf::rmask, Pixbuf::gmask, Pixbuf::bmask, Pixbuf::amask);
+    /* 2 = not too much compression, but a bit faster than the default */
+    if (!surface || IMG_SavePNG(pending.filename.c_str(), surface, 2) < 0)
+        g_atomic_int_inc(&batch->failed);
+    if (surface)
+        SDL_FreeSurface(surface);
+}
+
+
+void ReplaySaverActivity::finish_saving_batch() {
+    if (encoder.get() == NULL)
+        return;
+    encoder->finish_all();
+    encoder.reset();
+    FrameBatch &saved = batches[1 - filling];
+    failed_frames += g_atomic_int_get(&saved.failed);
+    saved.failed = 0;
+    saved.count = 0;
+}
+
+
+void ReplaySaverActivity::start_saving_batch() {
+    finish_saving_batch();
+    if (batches[filling].count == 0)
+        return;
+    unsigned threads = std::max(1u, ParallelJobs::get_num_processors() - 1);
+    encoder.reset(new ParallelJobs(batches[filling].count, save_frame_job, &batches[filling], threads));
+    filling = 1 - filling;
+}
+
+
+void ReplaySaverActivity::queue_frame() {
+    FrameBatch &batch = batches[filling];
+    PendingFrame &pending = batch.frames[batch.count];
+    pending.filename = SPrintf("%s_%08d.png") % filename_prefix % frame;
+    Pixbuf const &screen = pm.get_pixbuf();
+    pending.pixels.resize(batch.width * batch.height);
+    for (int y = 0; y < batch.height; ++y)
+        memcpy(&pending.pixels[y * batch.width], screen.get_row(y), batch.width * sizeof(guint32));
+    batch.count++;
+    if (batch.count == batch.frames.size())
+        start_saving_batch();
+}
+
+
+bool ReplaySaverActivity::render_frame() {
     /* iterate and see what happened */
     /* give no gameinputhandler to the renderer */
-    GameRenderer::State state = gamerenderer.main_int(40, false, NULL);
+    GameRenderer::State state = gamerenderer.main_int(frame_ms, false, NULL);
     gamerenderer.draw(pm.must_redraw_all_before_flip());
     pm.do_the_flip();
+    queue_frame();
+
+    /* the sound of the frame */
+    samples.resize(frequency * frame_ms / 1000 * channels);
+    gd_sound_mix_offline(&samples[0], samples.size() / channels);
+    for (unsigned i = 0; i < samples.size(); ++i)
+        samples[i] = GINT16_TO_LE(samples[i]);
+    if (fwrite(&samples[0], sizeof(gint16), samples.size(), wavfile) != samples.size())
+        gd_critical("Cannot write to wav file!");
+    wavlen += samples.size() * sizeof(gint16);
+
+    frame++;
     switch (state) {
         case GameRenderer::Nothing:
-            break;
+            return true;
 
         case GameRenderer::Stop:        /* game stopped, this could be a replay or a snapshot */
         case GameRenderer::GameOver:    /* game over should not happen for a replay, but no problem */
-            app->enqueue_command(new PopActivityCommand(app));
-            break;
+            return false;
     }
+    return false;
+}
 
-    /* before incrementing frame number, check if to save the frame to disk. */
-    pm.save(CPrintf("%s_%08d.png") % filename_prefix.c_str() % frame);
+
+void ReplaySaverActivity::timer_event(int ms_elapsed) {
+    if (finished)
+        return;
+
+    /* render as many frames as possible, but show the progress to the user
+     * from time to time. */
+    gint64 start = FrameTimes::now();
+    do {
+        if (!render_frame()) {
+            finished = true;
+            start_saving_batch();
+            finish_saving_batch();
+            app->enqueue_command(new PopActivityCommand(app));
+            break;
+        }
+    } while (FrameTimes::now() - start < 100000);
 
     queue_redraw();
-    frame++;
 }
 
 #endif /* IFDEF HAVE_SDL */
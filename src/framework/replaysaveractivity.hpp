@@ -28,56 +28,39 @@
 #ifdef HAVE_SDL
 
 #include <SDL.h>
+#include <vector>
+#include <memory>
 
 #include "framework/activity.hpp"
-#include "sdl/sdlscreen.hpp"
 #include "sdl/sdlpixbuffactory.hpp"
+#include "gfx/memorypixbuffactory.hpp"
+#include "gfx/memoryscreen.hpp"
 #include "gfx/fontmanager.hpp"
 #include "gfx/cellrenderer.hpp"
 #include "cave/gamerender.hpp"
+#include "misc/parallel.hpp"
 
 class CaveStored;
 class CaveReplay;
 class GameControl;
 
-/** This is a special SDL screen, which is a bitmap in memory.
- * During the replay, the drawing routine draws on this, and it can be saved to disk. */
-class SDLInmemoryScreen: public SDLAbstractScreen {
-public:
-    SDLInmemoryScreen(PixbufFactory &pixbuf_factory) : SDLAbstractScreen(pixbuf_factory) {}
-    virtual void set_title(char const *);
-    virtual void configure_size();
-    ~SDLInmemoryScreen();
-    virtual Pixmap *create_pixmap_from_pixbuf(Pixbuf const &pb, bool keep_alpha) const;
-
-    Pixbuf const *create_pixbuf_screenshot() const;
-    void save(char const *filename);
-};
-
-
 /**
  * This activity plays a replay, and saves every animation frame to
  * a PNG file, along with the sound to a WAV file.
  *
  * This is implemented using a normal GameControl object, but it is given
- * a special kind of Screen which can be saved to a PNG file. Also
- * the normal sound stream is closed, and a special stream is requested
- * from SDL with the dummy audio driver. A mixer callback func is also
- * registered for SDL_Mixer, which will save the audio data.
+ * a MemoryScreen, which is a bitmap in memory. The replay is
+ * not played in real time: in every timer event, as many frames are
+ * rendered as fit in a tenth of a second, and then the progress is shown
+ * to the user. Every frame is 40ms of game time, so the video is 25fps.
  *
- * During saving the replay, the normal timer events which are forwarded
- * from the App are not used for the timing of the cave. The mixer callback
- * registered to SDL_Mixer also pushes SDL events (SDL_USEREVENT+1), which
- * are then sent to App::timer2_event() in sdlmain.cpp. This is used
- * to iterate the cave. The size of
- * the sound buffer is set to hold 20ms of sound data, so SDL_Mixer is
- * forced to generate us the events every 20ms - thus we can do an 50fps
- * animation.
+ * Compressing the PNG files takes much more time than rendering, so the
+ * frames are copied and saved by worker threads, in batches. While a batch
+ * is being saved, the next one is rendered.
  *
- * During saving the replay, the image is shown to the user, but it is not
- * scaled, and there will be no sound. (As sound goes only to the memory
- * and the WAV file.) This does not take too much CPU power; compressing
- * the PNG files is eats much more.
+ * The sound is not captured from the sound card, but the sound stream is
+ * reopened for offline mixing (see gd_sound_init_offline()), and the
+ * sound of each frame is mixed right after iterating the cave.
  *
  * The whole thing only works in the SDL version, it is not implemented
  * in the GTK game. Maybe it would be nice to put it in the GTK version
@@ -101,28 +84,61 @@ public:
     /**
      * When the Activity is shown, it will install its own sound mixer. */
     virtual void shown_event();
-    /** The timer2 event generated by the sound mixer will do the cave timing. */
-    virtual void timer2_event();
+    /** The timer event renders and saves the next frames. */
+    virtual void timer_event(int ms_elapsed);
 
 private:
-    /** The SDL_Mixer post mixing callback, which saves the WAV file
-     * and sends SDL_USEREVENT+1-s to do the cave timing. */
-    static void mixfunc(void *udata, Uint8 *stream, int len);
-    /** Save sound preferences of the user, restart the SDL audio subsystem
-     * with the required settings and install the mixer callbacks. */
+    /** A frame copied from the screen, to be saved by a worker thread. */
+    struct PendingFrame {
+        std::string filename;
+        std::vector<guint32> pixels;
+    };
+    /** Frames which are saved together by the worker threads. */
+    struct FrameBatch {
+        int width, height;
+        unsigned count;
+        std::vector<PendingFrame> frames;
+        volatile gint failed;       ///< Number of frames which could not be saved
+    };
+
+    /** Save sound preferences of the user, and restart the sound
+     * with the required settings for offline mixing. */
     void install_own_mixer();
     /** Revert to the original sound preferences of the user. */
     void uninstall_own_mixer();
+    /** Iterate the cave, draw it, and queue the image and the sound of the frame.
+     * @return false, if the replay has ended. */
+    bool render_frame();
+    /** Copy the screen to the batch being filled, and start saving it if it is full. */
+    void queue_frame();
+    /** Start saving the batch being filled, and start filling the other one. */
+    void start_saving_batch();
+    /** Wait for the batch being saved, if there is any. */
+    void finish_saving_batch();
+    /** The job function of saving a frame, for ParallelJobs. */
+    static void save_frame_job(unsigned job, gpointer data);
 
     /** Bytes written to the wav file. */
     unsigned int wavlen;
-    /** Number of image frames written. */
+    /** Number of image frames rendered. */
     unsigned int frame;
+    /** Number of image frames which could not be saved. */
+    unsigned int failed_frames;
+    /** True, if the replay has ended. */
+    bool finished;
     /** Sound settings reported by SDL. */
     int frequency, channels, bits;
     std::string filename_prefix;
     /** The WAV file opened for writing. */
     FILE *wavfile;
+    /** The sound samples of a frame. */
+    std::vector<gint16> samples;
+
+    /** The batch of frames being filled by render_frame(). The other one may be saved by the encoder. */
+    unsigned filling;
+    FrameBatch batches[2];
+    /** The worker threads saving a batch, if any. */
+    std::auto_ptr<ParallelJobs> encoder;
 
     // saved settings
     /** User's sound preference to be restored after replay saving. */
@@ -140,10 +156,12 @@ private:
 
     /** GameControl object which plays the replay. */
     GameControl *game;
-    /** A PixbufFactory set to no scaling, no pal emulation. */
-    SDLPixbufFactory pf;
-    /** A Screen, which is much like an image in memory, so it can be saved to PNG */
-    SDLInmemoryScreen pm;
+    /** A PixbufFactory to load the images of the theme with SDL. */
+    SDLPixbufFactory loader;
+    /** A PixbufFactory for the screen in memory, set to no scaling, no pal emulation. */
+    MemoryPixbufFactory pf;
+    /** A Screen, which is an image in memory, so it can be saved to PNG */
+    MemoryScreen pm;
     /** A font manager, which uses the pf PixbufFactory. */
     FontManager fm;
     /** A CellRenderer needed by the GameControl object. */
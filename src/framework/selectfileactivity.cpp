@@ -34,6 +34,9 @@
 #include "gfx/screen.hpp"
 #include "misc/util.hpp"
 #include "misc/autogfreeptr.hpp"
+#include "misc/parallel.hpp"
+#include "cave/caveset.hpp"
+#include "settings.hpp"
 
 // TODO utf8-filename charset audit
 
@@ -110,13 +113,26 @@ SelectFileActivity::SelectFileActivity(App *app, const char *title, const char *
     title(title),
     for_save(for_save),
     defaultname(defaultname),
-    start_dir(start_dir ? start_dir : "") {
+    start_dir(start_dir ? start_dir : ""),
+    scanner(NULL) {
     yd = app->font_manager->get_line_height();
-    names_per_page = app->screen->get_height() / yd - 5;
     if (glob == NULL || g_str_equal(glob, ""))
         glob = "*";
     globs = g_strsplit_set(glob, ";", -1);
 
+    /* if selecting a caveset to load, show the information from the catalog.
+     * that needs a place to store it, and 6 more lines on the screen. */
+    show_catalog = false;
+    if (!for_save && gd_user_config_dir != "") {
+        for (int i = 0; globs[i] != NULL; i++)
+            for (int j = 0; gd_caveset_extensions[j] != NULL; j++)
+                if (g_str_equal(globs[i], gd_caveset_extensions[j]))
+                    show_catalog = true;
+    }
+    names_per_page = app->screen->get_height() / yd - (show_catalog ? 11 : 5);
+    if (show_catalog)
+        catalog.load();
+
     /* remember current directory, as we step into others */
     directory_of_process = g_get_current_dir();
     directory = g_strdup(directory_of_process);
@@ -132,11 +148,103 @@ void SelectFileActivity::pushed_event() {
 
 
 SelectFileActivity::~SelectFileActivity() {
+    stop_scanning();
+    if (show_catalog)
+        catalog.save();
     g_strfreev(globs);
 }
 
 
+/* check if the file is a caveset, which should be shown with its catalog entry. */
+bool SelectFileActivity::is_caveset_file(char const *name) const {
+    for (int i = 0; gd_caveset_extensions[i] != NULL; i++)
+        if (g_pattern_match_simple(gd_caveset_extensions[i], name))
+            return true;
+    return false;
+}
+
+
+/* read a caveset file for the catalog. runs in the background thread of the scanner. */
+void SelectFileActivity::scan_job(unsigned job, gpointer data) {
+    SelectFileActivity *activity = static_cast<SelectFileActivity *>(data);
+    activity->scan_results[job] = CavesetCatalogEntry::create(activity->scan_paths[job].c_str());
+}
+
+
+/* look up the files of the current directory in the catalog. the ones not found
+ * (or found with a different modification time or size) are read by the scanner. */
+void SelectFileActivity::start_scanning() {
+    file_entries.assign(files.size(), NULL);
+    if (!show_catalog)
+        return;
+    for (unsigned i = 0; i < files.size(); ++i) {
+        if (!is_caveset_file(files[i].c_str()))
+            continue;
+        AutoGFreePtr<char> path(g_build_path(G_DIR_SEPARATOR_S, directory, files[i].c_str(), NULL));
+        gint64 mtime, size;
+        if (!CavesetCatalogEntry::stat_file(path, mtime, size))
+            continue;
+        file_entries[i] = catalog.find((char *) path, mtime, size);
+        if (file_entries[i] == NULL) {
+            scan_files.push_back(i);
+            scan_paths.push_back((char *) path);
+        }
+    }
+    if (scan_files.empty())
+        return;
+    scan_results.resize(scan_files.size());
+    scan_merged.resize(scan_files.size(), false);
+    /* a single thread, so the game stays responsive */
+    scanner = new ParallelJobs(scan_files.size(), scan_job, this, 1);
+}
+
+
+/* put the files read by the scanner so far to the catalog.
+ * returns true, if any of the files shown on the current page is updated. */
+bool SelectFileActivity::merge_scanned() {
+    bool shown_changed = false;
+    unsigned page = sel / names_per_page;
+    for (unsigned job = 0; job < scan_files.size(); ++job) {
+        if (scan_merged[job] || !scanner->is_done(job))
+            continue;
+        catalog.store(scan_paths[job], scan_results[job]);
+        unsigned i = scan_files[job];
+        file_entries[i] = catalog.find(scan_paths[job], scan_results[job].mtime, scan_results[job].size);
+        scan_merged[job] = true;
+        if (i / names_per_page == page)
+            shown_changed = true;
+    }
+    return shown_changed;
+}
+
+
+/* stop reading the files of the current directory; the ones already read are kept. */
+void SelectFileActivity::stop_scanning() {
+    if (scanner == NULL)
+        return;
+    merge_scanned();
+    delete scanner;
+    scanner = NULL;
+    scan_files.clear();
+    scan_paths.clear();
+    scan_results.clear();
+    scan_merged.clear();
+}
+
+
+void SelectFileActivity::timer_event(int ms_elapsed) {
+    if (scanner == NULL)
+        return;
+    if (merge_scanned())
+        queue_redraw();
+    if (std::find(scan_merged.begin(), scan_merged.end(), false) == scan_merged.end())
+        stop_scanning();
+}
+
+
 void SelectFileActivity::jump_to_directory(char const *jump_to) {
+    stop_scanning();
+
     GDir *dir;
     /* directory we are looking at, and then to the selected one (which may be relative path!) */
     if (g_chdir(directory) == -1 || g_chdir(jump_to) == -1 || NULL == (dir = g_dir_open(".", 0, NULL))) {
@@ -192,6 +300,7 @@ void SelectFileActivity::jump_to_directory(char const *jump_to) {
     /* sort the array */
     sort(files.begin(), files.end(), filename_sort);
     sel = 0;
+    start_scanning();
 
     /* step back to directory where we started */
     g_chdir(directory_of_process);
@@ -201,6 +310,8 @@ void SelectFileActivity::jump_to_directory(char const *jump_to) {
 
 
 void SelectFileActivity::file_selected_do_command() {
+    /* the file loaders are not to be run by two threads at the same time */
+    stop_scanning();
     app->enqueue_command(command_when_successful);
     app->enqueue_command(new PopActivityCommand(app));
 }
@@ -331,11 +442,45 @@ void SelectFileActivity::redraw_event(bool full) const {
         if (cur < files.size()) {  /* may not be as much filenames as it would fit on the screen */
             app->set_color((cur == unsigned(sel)) ? GD_GDASH_YELLOW : GD_GDASH_LIGHTBLUE);
             app->blittext_n(app->font_manager->get_font_width_narrow(), (i + 3)*yd, files[cur].c_str());
+            if (file_entries[cur] != NULL && file_entries[cur]->loadable) {
+                std::string caves = SPrintf("%d") % file_entries[cur]->num_caves;
+                int x = app->screen->get_width() - (caves.length() + 2) * app->font_manager->get_font_width_narrow();
+                app->set_color(GD_GDASH_GRAY2);
+                app->blittext_n(x, (i + 3)*yd, caves.c_str());
+            }
         }
     }
 
     if (files.size() > names_per_page)
         app->draw_scrollbar(0, sel, files.size() - 1);
 
+    /* the catalog entry of the selected file: thumbnail of the first cave, name, author and number of caves. */
+    if (show_catalog && unsigned(sel) < files.size() && is_caveset_file(files[sel].c_str())) {
+        int y = (names_per_page + 3) * yd + yd / 2;
+        int x = app->font_manager->get_font_width_narrow();
+        CavesetCatalogEntry const *entry = file_entries[sel];
+        if (entry == NULL) {
+            app->set_color(GD_GDASH_GRAY2);
+            app->blittext_n(x, y, _("Reading file..."));
+        } else if (!entry->loadable) {
+            app->set_color(GD_GDASH_GRAY2);
+            app->blittext_n(x, y, _("Cannot load this file."));
+        } else {
+            int px = std::max(1, yd / 4);
+            for (unsigned ty = 0; ty < entry->thumbnail_height; ++ty)
+                for (unsigned tx = 0; tx < entry->thumbnail_width; ++tx) {
+                    guint32 c = entry->colors[entry->thumbnail[ty * entry->thumbnail_width + tx] - '0'];
+                    app->screen->fill_rect(x + tx * px, y + ty * px, px, px, GdColor::from_rgb((c >> 16) & 0xff, (c >> 8) & 0xff, c & 0xff));
+                }
+            x += (CavesetCatalogEntry::ThumbnailMaxWidth * px) + app->font_manager->get_font_width_narrow();
+            app->set_color(GD_GDASH_YELLOW);
+            app->blittext_n(x, y, entry->name.c_str());
+            app->set_color(GD_GDASH_LIGHTBLUE);
+            app->blittext_n(x, y + yd, entry->author.c_str());
+            app->set_color(GD_GDASH_GRAY2);
+            app->blittext_n(x, y + 2 * yd, CPrintf(ngettext("%d cave", "%d caves", entry->num_caves)) % entry->num_caves);
+        }
+    }
+
     app->screen->drawing_finished();
 }
@@ -29,8 +29,10 @@
 
 #include "framework/activity.hpp"
 #include "misc/smartptr.hpp"
+#include "fileops/cavesetcatalog.hpp"
 
 template <typename T> class Command1Param;
+class ParallelJobs;
 
 /**
  * Allow the user to select a file (maybe type the name of a new file),
@@ -53,6 +55,7 @@ public:
     virtual void keypress_event(KeyCode keycode, int gfxlib_keycode);
     virtual void redraw_event(bool full) const;
     virtual void pushed_event();
+    virtual void timer_event(int ms_elapsed);
 
     void jump_to_directory(char const *jump_to);
     void file_selected(char const *filename);
@@ -73,8 +76,25 @@ private:
     std::string defaultname;
     std::string start_dir;
 
+    /* the catalog of caveset files; used only when selecting a caveset to load. */
+    bool show_catalog;
+    CavesetCatalog catalog;
+    /* the catalog entry of each file, or NULL if not (yet) known */
+    std::vector<CavesetCatalogEntry const *> file_entries;
+    /* the files of the directory not found in the catalog are read in the background, one by one. */
+    ParallelJobs *scanner;
+    std::vector<unsigned> scan_files;
+    std::vector<std::string> scan_paths;
+    std::vector<CavesetCatalogEntry> scan_results;
+    std::vector<bool> scan_merged;
+
     void read_dir();
     void process_enter();
+    bool is_caveset_file(char const *name) const;
+    void start_scanning();
+    bool merge_scanned();
+    void stop_scanning();
+    static void scan_job(unsigned job, gpointer data);
 };
 
 #endif
@@ -68,8 +68,8 @@ void TitleScreenActivity::release_pixmaps() {
 
 
 void TitleScreenActivity::render_animation() const {
-    if (animation.empty()) {
-        animation = get_title_animation_pixmap(app->caveset->title_screen, app->caveset->title_screen_scroll, false, *app->screen, app->screen->pixbuf_factory);
+    if (animation.get() == NULL) {
+        animation.reset(new TitleAnimation(app->caveset->title_screen, app->caveset->title_screen_scroll, *app->screen, gd_stream_title_animation));
         /* this is required because the caveset might have changed since the last redraw, and
          * thus the title screen might have changed, and the new title screen might have fewer
          * frames than the original. */
@@ -79,9 +79,7 @@ void TitleScreenActivity::render_animation() const {
 
 
 void TitleScreenActivity::clear_animation() {
-    for (unsigned x = 0; x < animation.size(); x++)
-        delete animation[x];
-    animation.clear();
+    animation.reset();
 }
 
 
@@ -93,7 +91,7 @@ void TitleScreenActivity::shown_event() {
     render_animation();
 
     /* height of title screen, then decide which lines to show and where */
-    image_h = animation[0]->get_height();
+    image_h = animation->get_height();
     int font_h = app->font_manager->get_font_height();
     /* less than 2 lines left - place for only one line of text. */
     if (app->screen->get_height() - image_h < 2 * font_h) {
@@ -138,13 +136,13 @@ void TitleScreenActivity::redraw_event(bool full) const {
         app->blittext_n(0, y_gameline, CPrintf("%c%s: %c%s %c%s") % GD_COLOR_INDEX_WHITE % _("Game") % GD_COLOR_INDEX_YELLOW % app->caveset->name % GD_COLOR_INDEX_RED % (app->caveset->edited ? "*" : ""));
     }
 
-    int dx = (app->screen->get_width() - animation[animcycle]->get_width()) / 2; /* centered horizontally */
+    int dx = (app->screen->get_width() - animation->get_width()) / 2; /* centered horizontally */
     int dy;
-    if (animation[animcycle]->get_height() < image_centered_threshold)
-        dy = (image_centered_threshold - animation[animcycle]->get_height()) / 2; /* centered vertically */
+    if (animation->get_height() < image_centered_threshold)
+        dy = (image_centered_threshold - animation->get_height()) / 2; /* centered vertically */
     else
         dy = 0; /* top of screen, as not too much space was left for info lines */
-    app->screen->blit(*animation[animcycle], dx, dy);
+    app->screen->blit(animation->get_frame(animcycle), dx, dy);
 
     if (show_status) {
         if (get_active_logger().empty()) {
@@ -219,7 +217,8 @@ void TitleScreenActivity::timer_event(int ms_elapsed) {
     time_ms += ms_elapsed;
     if (time_ms >= 40) {
         time_ms -= 40;
-        animcycle = (animcycle + 1) % animation.size();
+        if (animation.get() != NULL)
+            animcycle = (animcycle + 1) % animation->get_frame_count();
         frames++;
         if (frames > 100) {
             frames = 0;
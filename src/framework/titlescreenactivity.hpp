@@ -27,9 +27,9 @@
 #include "framework/activity.hpp"
 #include "gfx/pixmapstorage.hpp"
 
-#include <vector>
+#include <memory>
 
-class Pixmap;
+class TitleAnimation;
 
 class TitleScreenActivity: public Activity, public PixmapStorage {
 public:
@@ -47,7 +47,7 @@ public:
 private:
     const int scale;
     const int image_centered_threshold;
-    mutable std::vector<Pixmap *> animation;
+    mutable std::auto_ptr<TitleAnimation> animation;
     int frames, time_ms;
     mutable int animcycle;
     /* positions on screen */
@@ -24,10 +24,18 @@
 #include "config.h"
 
 #include <memory>
+#include <map>
+#include <algorithm>
 
 #include "gfx/cellrenderer.hpp"
 
+#include "misc/autogfreeptr.hpp"
 #include "misc/logger.hpp"
+#include "misc/parallel.hpp"
+#include "misc/printf.hpp"
+#include "misc/util.hpp"
+#include "settings.hpp"
+#include "gfx/cellsheetcache.hpp"
 #include "gfx/pixbuf.hpp"
 #include "gfx/pixbuffactory.hpp"
 #include "gfx/screen.hpp"
@@ -63,6 +71,8 @@ CellRenderer::~CellRenderer() {
 
 /** Remove colored Pixbufs and Pixmaps created. */
 void CellRenderer::remove_cached() {
+    /* the background scaling uses the cell pixbufs */
+    stop_prescale();
     for (unsigned i = 0; i < G_N_ELEMENTS(cells_pixbufs); ++i) {
         delete cells_pixbufs[i];
         cells_pixbufs[i] = NULL;
@@ -76,10 +86,33 @@ void CellRenderer::remove_cached() {
 
 
 void CellRenderer::release_pixmaps() {
+    stop_prescale();
     for (unsigned i = 0; i < G_N_ELEMENTS(cells); ++i) {
         delete cells[i];
         cells[i] = 0;
     }
+    /* the scaling might have also changed */
+    if (!sheet_key.empty())
+        CellSheetCache::instance().flush(sheet_key);
+    sheet_key = "";
+}
+
+
+/** Returns the key of the currently used theme, colors and scaling
+ * in the cache of scaled cells. */
+const std::string &CellRenderer::get_sheet_key() {
+    if (sheet_key.empty()) {
+        std::string colors;
+        if (is_c64_colored)
+            colors = SPrintf("%06x-%06x-%06x-%06x-%06x-%06x")
+                     % color0.get_uint_0rgb() % color1.get_uint_0rgb() % color2.get_uint_0rgb()
+                     % color3.get_uint_0rgb() % color4.get_uint_0rgb() % color5.get_uint_0rgb();
+        sheet_key = SPrintf("%s-%s-%s-%dx-%d-%d-%d")
+                    % sheet_cache_variant() % theme_hash % colors
+                    % screen.get_pixmap_scale() % int(screen.get_scaling_type())
+                    % screen.get_pal_emulation() % (screen.get_pal_emulation() ? gd_pal_emu_scanline_shade : 0);
+    }
+    return sheet_key;
 }
 
 
@@ -94,35 +127,128 @@ Pixbuf &CellRenderer::cell_pixbuf(unsigned i) {
     return *cells_pixbufs[i];
 }
 
+/** Create the pixbuf, which is to be scaled to get cell i. For the normal cells,
+ * this is NULL, as the cell pixbuf can be used as it is. For flashing and
+ * selected cells, it is a newly allocated, colored version of the cell pixbuf. */
+Pixbuf *CellRenderer::create_colored_cell_pixbuf(unsigned i) {
+    int type = i / NUM_OF_CELLS;  // 0=normal, 1=colored1, 2=colored2
+    int index = i % NUM_OF_CELLS;
+    Pixbuf &pb = cell_pixbuf(index);
+
+    switch (type) {
+        case 0:
+            return NULL;
+        case 1:
+            return screen.pixbuf_factory.create_composite_color(pb, gd_flash_color);
+        case 2:
+            return screen.pixbuf_factory.create_composite_color(pb, gd_select_color);
+        default:
+            g_assert_not_reached();
+            return NULL;
+    }
+}
+
+
 Pixmap &CellRenderer::cell(unsigned i) {
     g_assert(i < G_N_ELEMENTS(cells));
     if (cells[i] == NULL) {
-        int type = i / NUM_OF_CELLS;  // 0=normal, 1=colored1, 2=colored2
-        int index = i % NUM_OF_CELLS;
-        Pixbuf &pb = cell_pixbuf(index);    // this is to be rendered as a pixmap, but may be colored
-
-        switch (type) {
-            case 0:
-                cells[i] = screen.create_scaled_pixmap_from_pixbuf(pb, false);
-                break;
-            case 1: {
-                std::auto_ptr<Pixbuf> colored(screen.pixbuf_factory.create_composite_color(pb, gd_flash_color));
-                cells[i] = screen.create_scaled_pixmap_from_pixbuf(*colored, false);
-            }
-            break;
-            case 2: {
-                std::auto_ptr<Pixbuf> colored(screen.pixbuf_factory.create_composite_color(pb, gd_select_color));
-                cells[i] = screen.create_scaled_pixmap_from_pixbuf(*colored, false);
-            }
-            break;
-            default:
-                g_assert_not_reached();
-                break;
+        /* maybe it was already scaled with the same theme, colors and scaling */
+        CellSheetCache::Sheet &sheet = CellSheetCache::instance().get(get_sheet_key(), get_cell_size(), G_N_ELEMENTS(cells));
+        if (sheet.has_cell(i)) {
+            std::auto_ptr<Pixbuf> scaled(sheet.create_cell(screen.pixbuf_factory, i));
+            cells[i] = screen.create_pixmap_from_pixbuf(*scaled, false);
+            return *cells[i];
+        }
+
+        std::auto_ptr<Pixbuf> scaled;
+        if (prescale.jobs != NULL && prescale.job_of_cell[i] != -1) {
+            /* scaled (or being scaled) in the background */
+            prescale.jobs->finish(prescale.job_of_cell[i]);
+            scaled.reset(prescale.scaled[prescale.job_of_cell[i]]);
+            prescale.scaled[prescale.job_of_cell[i]] = NULL;
+            prescale.job_of_cell[i] = -1;
+        } else {
+            /* this is to be rendered as a pixmap, but may be colored */
+            std::auto_ptr<Pixbuf> colored(create_colored_cell_pixbuf(i));
+            Pixbuf &pb = colored.get() != NULL ? *colored : cell_pixbuf(i % NUM_OF_CELLS);
+            scaled.reset(screen.pixbuf_factory.create_scaled(pb, screen.get_pixmap_scale(), screen.get_scaling_type(), screen.get_pal_emulation()));
         }
+        sheet.store_cell(i, *scaled);
+        cells[i] = screen.create_pixmap_from_pixbuf(*scaled, false);
     }
     return *cells[i];
 }
 
+
+/* scales one cell for prescale_cells(), on a worker thread. */
+void CellRenderer::prescale_job(unsigned job, gpointer data) {
+    CellRenderer *cr = static_cast<CellRenderer *>(data);
+    Screen const &screen = cr->screen;
+    cr->prescale.scaled[job] = screen.pixbuf_factory.create_scaled(*cr->prescale.sources[job], screen.get_pixmap_scale(), screen.get_scaling_type(), screen.get_pal_emulation());
+}
+
+
+void CellRenderer::prescale_cells() {
+    stop_prescale();
+
+    /* the workers must not create or modify anything in the cell renderer,
+     * so all pixbufs they read are created here. */
+    CellSheetCache::Sheet &sheet = CellSheetCache::instance().get(get_sheet_key(), get_cell_size(), G_N_ELEMENTS(cells));
+    prescale.job_of_cell.assign(G_N_ELEMENTS(cells), -1);
+    for (unsigned i = 0; i < G_N_ELEMENTS(cells); ++i) {
+        if (cells[i] != NULL || sheet.has_cell(i))
+            continue;
+        Pixbuf *colored = create_colored_cell_pixbuf(i);
+        if (colored != NULL)
+            prescale.colored.push_back(colored);
+        prescale.job_of_cell[i] = prescale.sources.size();
+        prescale.sources.push_back(colored != NULL ? colored : &cell_pixbuf(i % NUM_OF_CELLS));
+    }
+    if (prescale.sources.empty())
+        return;
+    prescale.scaled.assign(prescale.sources.size(), NULL);
+
+    /* leave a processor for the game itself */
+    unsigned threads = std::max(ParallelJobs::get_num_processors() - 1, 1u);
+    prescale.jobs = new ParallelJobs(prescale.sources.size(), prescale_job, this, threads);
+}
+
+
+/** Stop the background scaling started by prescale_cells(). The cells already
+ * scaled are put into the cell sheet cache; the others are forgotten. */
+void CellRenderer::stop_prescale() {
+    if (prescale.jobs == NULL)
+        return;
+
+    delete prescale.jobs;
+    prescale.jobs = NULL;
+    CellSheetCache::Sheet &sheet = CellSheetCache::instance().get(get_sheet_key(), get_cell_size(), G_N_ELEMENTS(cells));
+    for (unsigned i = 0; i < prescale.job_of_cell.size(); ++i) {
+        int job = prescale.job_of_cell[i];
+        if (job != -1 && prescale.scaled[job] != NULL) {
+            sheet.store_cell(i, *prescale.scaled[job]);
+            delete prescale.scaled[job];
+        }
+    }
+    for (unsigned i = 0; i < prescale.colored.size(); ++i)
+        delete prescale.colored[i];
+    prescale.job_of_cell.clear();
+    prescale.sources.clear();
+    prescale.colored.clear();
+    prescale.scaled.clear();
+}
+
+/* calculates a hash of the pixel data of the pixbuf. */
+static std::string pixbuf_hash(Pixbuf const &pb) {
+    GChecksum *checksum = g_checksum_new(G_CHECKSUM_MD5);
+    for (int y = 0; y < pb.get_height(); ++y)
+        g_checksum_update(checksum, (guchar const *) pb.get_row(y), pb.get_width() * sizeof(guint32));
+    std::string hash = SPrintf("%dx%d-%s") % pb.get_width() % pb.get_height() % g_checksum_get_string(checksum);
+    g_checksum_free(checksum);
+    return hash;
+}
+
+
 /* check if given surface is ok to be a gdash theme. */
 bool CellRenderer::is_pixbuf_ok_for_theme(const Pixbuf &surface) {
     if ((surface.get_width() % NUM_OF_CELLS_X != 0)
@@ -165,16 +291,20 @@ bool CellRenderer::loadcells_image(Pixbuf *image) {
     /* load new stuff */
     cell_size = image->get_width() / NUM_OF_CELLS_X;
     loaded = image;
+    theme_hash = pixbuf_hash(*loaded);
 
     if (check_if_pixbuf_c64_png(*loaded)) {
         /* c64 pixbuf with a small number of colors which can be changed */
         cells_all = NULL;
         is_c64_colored = true;
+        create_colorize_indexes();
     } else {
         /* normal, "truecolor" pixbuf */
         cells_all = loaded;
         loaded = NULL;
         is_c64_colored = false;
+        colorize_entries.clear();
+        colorize_indexes.clear();
     }
     return true;
 }
@@ -271,13 +401,65 @@ bool CellRenderer::check_if_pixbuf_c64_png(Pixbuf const &image) {
 }
 
 
-/** This function takes the loaded image, and transforms it using the selected
- * cave colors, to create cells_all.
+/** This function takes the loaded image, and creates the colorize index
+ * image for it, which is used by create_colorized_cells() for every new
+ * color theme. It is called only once per theme.
+ *
+ * All pixels are converted to HSV (hue, saturation, value). The hues of the
+ * pixels should be 0 (red), 60 (yellow), 120 (green) etc, n*60. This way will
+ * the routine recognize the colors: the hue selects the cave color to use,
+ * and the saturation and the value are stored to modulate the cave color later.
+ * As a c64 theme image can only have 0 and 255 as color components, there are
+ * only a few distinct pixels in the image. These are collected in
+ * colorize_entries, and every pixel of the image is stored as an index into it. */
+void CellRenderer::create_colorize_indexes() {
+    g_assert(is_c64_colored);
+    g_assert(loaded != NULL);
+
+    int w = loaded->get_width(), h = loaded->get_height();
+    std::map<guint32, unsigned char> entry_of_pixel;
+    colorize_entries.clear();
+    colorize_indexes.resize(w * h);
+
+    for (int y = 0; y < h; y++) {
+        const guint32 *p = loaded->get_row(y);
+        unsigned char *to = &colorize_indexes[y * w];
+        for (int x = 0; x < w; x++) {
+            std::map<guint32, unsigned char>::const_iterator it = entry_of_pixel.find(p[x]);
+            if (it != entry_of_pixel.end()) {
+                to[x] = it->second;
+                continue;
+            }
+
+            /* rgb values found in image */
+            unsigned r = (p[x] & loaded->rmask) >> loaded->rshift;
+            unsigned g = (p[x] & loaded->gmask) >> loaded->gshift;
+            unsigned b = (p[x] & loaded->bmask) >> loaded->bshift;
+            unsigned a = (p[x] & loaded->amask) >> loaded->ashift;
+            unsigned short inh;
+            unsigned char ins, inv;
+            GdColor::from_rgb(r, g, b).get_hsv(inh, ins, inv);
+
+            /* the color code from the original image (essentially the hue) will select the color index */
+            ColorizeEntry e;
+            e.index = c64_color_index(inh, ins, inv, a);
+            e.s = ins;
+            e.v = inv;
+            e.a = a;
+            /* 0 and 255 for rgba make 16 different pixels at most */
+            g_assert(colorize_entries.size() < 256);
+            entry_of_pixel[p[x]] = colorize_entries.size();
+            to[x] = colorize_entries.size();
+            colorize_entries.push_back(e);
+        }
+    }
+}
+
+
+/** This function takes the colorize index image of the loaded image, and
+ * transforms it using the selected cave colors, to create cells_all.
  *
- * The process is as follows. All pixels are converted to HSV (hue, saturation,
- * value). The hues of the pixels should be 0 (red), 60 (yellow), 120 (green)
- * etc, n*60. This way will the routine recognize the colors.
- * After converting the pixels to HSV, the hue selects the cave color to use.
+ * The color index of the pixel selects the cave color to use.
  * The resulting color will use the hue of the selected cave color, the product
  * of the saturations of the cave color and the original color, and the
  * product of the values:
@@ -288,7 +470,10 @@ bool CellRenderer::check_if_pixbuf_c64_png(Pixbuf const &image) {
  *
  * This allows for modulating the cave colors in saturation and value. If the
  * loaded image contains a dark purple color instead of RGB(255;0;255) purple,
- * the cave color will also be darkened at that pixel and so on. */
+ * the cave color will also be darkened at that pixel and so on.
+ *
+ * The resulting color is only calculated once for every distinct pixel
+ * of the image; the pixels themselves are then looked up from that table. */
 void CellRenderer::create_colorized_cells() {
     g_assert(is_c64_colored);
     g_assert(loaded != NULL);
@@ -322,39 +507,31 @@ void CellRenderer::create_colorized_cells() {
     int w = loaded->get_width(), h = loaded->get_height();
     cells_all = screen.pixbuf_factory.create(w, h);
 
-    for (int y = 0; y < h; y++) {
-        const guint32 *p = loaded->get_row(y);
-        guint32 *to = cells_all->get_row(y);
-        for (int x = 0; x < w; x++) {
-            /* rgb values found in image */
-            unsigned r = (p[x] & loaded->rmask) >> loaded->rshift;
-            unsigned g = (p[x] & loaded->gmask) >> loaded->gshift;
-            unsigned b = (p[x] & loaded->bmask) >> loaded->bshift;
-            unsigned a = (p[x] & loaded->amask) >> loaded->ashift;
-            unsigned short inh;
-            unsigned char ins, inv;
-            GdColor::from_rgb(r, g, b).get_hsv(inh, ins, inv);
-
-            /* the color code from the original image (essentially the hue) will select the color index */
-            unsigned index = c64_color_index(inh, ins, inv, a);
-
-            /* and then shade it, and convert to rgb */
-            unsigned char resr, resg, resb;
-            if (index == 0 || index >= 6) {
-                /* for the background and the editor colors, no shading is used */
-                colsrgb[index].get_rgb(resr, resg, resb);
-            } else {
-                /* otherwise the saturation and value from the original image will modify it */
-                unsigned short pixh;
-                unsigned char pixs, pixv;
-                colshsv[index].get_hsv(pixh, pixs, pixv);
-                GdColor::from_hsv(pixh, pixs * ins / 100, pixv * inv / 100).get_rgb(resr, resg, resb);
-            }
+    /* the new color of every distinct pixel */
+    guint32 lookup[256];
+    for (unsigned i = 0; i < colorize_entries.size(); i++) {
+        ColorizeEntry const &e = colorize_entries[i];
+
+        /* shade it, and convert to rgb */
+        unsigned char resr, resg, resb;
+        if (e.index == 0 || e.index >= 6) {
+            /* for the background and the editor colors, no shading is used */
+            colsrgb[e.index].get_rgb(resr, resg, resb);
+        } else {
+            /* otherwise the saturation and value from the original image will modify it */
+            unsigned short pixh;
+            unsigned char pixs, pixv;
+            colshsv[e.index].get_hsv(pixh, pixs, pixv);
+            GdColor::from_hsv(pixh, pixs * e.s / 100, pixv * e.v / 100).get_rgb(resr, resg, resb);
+        }
 
-            guint32 newcolword =
-                resr << cells_all->rshift | resg << cells_all->gshift | resb << cells_all->bshift | a << cells_all->ashift;
+        lookup[i] = resr << cells_all->rshift | resg << cells_all->gshift | resb << cells_all->bshift | e.a << cells_all->ashift;
+    }
 
-            to[x] = newcolword;
-        }
+    for (int y = 0; y < h; y++) {
+        const unsigned char *p = &colorize_indexes[y * w];
+        guint32 *to = cells_all->get_row(y);
+        for (int x = 0; x < w; x++)
+            to[x] = lookup[p[x]];
     }
 }
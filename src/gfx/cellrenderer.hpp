@@ -26,6 +26,7 @@
 #ifndef CELLRENDERER_HPP_INCLUDED
 #define CELLRENDERER_HPP_INCLUDED
 
+#include <string>
 #include <vector>
 
 #include "cave/cavetypes.hpp"
@@ -33,6 +34,7 @@
 #include "gfx/pixmapstorage.hpp"
 
 class PixbufFactory;
+class ParallelJobs;
 class Pixbuf;
 class Pixmap;
 class Screen;
@@ -58,19 +60,61 @@ protected:
     /// The size of the loaded pixbufs
     unsigned cell_size;
 
+    /// Hash of the loaded theme image, for the scaled cell cache.
+    std::string theme_hash;
+
+    /// Key of the scaled cells in the CellSheetCache; empty, if not yet determined.
+    std::string sheet_key;
+
     /// The cache to store the pixbufs already rendered.
     Pixbuf *cells_pixbufs[NUM_OF_CELLS];
 
     /// The cache to store the pixbufs already rendered.
     Pixmap *cells[3 * NUM_OF_CELLS];
 
+    /// Cells being scaled in the background, started by prescale_cells().
+    struct Prescale {
+        /// The background jobs; NULL if not scaling in the background.
+        ParallelJobs *jobs;
+        /// For each cell, the number of its job, or -1 if it has no job.
+        std::vector<int> job_of_cell;
+        /// For each job, the pixbuf to be scaled.
+        std::vector<Pixbuf *> sources;
+        /// The colored pixbufs created for the jobs, to be deleted.
+        std::vector<Pixbuf *> colored;
+        /// For each job, the result of the scaling; moved to the cell, when requested.
+        std::vector<Pixbuf *> scaled;
+        Prescale() : jobs(NULL) {}
+    } prescale;
+
     /// If using c64 gfx, these store the current color theme.
     GdColor color0, color1, color2, color3, color4, color5;
 
+    /// A distinct pixel of the loaded c64 image, already split into
+    /// cave color index, saturation, value and alpha.
+    struct ColorizeEntry {
+        unsigned char index, s, v, a;
+    };
+    /// The distinct pixels of the loaded c64 image.
+    std::vector<ColorizeEntry> colorize_entries;
+    /// For every pixel of the loaded c64 image, an index into colorize_entries.
+    std::vector<unsigned char> colorize_indexes;
+
+    void create_colorize_indexes();
     void create_colorized_cells();
     bool loadcells_image(Pixbuf *loadcells_image);
     bool loadcells_file(const std::string &filename);
     virtual void remove_cached();
+    const std::string &get_sheet_key();
+    Pixbuf *create_colored_cell_pixbuf(unsigned i);
+    static void prescale_job(unsigned job, gpointer data);
+    void stop_prescale();
+
+    /// Derived classes which modify the cell pixbufs must return a different
+    /// string here, so their scaled cells are cached separately.
+    virtual const char *sheet_cache_variant() const {
+        return "game";
+    }
 
     CellRenderer(const CellRenderer &); // not implemented
     CellRenderer &operator=(const CellRenderer &);  // not implemented
@@ -98,6 +142,12 @@ public:
     /// @brief Returns a particular cell.
     Pixmap &cell(unsigned i);
 
+    /// @brief Start scaling all cells in the background, on worker threads.
+    /// The cells already scaled need not be scaled by cell() anymore, so the
+    /// game does not stutter when a cell is first drawn. The scaling is stopped
+    /// when the colors or the theme are changed.
+    void prescale_cells();
+
     /// @brief Returns the size of the pixmaps stored.
     /// They are squares, so there is only one function, not two for width and height.
     int get_cell_size();
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <cstring>
+
+#include "gfx/cellsheetcache.hpp"
+#include "gfx/pixbuf.hpp"
+#include "gfx/pixbuffactory.hpp"
+#include "misc/autogfreeptr.hpp"
+#include "misc/logger.hpp"
+#include "misc/printf.hpp"
+#include "misc/util.hpp"
+#include "settings.hpp"
+
+
+/* the sheets are kept in this subdirectory of the config dir. */
+#define CELL_SHEET_CACHE_DIR "cellcache"
+/* file format: magic, then version, cell size, number of cells and number of
+ * stored cells as 32-bit integers. then for each stored cell, its index and
+ * the pixel data. */
+static char const cell_sheet_magic[4] = { 'G', 'D', 'C', 'S' };
+static guint32 const cell_sheet_version = 1;
+
+
+CellSheetCache::Sheet::Sheet(std::string const &key, int cell_size, unsigned num_cells)
+    :   key(key),
+        cell_size(cell_size),
+        cells(num_cells),
+        dirty(false) {
+}
+
+
+size_t CellSheetCache::Sheet::memory_size() const {
+    size_t size = 0;
+    for (unsigned i = 0; i < cells.size(); ++i)
+        size += cells[i].size() * sizeof(guint32);
+    return size;
+}
+
+
+Pixbuf *CellSheetCache::Sheet::create_cell(PixbufFactory const &pixbuf_factory, unsigned i) const {
+    g_assert(has_cell(i));
+    Pixbuf *pb = pixbuf_factory.create(cell_size, cell_size);
+    for (int y = 0; y < cell_size; ++y)
+        memcpy(pb->get_row(y), &cells[i][y * cell_size], cell_size * sizeof(guint32));
+    return pb;
+}
+
+
+void CellSheetCache::Sheet::store_cell(unsigned i, Pixbuf const &pb) {
+    g_assert(pb.get_width() == cell_size && pb.get_height() == cell_size);
+    cells[i].resize(cell_size * cell_size);
+    for (int y = 0; y < cell_size; ++y)
+        memcpy(&cells[i][y * cell_size], pb.get_row(y), cell_size * sizeof(guint32));
+    dirty = true;
+}
+
+
+/** Load cells of the sheet from a cache file.
+ * @return true, if the file was found and it was ok. */
+bool CellSheetCache::Sheet::load(std::string const &filename) {
+    gchar *contents;
+    gsize length;
+    if (!g_file_get_contents(filename.c_str(), &contents, &length, NULL))
+        return false;
+    AutoGFreePtr<gchar> data(contents);
+
+    guint32 header[4];
+    if (length < sizeof(cell_sheet_magic) + sizeof(header) || memcmp(contents, cell_sheet_magic, sizeof(cell_sheet_magic)) != 0)
+        return false;
+    memcpy(header, contents + sizeof(cell_sheet_magic), sizeof(header));
+    if (header[0] != cell_sheet_version || header[1] != guint32(cell_size) || header[2] != cells.size())
+        return false;
+    size_t cell_bytes = cell_size * cell_size * sizeof(guint32);
+    size_t pos = sizeof(cell_sheet_magic) + sizeof(header);
+    if (length != pos + header[3] * (sizeof(guint32) + cell_bytes))
+        return false;
+
+    for (unsigned n = 0; n < header[3]; ++n) {
+        guint32 index;
+        memcpy(&index, contents + pos, sizeof(index));
+        pos += sizeof(index);
+        if (index >= cells.size())
+            return false;
+        cells[index].resize(cell_size * cell_size);
+        memcpy(&cells[index][0], contents + pos, cell_bytes);
+        pos += cell_bytes;
+    }
+    dirty = false;
+    return true;
+}
+
+
+/** Save the cells stored in the sheet to a cache file. */
+void CellSheetCache::Sheet::save(std::string const &filename) {
+    guint32 header[4] = { cell_sheet_version, guint32(cell_size), guint32(cells.size()), 0 };
+    for (unsigned i = 0; i < cells.size(); ++i)
+        if (has_cell(i))
+            header[3]++;
+
+    std::vector<char> out;
+    out.reserve(sizeof(cell_sheet_magic) + sizeof(header) + memory_size() + header[3] * sizeof(guint32));
+    out.insert(out.end(), cell_sheet_magic, cell_sheet_magic + sizeof(cell_sheet_magic));
+    out.insert(out.end(), (char const *) header, (char const *) header + sizeof(header));
+    for (unsigned i = 0; i < cells.size(); ++i) {
+        if (!has_cell(i))
+            continue;
+        guint32 index = i;
+        out.insert(out.end(), (char const *) &index, (char const *) &index + sizeof(index));
+        out.insert(out.end(), (char const *) &cells[i][0], (char const *) &cells[i][0] + cells[i].size() * sizeof(guint32));
+    }
+
+    GError *error = NULL;
+    if (!g_file_set_contents(filename.c_str(), &out[0], out.size(), &error)) {
+        gd_debug(CPrintf("Unable to save cell cache: %s") % error->message);
+        g_error_free(error);
+        return;
+    }
+    dirty = false;
+}
+
+
+CellSheetCache::CellSheetCache(size_t max_bytes)
+    :   max_bytes(max_bytes) {
+}
+
+
+CellSheetCache::~CellSheetCache() {
+    for (std::list<Sheet>::iterator it = sheets.begin(); it != sheets.end(); ++it)
+        flush_sheet(*it);
+}
+
+
+CellSheetCache &CellSheetCache::instance() {
+    /* 64 MiB is enough for a few fully scaled themes at 4x. */
+    static CellSheetCache cache(64 * 1024 * 1024);
+    return cache;
+}
+
+
+std::string CellSheetCache::filename_for_key(std::string const &key) const {
+    /* the key may be long and contains all kinds of characters, so its hash is used as the file name. */
+    AutoGFreePtr<char> hash(g_compute_checksum_for_data(G_CHECKSUM_MD5, (guchar const *) key.c_str(), key.size()));
+    AutoGFreePtr<char> fname(g_strdup_printf("%s.cells", (char *) hash));
+    return gd_tostring_free(g_build_path(G_DIR_SEPARATOR_S, gd_user_config_dir.c_str(), CELL_SHEET_CACHE_DIR, (char *) fname, NULL));
+}
+
+
+CellSheetCache::Sheet &CellSheetCache::get(std::string const &key, int cell_size, unsigned num_cells) {
+    /* if found, move to the front */
+    for (std::list<Sheet>::iterator it = sheets.begin(); it != sheets.end(); ++it) {
+        if (it->key == key && it->cell_size == cell_size && it->cells.size() == num_cells) {
+            sheets.splice(sheets.begin(), sheets, it);
+            return sheets.front();
+        }
+    }
+
+    /* not found, so create a new one - maybe it is on the disk */
+    sheets.push_front(Sheet(key, cell_size, num_cells));
+    if (gd_cell_sheet_cache_on_disk)
+        sheets.front().load(filename_for_key(key));
+
+    /* and drop the least recently used ones, if using too much memory. the new one is never dropped. */
+    size_t size = 0;
+    for (std::list<Sheet>::iterator it = sheets.begin(); it != sheets.end();) {
+        size += it->memory_size();
+        if (it != sheets.begin() && size > max_bytes) {
+            flush_sheet(*it);
+            it = sheets.erase(it);
+        } else
+            ++it;
+    }
+
+    return sheets.front();
+}
+
+
+void CellSheetCache::flush(std::string const &key) {
+    for (std::list<Sheet>::iterator it = sheets.begin(); it != sheets.end(); ++it)
+        if (it->key == key)
+            flush_sheet(*it);
+}
+
+
+void CellSheetCache::flush_sheet(Sheet &sheet) {
+    if (!gd_cell_sheet_cache_on_disk || !sheet.dirty)
+        return;
+    AutoGFreePtr<char> dir(g_build_path(G_DIR_SEPARATOR_S, gd_user_config_dir.c_str(), CELL_SHEET_CACHE_DIR, NULL));
+    g_mkdir_with_parents(dir, 0700);
+    sheet.save(filename_for_key(sheet.key));
+}
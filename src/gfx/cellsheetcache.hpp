@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#ifndef CELLSHEETCACHE_HPP_INCLUDED
+#define CELLSHEETCACHE_HPP_INCLUDED
+
+#include <glib.h>
+#include <list>
+#include <string>
+#include <vector>
+
+class Pixbuf;
+class PixbufFactory;
+
+/// @ingroup Graphics
+/// @brief A cache of scaled (and colorized) cell pixbufs.
+///
+/// A sheet of cells is identified by a key string, which the CellRenderer
+/// composes from everything that affects the look of the scaled cells:
+/// the hash of the theme image, the six cave colors, the scaling factor,
+/// the scaling type and the pal emulation setting. The cells of a sheet
+/// are filled in one by one, as the CellRenderer scales them.
+///
+/// The sheets are kept in memory, and the least recently used ones are
+/// dropped when the cache grows too large. If gd_cell_sheet_cache_on_disk is
+/// set, sheets are also saved to and loaded from the user config directory,
+/// so they survive a restart of the program.
+class CellSheetCache {
+public:
+    /// A sheet of scaled cells.
+    class Sheet {
+    private:
+        std::string key;
+        /// Width and height of a scaled cell.
+        int cell_size;
+        /// Pixel data of the cells, in Pixbuf memory format. Empty for cells not yet stored.
+        std::vector<std::vector<guint32> > cells;
+        /// True, if the sheet has cells not yet saved to the disk.
+        bool dirty;
+
+        friend class CellSheetCache;
+        Sheet(std::string const &key, int cell_size, unsigned num_cells);
+        size_t memory_size() const;
+        bool load(std::string const &filename);
+        void save(std::string const &filename);
+
+    public:
+        /// Check if cell i is already in the sheet.
+        bool has_cell(unsigned i) const {
+            return !cells[i].empty();
+        }
+        /// Create a new pixbuf with the contents of cell i.
+        Pixbuf *create_cell(PixbufFactory const &pixbuf_factory, unsigned i) const;
+        /// Store the scaled pixbuf as cell i.
+        void store_cell(unsigned i, Pixbuf const &pb);
+    };
+
+    /// Create a cache which keeps sheets up to max_bytes in memory.
+    explicit CellSheetCache(size_t max_bytes);
+    ~CellSheetCache();
+
+    /// Get the sheet for the key; if not in memory (or on disk), an empty one is created.
+    /// The returned reference is valid until the next call of get().
+    Sheet &get(std::string const &key, int cell_size, unsigned num_cells);
+
+    /// Save the sheet to the disk, if enabled and if the sheet has new cells.
+    void flush(std::string const &key);
+
+    /// The process-wide cache used by the cell renderers.
+    static CellSheetCache &instance();
+
+private:
+    std::list<Sheet> sheets;    ///< Most recently used is at the front.
+    size_t max_bytes;
+
+    std::string filename_for_key(std::string const &key) const;
+    void flush_sheet(Sheet &sheet);
+
+    CellSheetCache(const CellSheetCache &);                // not implemented
+    CellSheetCache &operator=(const CellSheetCache &);     // not implemented
+};
+
+#endif
@@ -258,57 +258,82 @@ FontManager::~FontManager() {
     clear();
 }
 
-struct FindRenderedFont {
-    guint32 uint;
-    FindRenderedFont(guint32 uint_): uint(uint_) {}
-    bool operator()(const RenderedFont *font) const {
-        return font->uint == uint;
+RenderedFont *FontManager::cached_font(RenderedFontCache &cache, const GdColor &c, bool widefont) {
+    guint32 uint = c.get_uint_0rgb();
+    // most of the time, the same color is used again
+    if (!cache.fonts.empty() && cache.fonts.front()->uint == uint)
+        return cache.fonts.front();
+
+    std::map<guint32, RenderedFontCache::container::iterator>::iterator found = cache.index.find(uint);
+    if (found != cache.index.end()) {
+        // put the font found to the beginning of the list
+        cache.fonts.splice(cache.fonts.begin(), cache.fonts, found->second);
+        return cache.fonts.front();
     }
-};
 
-RenderedFont *FontManager::narrow(const GdColor &c) {
-    // find font in list
-    container::iterator it = find_if(_narrow.begin(), _narrow.end(), FindRenderedFont(c.get_uint_0rgb()));
-    if (it == _narrow.end()) {
-        // if not found, create it
-        RenderedFont *newfont = new RenderedFontNarrow(font, font_size, c, screen);
-        _narrow.push_front(newfont);
-        // if list became too long, remove one from the end
-        if (_narrow.size() > 8) {
-            delete _narrow.back();
-            _narrow.pop_back();
-        }
-    } else {
-        // put the font found to the beginning of the list
-        std::swap(*_narrow.begin(), *it);
+    // if not found, create it
+    RenderedFont *newfont;
+    if (widefont)
+        newfont = new RenderedFontWide(font, font_size, c, screen);
+    else
+        newfont = new RenderedFontNarrow(font, font_size, c, screen);
+    cache.fonts.push_front(newfont);
+    cache.index[uint] = cache.fonts.begin();
+    // if list became too long, remove one from the end
+    if (cache.fonts.size() > 32) {
+        cache.index.erase(cache.fonts.back()->uint);
+        delete cache.fonts.back();
+        cache.fonts.pop_back();
     }
-    return *_narrow.begin();
+    return newfont;
+}
+
+RenderedFont *FontManager::narrow(const GdColor &c) {
+    return cached_font(_narrow, c, false);
 }
 
 RenderedFont *FontManager::wide(const GdColor &c) {
-    // find font in list
-    container::iterator it = find_if(_wide.begin(), _wide.end(), FindRenderedFont(c.get_uint_0rgb()));
-    if (it == _wide.end()) {
-        // if not found, create it
-        RenderedFont *newfont = new RenderedFontWide(font, font_size, c, screen);
-        _wide.push_front(newfont);
-        // if list became too long, remove one from the end
-        if (_wide.size() > 8) {
-            delete _wide.back();
-            _wide.pop_back();
+    return cached_font(_wide, c, true);
+}
+
+gunichar const *FontManager::decode_text(char const *text) {
+    /* ascii text is not changed by normalization, so it only needs widening. */
+    size_t len = 0;
+    while (text[len] != '\0' && (unsigned char) text[len] < 0x80)
+        ++len;
+    if (text[len] == '\0') {
+        if (ascii_buffer.size() < len + 1)
+            ascii_buffer.resize(len + 1);
+        for (size_t i = 0; i <= len; ++i)
+            ascii_buffer[i] = (unsigned char) text[i];
+        return &ascii_buffer[0];
+    }
+
+    /* others are converted once, and then remembered. if two different
+     * texts have the same hash, the old one is replaced. */
+    DecodedText &decoded = decoded_texts[g_str_hash(text)];
+    if (decoded.ucs.empty() || decoded.text != text) {
+        if (decoded_texts.size() > 256) {
+            /* too many texts; start again */
+            decoded_texts.clear();
+            return decode_text(text);
         }
-    } else {
-        // put the font found to the beginning of the list
-        std::swap(*_wide.begin(), *it);
+        AutoGFreePtr<char> normalized(g_utf8_normalize(text, -1, G_NORMALIZE_ALL));
+        glong items = 0;
+        AutoGFreePtr<gunichar> ucs(normalized != NULL ? g_utf8_to_ucs4(normalized, -1, NULL, &items, NULL) : NULL);
+        decoded.text = text;
+        if (ucs == NULL)
+            items = 0;
+        decoded.ucs.assign((gunichar *) ucs, (gunichar *) ucs + items);
+        decoded.ucs.push_back(0);
     }
-    return *_wide.begin();
+    return &decoded.ucs[0];
 }
 
 /* function which draws characters on the screen. used internally. */
 /* x=-1 -> center horizontally */
 int FontManager::blittext_internal(int x, int y, char const *text, bool widefont) {
-    AutoGFreePtr<char> normalized(g_utf8_normalize(text, -1, G_NORMALIZE_ALL));
-    AutoGFreePtr<gunichar> ucs(g_utf8_to_ucs4(normalized, -1, NULL, NULL, NULL));
+    gunichar const *ucs = decode_text(text);
 
     RenderedFont const *font = widefont ? wide(current_color) : narrow(current_color);
     int w = font->get_character(' ').get_width();
@@ -459,12 +484,15 @@ int FontManager::blittext_internal(int x, int y, char const *text, bool widefont
 }
 
 void FontManager::clear() {
-    for (container::iterator it = _narrow.begin(); it != _narrow.end(); ++it)
+    RenderedFontCache::container::iterator it;
+    for (it = _narrow.fonts.begin(); it != _narrow.fonts.end(); ++it)
         delete *it;
-    _narrow.clear();
-    for (container::iterator it = _wide.begin(); it != _wide.end(); ++it)
+    _narrow.fonts.clear();
+    _narrow.index.clear();
+    for (it = _wide.fonts.begin(); it != _wide.fonts.end(); ++it)
         delete *it;
-    _wide.clear();
+    _wide.fonts.clear();
+    _wide.index.clear();
 }
 
 void FontManager::release_pixmaps() {
@@ -27,6 +27,7 @@
 #define FONTMANAGER_HPP_INCLUDED
 
 #include <list>
+#include <map>
 #include <glib.h>
 #include <string>
 #include <vector>
@@ -95,10 +96,34 @@ private:
     /// The Screen on which this FontManager is working.
     Screen &screen;
 
-    /// Rendered fonts are stored in a list for caching.
-    typedef std::list<RenderedFont *> container;
+    /// Rendered fonts are cached for the recently used colors. They are
+    /// stored in a list, most recently used first, and indexed by color.
+    struct RenderedFontCache {
+        typedef std::list<RenderedFont *> container;
+        container fonts;
+        std::map<guint32, container::iterator> index;
+    };
     /// Cached fonts for narrow and wide letters.
-    container _narrow, _wide;
+    RenderedFontCache _narrow, _wide;
+
+    /// Texts converted to UCS-4 are cached, as most of them are drawn
+    /// again and again. They are indexed by the hash of the UTF-8 text.
+    struct DecodedText {
+        std::string text;
+        std::vector<gunichar> ucs;
+    };
+    std::map<guint, DecodedText> decoded_texts;
+    /// Buffer for ASCII texts, which need no normalization.
+    std::vector<gunichar> ascii_buffer;
+
+    /// @brief Return the font for the color from the cache.
+    /// If it does not exist yet, create. If too many
+    /// fonts are in the cache, delete the least recently used one.
+    RenderedFont *cached_font(RenderedFontCache &cache, const GdColor &c, bool widefont);
+
+    /// @brief Convert the UTF-8 text to normalized UCS-4.
+    /// @return Zero terminated array, valid until the next call.
+    gunichar const *decode_text(char const *text);
 
     /// @brief Return with the narrow rendered font.
     /// If it does not exist yet, create. If too many
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "gfx/memorypixbuf.hpp"
+#include "cave/colors.hpp"
+
+
+MemoryPixbuf::MemoryPixbuf(int w, int h)
+    : pixels(g_new(guint32, w * h)),
+      width(w),
+      height(h),
+      pitch(w * sizeof(guint32)),
+      own_pixels(true) {
+}
+
+
+MemoryPixbuf::MemoryPixbuf(guint32 *pixels, int w, int h, int pitch, bool own_pixels)
+    : pixels(pixels),
+      width(w),
+      height(h),
+      pitch(pitch),
+      own_pixels(own_pixels) {
+}
+
+
+MemoryPixbuf::~MemoryPixbuf() {
+    if (own_pixels)
+        g_free(pixels);
+}
+
+
+int MemoryPixbuf::get_width() const {
+    return width;
+}
+
+
+int MemoryPixbuf::get_height() const {
+    return height;
+}
+
+
+unsigned char *MemoryPixbuf::get_pixels() const {
+    return reinterpret_cast<unsigned char *>(pixels);
+}
+
+
+int MemoryPixbuf::get_pitch() const {
+    return pitch;
+}
+
+
+/* clip the source rectangle to the source and the destination, like SDL_BlitSurface.
+ * returns false if nothing remains. */
+static bool clip_blit(Pixbuf const &src, int &x, int &y, int &w, int &h, Pixbuf const &dest, int &dx, int &dy) {
+    if (x < 0) {
+        w += x;
+        dx -= x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        dy -= y;
+        y = 0;
+    }
+    if (dx < 0) {
+        w += dx;
+        x -= dx;
+        dx = 0;
+    }
+    if (dy < 0) {
+        h += dy;
+        y -= dy;
+        dy = 0;
+    }
+    w = std::min(w, std::min(src.get_width() - x, dest.get_width() - dx));
+    h = std::min(h, std::min(src.get_height() - y, dest.get_height() - dy));
+    return w > 0 && h > 0;
+}
+
+
+void MemoryPixbuf::blit_full(int x, int y, int w, int h, Pixbuf &dest, int dx, int dy) const {
+    if (!clip_blit(*this, x, y, w, h, dest, dx, dy))
+        return;
+
+    for (int j = 0; j < h; ++j) {
+        guint32 const *srcrow = get_row(y + j) + x;
+        guint32 *dstrow = dest.get_row(dy + j) + dx;
+        for (int i = 0; i < w; ++i) {
+            guint32 s = srcrow[i], d = dstrow[i];
+            guint32 a = (s & amask) >> ashift;
+            if (a == 0)
+                continue;
+            if (a == 255) {
+                /* the alpha of the destination is kept */
+                dstrow[i] = (s & ~amask) | (d & amask);
+                continue;
+            }
+            int sr = (s & rmask) >> rshift, sg = (s & gmask) >> gshift, sb = (s & bmask) >> bshift;
+            int dr = (d & rmask) >> rshift, dg = (d & gmask) >> gshift, db = (d & bmask) >> bshift;
+            dr += (sr - dr) * int(a) >> 8;
+            dg += (sg - dg) * int(a) >> 8;
+            db += (sb - db) * int(a) >> 8;
+            dstrow[i] = guint32(dr) << rshift | guint32(dg) << gshift | guint32(db) << bshift | (d & amask);
+        }
+    }
+}
+
+
+void MemoryPixbuf::copy_full(int x, int y, int w, int h, Pixbuf &dest, int dx, int dy) const {
+    if (!clip_blit(*this, x, y, w, h, dest, dx, dy))
+        return;
+
+    for (int j = 0; j < h; ++j)
+        memmove(dest.get_row(dy + j) + dx, get_row(y + j) + x, w * sizeof(guint32));
+}
+
+
+void MemoryPixbuf::fill_rect(int x, int y, int w, int h, const GdColor &c) {
+    int x1 = std::max(x, 0), y1 = std::max(y, 0);
+    int x2 = std::min(x + w, width), y2 = std::min(y + h, height);
+    guint32 pixel = rgba_pixel_from_color(c, 0xff);
+    for (int j = y1; j < y2; ++j) {
+        guint32 *row = get_row(j);
+        std::fill(row + x1, row + x2, pixel);
+    }
+}
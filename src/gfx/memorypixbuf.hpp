@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef MEMORYPIXBUF_HPP_INCLUDED
+#define MEMORYPIXBUF_HPP_INCLUDED
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "gfx/pixbuf.hpp"
+
+/// @ingroup Graphics
+/// @brief A pixbuf, which stores its pixels in plain memory, without
+/// depending on SDL or GTK+.
+///
+/// Blitting works like in SDL: the alpha channel of the source is used
+/// for blending, and the alpha channel of the destination is kept.
+/// Copying copies the alpha channel as well. Memory pixbufs can only be
+/// blitted and copied to other memory pixbufs.
+class MemoryPixbuf: public Pixbuf {
+private:
+    guint32 *pixels;        ///< RGBA pixel data
+    int width, height;
+    int pitch;              ///< Bytes per row
+    bool own_pixels;        ///< If the pixels are to be freed; not for subpixbufs
+
+    MemoryPixbuf(const MemoryPixbuf &);               // copy ctor not implemented
+    MemoryPixbuf &operator=(const MemoryPixbuf &);    // operator= not implemented
+
+    MemoryPixbuf(int w, int h);
+    MemoryPixbuf(guint32 *pixels, int w, int h, int pitch, bool own_pixels);
+
+    friend class MemoryPixbufFactory;
+    friend class MemoryScreen;
+
+public:
+    ~MemoryPixbuf();
+
+    virtual int get_width() const;
+    virtual int get_height() const;
+
+    virtual void blit_full(int x, int y, int w, int h, Pixbuf &dest, int dx, int dy) const;
+    virtual void copy_full(int x, int y, int w, int h, Pixbuf &dest, int dx, int dy) const;
+    virtual void fill_rect(int x, int y, int w, int h, const GdColor &c);
+
+    virtual unsigned char *get_pixels() const;
+    virtual int get_pitch() const;
+};
+
+#endif
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <stdexcept>
+#include <memory>
+#include <cstring>
+#include <glib.h>
+#ifdef HAVE_LIBPNG
+#include <png.h>
+#endif
+
+#include "gfx/memorypixbuffactory.hpp"
+#include "gfx/memorypixbuf.hpp"
+#include "cave/colors.hpp"
+
+
+#ifdef HAVE_LIBPNG
+struct PngReadBuffer {
+    unsigned char const *data;
+    size_t length, pos;
+};
+
+
+static void png_read_from_buffer(png_structp png, png_bytep out, png_size_t count) {
+    PngReadBuffer *buf = static_cast<PngReadBuffer *>(png_get_io_ptr(png));
+    if (count > buf->length - buf->pos)
+        png_error(png, "unexpected end of image data");
+    memcpy(out, buf->data + buf->pos, count);
+    buf->pos += count;
+}
+
+
+/* decode a png image to rgba pixels, allocated with g_new; NULL on error.
+ * libpng reports errors with longjmp, so this function must not have
+ * any local objects with destructors. */
+static guint32 *decode_png(unsigned char const *data, size_t length, int *width, int *height) {
+    if (length < 8 || png_sig_cmp(const_cast<png_bytep>(data), 0, 8) != 0)
+        return NULL;
+
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png)
+        return NULL;
+    png_infop info = png_create_info_struct(png);
+    if (!info) {
+        png_destroy_read_struct(&png, NULL, NULL);
+        return NULL;
+    }
+    guint32 *volatile pixels = NULL;
+    png_bytep *volatile rows = NULL;
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, NULL);
+        g_free(rows);
+        g_free(pixels);
+        return NULL;
+    }
+
+    PngReadBuffer buf = { data, length, 0 };
+    png_set_read_fn(png, &buf, png_read_from_buffer);
+    png_read_info(png, info);
+    /* convert everything to 8-bit rgba, which is the memory layout of a Pixbuf */
+    png_set_expand(png);
+    png_set_strip_16(png);
+    png_set_gray_to_rgb(png);
+    png_set_filler(png, 0xff, PNG_FILLER_AFTER);
+    png_set_interlace_handling(png);
+    png_read_update_info(png, info);
+
+    int w = png_get_image_width(png, info), h = png_get_image_height(png, info);
+    pixels = g_new(guint32, w * h);
+    rows = g_new(png_bytep, h);
+    for (int y = 0; y < h; ++y)
+        rows[y] = reinterpret_cast<png_bytep>(pixels + y * w);
+    png_read_image(png, rows);
+    png_read_end(png, NULL);
+    png_destroy_read_struct(&png, &info, NULL);
+    g_free(rows);
+
+    *width = w;
+    *height = h;
+    return pixels;
+}
+#endif
+
+
+/* copy the pixels of an image loaded by the loader factory, and delete it.
+ * every pixbuf has the same pixel format, so this is just copying the rows. */
+MemoryPixbuf *MemoryPixbufFactory::copy_of_loaded(Pixbuf *loaded) const {
+    std::auto_ptr<Pixbuf> pb(loaded);
+    MemoryPixbuf *ret = new MemoryPixbuf(pb->get_width(), pb->get_height());
+    for (int y = 0; y < pb->get_height(); ++y)
+        memcpy(ret->get_row(y), pb->get_row(y), pb->get_width() * sizeof(guint32));
+    return ret;
+}
+
+
+Pixbuf *MemoryPixbufFactory::create_from_inline(int length, unsigned char const *data) const {
+    if (loader)
+        return copy_of_loaded(loader->create_from_inline(length, data));
+#ifdef HAVE_LIBPNG
+    int w, h;
+    guint32 *pixels = decode_png(data, length, &w, &h);
+    if (!pixels)
+        throw std::runtime_error("cannot load image: invalid png data");
+    return new MemoryPixbuf(pixels, w, h, w * sizeof(guint32), true);
+#else
+    throw std::runtime_error("cannot load image: compiled without libpng");
+#endif
+}
+
+
+Pixbuf *MemoryPixbufFactory::create_from_file(const char *filename) const {
+    if (loader)
+        return copy_of_loaded(loader->create_from_file(filename));
+    gchar *contents;
+    gsize length;
+    GError *error = NULL;
+    if (!g_file_get_contents(filename, &contents, &length, &error)) {
+        std::string message = std::string("cannot load image ") + error->message;
+        g_error_free(error);
+        throw std::runtime_error(message);
+    }
+    try {
+        Pixbuf *pb = create_from_inline(length, reinterpret_cast<unsigned char const *>(contents));
+        g_free(contents);
+        return pb;
+    } catch (...) {
+        g_free(contents);
+        throw;
+    }
+}
+
+
+Pixbuf *MemoryPixbufFactory::create(int w, int h) const {
+    return new MemoryPixbuf(w, h);
+}
+
+
+Pixbuf *MemoryPixbufFactory::create_composite_color(Pixbuf const &src, const GdColor &c, unsigned char a) const {
+    /* blend the color over the pixels, the alpha channel is kept - like the sdl version */
+    MemoryPixbuf *ret = new MemoryPixbuf(src.get_width(), src.get_height());
+    unsigned char r, g, b;
+    c.get_rgb(r, g, b);
+    for (int y = 0; y < src.get_height(); ++y) {
+        guint32 const *srcrow = src.get_row(y);
+        guint32 *dstrow = ret->get_row(y);
+        for (int x = 0; x < src.get_width(); ++x) {
+            guint32 p = srcrow[x];
+            int pr = (p & Pixbuf::rmask) >> Pixbuf::rshift;
+            int pg = (p & Pixbuf::gmask) >> Pixbuf::gshift;
+            int pb = (p & Pixbuf::bmask) >> Pixbuf::bshift;
+            pr += (r - pr) * a >> 8;
+            pg += (g - pg) * a >> 8;
+            pb += (b - pb) * a >> 8;
+            dstrow[x] = guint32(pr) << Pixbuf::rshift | guint32(pg) << Pixbuf::gshift | guint32(pb) << Pixbuf::bshift | (p & Pixbuf::amask);
+        }
+    }
+    return ret;
+}
+
+
+Pixbuf *MemoryPixbufFactory::create_subpixbuf(Pixbuf &src, int x, int y, int w, int h) const {
+    g_assert(x >= 0 && y >= 0 && x + w <= src.get_width() && y + h <= src.get_height());
+    return new MemoryPixbuf(&src(x, y), w, h, src.get_pitch(), false);
+}
+
+
+Pixbuf *MemoryPixbufFactory::create_rotated(const Pixbuf &src, Rotation r) const {
+    int sw = src.get_width(), sh = src.get_height();
+    bool swap = r == CounterClockWise || r == ClockWise;
+    MemoryPixbuf *ret = new MemoryPixbuf(swap ? sh : sw, swap ? sw : sh);
+    for (int y = 0; y < ret->get_height(); ++y) {
+        guint32 *dstrow = ret->get_row(y);
+        for (int x = 0; x < ret->get_width(); ++x) {
+            switch (r) {
+                case None:
+                    dstrow[x] = src(x, y);
+                    break;
+                case CounterClockWise:
+                    dstrow[x] = src(sw - 1 - y, x);
+                    break;
+                case UpsideDown:
+                    dstrow[x] = src(sw - 1 - x, sh - 1 - y);
+                    break;
+                case ClockWise:
+                    dstrow[x] = src(y, sh - 1 - x);
+                    break;
+            }
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "gfx/memoryscreen.hpp"
+#include "gfx/memorypixbuf.hpp"
+#include "gfx/particlerasterizer.hpp"
+#include "cave/colors.hpp"
+
+
+int MemoryPixmap::get_width() const {
+    return pixbuf->get_width();
+}
+
+
+int MemoryPixmap::get_height() const {
+    return pixbuf->get_height();
+}
+
+
+MemoryScreen::MemoryScreen(PixbufFactory &pixbuf_factory)
+    : Screen(pixbuf_factory),
+      clip_x1(0), clip_y1(0), clip_x2(0), clip_y2(0) {
+}
+
+
+MemoryScreen::~MemoryScreen() {
+}
+
+
+void MemoryScreen::configure_size() {
+    surface.reset(new MemoryPixbuf(w, h));
+    remove_clip_rect();
+    guint32 black = Pixbuf::amask;      /* opaque */
+    std::fill(surface->pixels, surface->pixels + w * h, black);
+}
+
+
+void MemoryScreen::set_title(char const *title) {
+    /* there is no window */
+}
+
+
+Pixmap *MemoryScreen::create_pixmap_from_pixbuf(Pixbuf const &pb, bool keep_alpha) const {
+    MemoryPixbuf *copy = new MemoryPixbuf(pb.get_width(), pb.get_height());
+    for (int y = 0; y < pb.get_height(); ++y) {
+        guint32 const *srcrow = pb.get_row(y);
+        guint32 *dstrow = copy->get_row(y);
+        if (keep_alpha)
+            memcpy(dstrow, srcrow, pb.get_width() * sizeof(guint32));
+        else
+            for (int x = 0; x < pb.get_width(); ++x)
+                dstrow[x] = srcrow[x] | Pixbuf::amask;
+    }
+    return new MemoryPixmap(copy);
+}
+
+
+void MemoryScreen::fill_rect(int x, int y, int w, int h, const GdColor &c) {
+    /* the clipping rectangle applies, like for SDL_FillRect */
+    int x1 = std::max(x, clip_x1), y1 = std::max(y, clip_y1);
+    int x2 = std::min(x + w, clip_x2), y2 = std::min(y + h, clip_y2);
+    if (x1 < x2 && y1 < y2)
+        surface->fill_rect(x1, y1, x2 - x1, y2 - y1, c);
+}
+
+
+void MemoryScreen::blit(Pixmap const &src, int dx, int dy) const {
+    MemoryPixbuf const &from = *static_cast<MemoryPixmap const &>(src).pixbuf;
+    /* clip the destination rectangle; the pixbuf clips to the screen */
+    int x1 = std::max(dx, clip_x1), y1 = std::max(dy, clip_y1);
+    int x2 = std::min(dx + from.get_width(), clip_x2), y2 = std::min(dy + from.get_height(), clip_y2);
+    if (x1 < x2 && y1 < y2)
+        from.blit_full(x1 - dx, y1 - dy, x2 - x1, y2 - y1, *surface, x1, y1);
+}
+
+
+void MemoryScreen::set_clip_rect(int x1, int y1, int w, int h) {
+    clip_x1 = std::max(x1, 0);
+    clip_y1 = std::max(y1, 0);
+    clip_x2 = std::min(x1 + w, get_width());
+    clip_y2 = std::min(y1 + h, get_height());
+}
+
+
+void MemoryScreen::remove_clip_rect() {
+    clip_x1 = 0;
+    clip_y1 = 0;
+    clip_x2 = get_width();
+    clip_y2 = get_height();
+}
+
+
+void MemoryScreen::draw_particle_set(int dx, int dy, ParticleSet const &ps) {
+    /* the same rasterizer as the sdl screens use, so the images are the same */
+    ParticleRasterizer rasterizer(surface->pixels, surface->get_pitch(), Pixbuf::rshift, Pixbuf::gshift, Pixbuf::bshift,
+                                  clip_x1, clip_y1, clip_x2 - 1, clip_y2 - 1, get_pal_emulation());
+    rasterizer.draw(dx, dy, ps);
+}
+
+
+Pixbuf const &MemoryScreen::get_pixbuf() const {
+    g_assert(surface.get() != NULL);
+    return *surface;
+}
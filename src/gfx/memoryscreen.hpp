@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef MEMORYSCREEN_HPP_INCLUDED
+#define MEMORYSCREEN_HPP_INCLUDED
+
+#include "config.h"
+
+#include <memory>
+
+#include "gfx/screen.hpp"
+#include "gfx/memorypixbuf.hpp"
+
+class PixbufFactory;
+
+
+/// @ingroup Graphics
+/// @brief A pixmap for the MemoryScreen, which is just a MemoryPixbuf.
+class MemoryPixmap: public Pixmap {
+private:
+    std::auto_ptr<MemoryPixbuf> pixbuf;
+
+    MemoryPixmap(const MemoryPixmap &);               // copy ctor not implemented
+    MemoryPixmap &operator=(const MemoryPixmap &);    // operator= not implemented
+    MemoryPixmap(MemoryPixbuf *pixbuf_) : pixbuf(pixbuf_) {}
+
+public:
+    friend class MemoryScreen;
+
+    virtual int get_width() const;
+    virtual int get_height() const;
+};
+
+
+/// @ingroup Graphics
+/// @brief A screen which draws into a pixbuf in memory, without SDL or GTK+.
+///
+/// It draws exactly like the SDL screens do, so it can be used to render
+/// the game without a window: for benchmarks, and to compare the output
+/// with saved golden images. It should be used with a MemoryPixbufFactory.
+class MemoryScreen: public Screen {
+private:
+    std::auto_ptr<MemoryPixbuf> surface;
+    int clip_x1, clip_y1, clip_x2, clip_y2;     ///< Clipping rectangle; x2 and y2 are exclusive
+
+    MemoryScreen(const MemoryScreen &);       // not impl
+    MemoryScreen &operator=(const MemoryScreen &);    // not impl
+
+public:
+    MemoryScreen(PixbufFactory &pixbuf_factory);
+    ~MemoryScreen();
+    virtual void configure_size();
+    virtual void set_title(char const *title);
+    virtual Pixmap *create_pixmap_from_pixbuf(Pixbuf const &pb, bool keep_alpha) const;
+
+    virtual void fill_rect(int x, int y, int w, int h, const GdColor &c);
+    virtual void blit(Pixmap const &src, int dx, int dy) const;
+    virtual void set_clip_rect(int x1, int y1, int w, int h);
+    virtual void remove_clip_rect();
+    virtual void draw_particle_set(int dx, int dy, ParticleSet const &ps);
+
+    /// @brief The contents of the screen. Only valid after the size is set.
+    Pixbuf const &get_pixbuf() const;
+};
+
+
+#endif
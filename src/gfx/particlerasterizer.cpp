@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "gfx/particlerasterizer.hpp"
+#include "cave/colors.hpp"
+#include "cave/particle.hpp"
+#include "settings.hpp"
+
+
+ParticleRasterizer::ParticleRasterizer(guint32 *pixels, int pitch, int rshift, int gshift, int bshift,
+                                       int left, int top, int right, int bottom, bool pal_emu)
+    : pal_emu(pal_emu)
+    , pixels(pixels)
+    , pitch(pitch)
+    , rshift(rshift), gshift(gshift), bshift(bshift)
+    , left(left), top(top), right(right), bottom(bottom) {
+}
+
+
+void ParticleRasterizer::set_color(SpanColor &sc, unsigned char r, unsigned char g, unsigned char b, unsigned char a) {
+    sc.color = r << 24 | g << 16 | b << 8 | a << 0;
+    sc.r = r;
+    sc.g = g;
+    sc.b = b;
+    sc.a = a;
+#ifdef __SSE2__
+    __m128i const zero = _mm_setzero_si128();
+    guint32 pixel = guint32(r) << rshift | guint32(g) << gshift | guint32(b) << bshift;
+    guint32 rgbmask = guint32(0xff) << rshift | guint32(0xff) << gshift | guint32(0xff) << bshift;
+    _mm_storeu_si128((__m128i *) sc.c16, _mm_unpacklo_epi8(_mm_set1_epi32(pixel), zero));
+    _mm_storeu_si128((__m128i *) sc.a16, _mm_andnot_si128(_mm_cmpeq_epi16(_mm_unpacklo_epi8(_mm_set1_epi32(rgbmask), zero), zero), _mm_set1_epi16(2 * a)));
+#endif
+}
+
+
+void ParticleRasterizer::span(int x1, int x2, int y) {
+    SpanColor const &sc = colors[y % 2];
+    guint32 *row = (guint32 *)((char *) pixels + y * pitch);
+    int x = x1;
+#ifdef __SSE2__
+    /* new = old + ((color - old) * alpha >> 8) for every component, eight at a time.
+     * (color - old) << 7 and 2 * alpha both fit in 16 bits, and their product
+     * is 256 times the original, so mulhi gives exactly the same. */
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const c16 = _mm_loadu_si128((__m128i const *) sc.c16);
+    __m128i const a16 = _mm_loadu_si128((__m128i const *) sc.a16);
+    for (; x + 3 <= x2; x += 4) {
+        __m128i p = _mm_loadu_si128((__m128i const *)(row + x));
+        __m128i lo = _mm_unpacklo_epi8(p, zero);
+        __m128i hi = _mm_unpackhi_epi8(p, zero);
+        lo = _mm_add_epi16(lo, _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(c16, lo), 7), a16));
+        hi = _mm_add_epi16(hi, _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(c16, hi), 7), a16));
+        _mm_storeu_si128((__m128i *)(row + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    guint32 rmask = guint32(0xff) << rshift, gmask = guint32(0xff) << gshift, bmask = guint32(0xff) << bshift;
+    guint32 bitoff = ~(rmask | gmask | bmask);   // to retain alpha
+    for (; x <= x2; x++) {
+        guint32 *pixel = row + x;
+
+        unsigned char R = (*pixel & rmask) >> rshift;
+        unsigned char G = (*pixel & gmask) >> gshift;
+        unsigned char B = (*pixel & bmask) >> bshift;
+
+        R = R + ((sc.r - R) * sc.a >> 8);
+        G = G + ((sc.g - G) * sc.a >> 8);
+        B = B + ((sc.b - B) * sc.a >> 8);
+
+        *pixel = (*pixel & bitoff) | guint32(R) << rshift | guint32(G) << gshift | guint32(B) << bshift;
+    }
+}
+
+
+void ParticleRasterizer::draw(int dx, int dy, ParticleSet const &ps) {
+    if (left > right || top > bottom)
+        return;
+
+    unsigned char r, g, b;
+    ps.color.get_rgb(r, g, b);
+    unsigned char a = ps.life / 1000.0 * ps.opacity * 255;
+    set_color(colors[0], r, g, b, a);
+    /* if we are doing software pal emu, here shade the particles as well */
+    if (pal_emu)
+        set_color(colors[1], r, g, b, a * gd_pal_emu_scanline_shade / 100);
+    else
+        colors[1] = colors[0];
+    short size = ceil(ps.size);
+    if (size < 0)
+        return;
+
+    for (unsigned i = 0; i < ps.count; ++i) {
+        short xc = dx + ps.px[i];
+        short yc = dy + ps.py[i];
+        if (xc + size < left || xc - size > right || yc + size < top || yc - size > bottom)
+            continue;
+        /* the diamond, row by row; a row f pixels from the center is 2*(size-f)+1 pixels wide */
+        int y1 = std::max(yc - size, top);
+        int y2 = std::min(yc + size, bottom);
+        for (int y = y1; y <= y2; ++y) {
+            int half = size - abs(y - yc);
+            int x1 = std::max(xc - half, left);
+            int x2 = std::min(xc + half, right);
+            if (x1 <= x2)
+                span(x1, x2, y);
+        }
+    }
+}
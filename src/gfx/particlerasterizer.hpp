@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef PARTICLERASTERIZER_HPP_INCLUDED
+#define PARTICLERASTERIZER_HPP_INCLUDED
+
+#include "config.h"
+
+#include <glib.h>
+
+class ParticleSet;
+
+
+/// @ingroup Graphics
+/// @brief Draws the particles of particle sets as diamonds on 32-bit pixels.
+///
+/// The clipping rectangle is given once, and every particle is clipped as
+/// a whole, so the spans drawn need no further checks. The spans are blended
+/// with SSE2 where available; the results are the same as the per-pixel
+/// blending would give. Used by the SDL screens and by the MemoryScreen, so
+/// both draw exactly the same images.
+class ParticleRasterizer {
+public:
+    /// @param pixels The first pixel of the image; the image must be already locked if needed.
+    /// @param pitch The number of bytes in a row of the image.
+    /// @param rshift, gshift, bshift The bit positions of the color components in a pixel; must be multiples of 8.
+    /// @param left, top, right, bottom The clipping rectangle, all inclusive.
+    /// @param pal_emu Whether to shade every odd row, for the software pal emulation.
+    ParticleRasterizer(guint32 *pixels, int pitch, int rshift, int gshift, int bshift,
+                       int left, int top, int right, int bottom, bool pal_emu);
+    virtual ~ParticleRasterizer() {}
+
+    /// @brief Draw the particles of a set.
+    /// @param dx, dy The offset of the set on the image.
+    void draw(int dx, int dy, ParticleSet const &ps);
+
+protected:
+    /// The color of a set, for even and odd rows (which differ for pal emulation).
+    struct SpanColor {
+        guint32 color;      ///< 0xRRGGBBAA
+        unsigned char r, g, b, a;
+#ifdef __SSE2__
+        guint16 c16[8];     ///< Color components of two pixels
+        guint16 a16[8];     ///< 2*alpha for the color components of two pixels, 0 for the others
+#endif
+    };
+
+    bool pal_emu;
+    SpanColor colors[2];
+
+    /// @brief Draw a span, which is already clipped, with the color of its row.
+    virtual void span(int x1, int x2, int y);
+
+private:
+    guint32 *pixels;
+    int pitch;
+    int rshift, gshift, bshift;
+    int left, top, right, bottom;
+
+    void set_color(SpanColor &sc, unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+};
+
+
+#endif
@@ -29,6 +29,7 @@
 #include "misc/autogfreeptr.hpp"
 #include "gfx/pixbuf.hpp"
 #include "gfx/pixbufmanip.hpp"
+#include "misc/trace.hpp"
 
 /* scale2x is not translated: the license says that we should call it in its original name. */
 // TRANSLATORS: you can translate "nearest neighbor" to "nearest" if the resulting
@@ -47,6 +48,7 @@ public:
 
 /* scales a pixbuf with the appropriate scaling type. */
 Pixbuf *PixbufFactory::create_scaled(const Pixbuf &src, int scaling_factor, GdScalingType scaling_type, bool pal_emulation) const {
+    TraceSpan span("create_scaled", "gfx");
     Pixbuf *scaled = this->create(src.get_width() * scaling_factor, src.get_height() * scaling_factor);
     switch (scaling_factor) {
         case 1:
@@ -25,10 +25,13 @@
 
 #include <cstring>
 #include <cmath>
+#include <vector>
+#include <algorithm>
 
 #include "settings.hpp"
 #include "gfx/pixbuf.hpp"
 #include "cave/colors.hpp"
+#include "misc/parallel.hpp"
 
 /* somewhat optimized implementation of the Scale2x algorithm. */
 /* http://scale2x.sourceforge.net */
@@ -192,12 +195,50 @@ void scale3x(const Pixbuf &src, Pixbuf &dest) {
     256*b=u+y
 */
 
-struct YUV {
+/* The passes below only mix pixels of the same row, and only depend on
+ * the row number through its parity, so every row is processed from
+ * start to end on its own. The components are stored in separate arrays
+ * (y, u, v and alpha), so the loops can be vectorized by the compiler.
+ * The arrays have PAL_PAD extra elements on both ends, filled with the
+ * pixels from the other end of the row, for the turnaround coordinates.
+ * Fixed point integer math is kept, so the output is the same as it
+ * was with the separate full passes. */
+
+#define PAL_PAD 2
+#define CROSSTALK_SIZE 16
+
+namespace {
+struct PalRow {
     /* we use values *256 here for fixed point math, so 8bits is not enough */
-    gint32 y, u, v;
+    std::vector<gint32> y, u, v, alpha;
+    std::vector<gint32> luma, blurred_alpha, blurred_u, blurred_v;
+
+    explicit PalRow(int width)
+        :   y(width + 2 * PAL_PAD), u(width + 2 * PAL_PAD), v(width + 2 * PAL_PAD), alpha(width + 2 * PAL_PAD),
+            luma(width), blurred_alpha(width), blurred_u(width + 2 * PAL_PAD), blurred_v(width + 2 * PAL_PAD) {
+    }
+};
+
+struct PalEmulation {
+    Pixbuf *pb;
+    int shade;
+    /* crosstalk coefficients for every x coordinate */
+    std::vector<gint32> crosstalk_sin, crosstalk_cos;
+    unsigned bands;
 };
+}
+
 
-static void luma_blur(YUV **yuv, YUV **work, int width, int height) {
+/* fill the padding at both ends of a row with the turnaround pixels */
+static inline void pal_pad_row(gint32 *row, int width) {
+    for (int i = 1; i <= PAL_PAD; i++) {
+        row[PAL_PAD - i] = row[PAL_PAD + ((width - i % width) % width)];
+        row[PAL_PAD + width - 1 + i] = row[PAL_PAD + (i - 1) % width];
+    }
+}
+
+
+static void luma_blur(gint32 const *in, gint32 *out, int width) {
     /* convolution "matrices" could be 5 numbers, ie. x-2, x-1, x, x+1, x+2... */
     /* but the output already has problems for x-1 and x+1. as the game only
        pal_emus cells, not complete screens - so they are only 3 pixels wide */
@@ -208,130 +249,48 @@ static void luma_blur(YUV **yuv, YUV **work, int width, int height) {
     /* for right edge of image. */
     static const int lconv_right[] = { 6, 10, 1, }, ldiv_right = lconv_right[0] + lconv_right[1] + lconv_right[2];
 
-    /* apply convolution matrix */
-    /* luma blur */
-    for (int y = 0; y < height; y++) {
-        YUV n;    /* new value of this pixel in yuv */
-        int x, xm, xp;
-
-        /* for x = 0 (left edge) */
-        xm = width - 1;
-        x = 0;
-        xp = 1;
-        n.y = (yuv[y][xm].y * lconv_left[0] + yuv[y][x].y * lconv_left[1] + yuv[y][xp].y * lconv_left[2]) / ldiv_left;
-        work[y][x].y = n.y;
-
-        /* for x = 1..width-2 */
-        for (int x = 1; x < width - 1; x++) {
-            int xm = x - 1;
-            int xp = x + 1;
-            n.y = (yuv[y][xm].y * lconv[0] + yuv[y][x].y * lconv[1] + yuv[y][xp].y * lconv[2]) / ldiv;
-            work[y][x].y = n.y;
-        }
-
-        /* for x = width-1 (right edge) */
-        xm = width - 2;
-        x = width - 1;
-        xp = 0;
-        n.y = (yuv[y][xm].y * lconv_right[0] + yuv[y][x].y * lconv_right[1] + yuv[y][xp].y * lconv_right[2]) / ldiv_right;
-        work[y][x].y = n.y;
-    }
-
-    for (int y = 0; y < height; y++)
-        for (int x = 0; x < width; x++)
-            yuv[y][x].y = work[y][x].y;
+    /* in is padded; in[x] is pixel x, in[-1] is the last pixel, in[width] is the first one */
+    out[0] = (in[-1] * lconv_left[0] + in[0] * lconv_left[1] + in[1] * lconv_left[2]) / ldiv_left;
+    for (int x = 1; x < width - 1; x++)
+        out[x] = (in[x - 1] * lconv[0] + in[x] * lconv[1] + in[x + 1] * lconv[2]) / ldiv;
+    if (width > 1)
+        out[width - 1] = (in[width - 2] * lconv_right[0] + in[width - 1] * lconv_right[1] + in[width] * lconv_right[2]) / ldiv_right;
 }
 
 
-static void chroma_blur(YUV **yuv, YUV **work, int width, int height) {
+static void chroma_blur(gint32 const *in, gint32 *out, int width) {
     /* convolution "matrix" for chrominance */
     /* x-2, x-1, x, x+1, x+2 */
     static const int cconv[] = { 1, 1, 1, 1, 1, }, cdiv = cconv[0] + cconv[1] + cconv[2] + cconv[3] + cconv[4];
 
-    /* apply convolution matrix */
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int xm, xm2, xp, xp2;
-
-            /* turnaround coordinates */
-            xm2 = (x - 2 + width) % width;
-            xm = (x - 1 + width) % width;
-            xp = (x + 1) % width;
-            xp2 = (x + 2) % width;
-
-            /* chroma blur */
-            work[y][x].u = (yuv[y][xm2].u * cconv[0] + yuv[y][xm].u * cconv[1] + yuv[y][x].u * cconv[2] + yuv[y][xp].u * cconv[3] + yuv[y][xp2].u * cconv[4]) / cdiv;
-            work[y][x].v = (yuv[y][xm2].v * cconv[0] + yuv[y][xm].v * cconv[1] + yuv[y][x].v * cconv[2] + yuv[y][xp].v * cconv[3] + yuv[y][xp2].v * cconv[4]) / cdiv;
-        }
-    }
-
-    for (int y = 0; y < height; y++)
-        for (int x = 0; x < width; x++) {
-            yuv[y][x].u = work[y][x].u;
-            yuv[y][x].v = work[y][x].v;
-        }
+    /* in is padded, so no turnaround coordinates are needed */
+    for (int x = 0; x < width; x++)
+        out[x] = (in[x - 2] * cconv[0] + in[x - 1] * cconv[1] + in[x] * cconv[2] + in[x + 1] * cconv[3] + in[x + 2] * cconv[4]) / cdiv;
 }
 
-#define CROSSTALK_SIZE 16
 
-static void chroma_crosstalk_to_luma(YUV **yuv, YUV **work, int width, int height) {
-    /* arrays to store things */
-    static int crosstalk_sin[CROSSTALK_SIZE];
-    static int crosstalk_cos[CROSSTALK_SIZE];
+static void chroma_crosstalk_to_luma(PalRow &row, PalEmulation const &pal, int y, int width) {
     /* crosstalk will be amplitude/div; we use these two to have integer arithmetics */
-    const int crosstalk_amplitude = 384;
     const int crosstalk_div = 256;
-    static bool crosstalk_calculated = false;
-
-    if (!crosstalk_calculated) {
-        crosstalk_calculated = true;
-        for (int i = 0; i < CROSSTALK_SIZE; i++) {
-            double f = (double)i / CROSSTALK_SIZE * 2.0 * G_PI * 2;
-            crosstalk_sin[i] = crosstalk_amplitude * sin(f);
-            crosstalk_cos[i] = crosstalk_amplitude * cos(f);
-        }
-    }
+    gint32 const *u = &row.blurred_u[PAL_PAD], *v = &row.blurred_v[PAL_PAD];
+    gint32 const *sinx = &pal.crosstalk_sin[0], *cosx = &pal.crosstalk_cos[0];
+    gint32 *luma = &row.luma[0];
 
-    /* apply edge detection matrix */
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            const int conv[] = { -1, 1, 0, 0, 0,};
-
-            /* turnaround coordinates */
-            int xm2 = (x - 2 + width) % width;
-            int xm = (x - 1 + width) % width;
-            int xp = (x + 1) % width;
-            int xp2 = (x + 2) % width;
-
-            /* edge detect */
-            work[y][x].u = yuv[y][xm2].u * conv[0] + yuv[y][xm].u * conv[1] + yuv[y][x].u * conv[2] + yuv[y][xp].u * conv[3] + yuv[y][xp2].u * conv[4];
-            work[y][x].v = yuv[y][xm2].v * conv[0] + yuv[y][xm].v * conv[1] + yuv[y][x].v * conv[2] + yuv[y][xp].v * conv[3] + yuv[y][xp2].v * conv[4];
-        }
-    }
-
-    for (int y = 0; y < height; y++)
-        if (y / 2 % 2 == 1) /* rows 3&4 */
-            for (int x = 0; x < width; x++)
-                yuv[y][x].y += (crosstalk_sin[x % CROSSTALK_SIZE] * work[y][x].u - crosstalk_cos[x % CROSSTALK_SIZE] * work[y][x].v) / crosstalk_div; /* odd lines (/2) */
-        else          /* rows 1&2 */
-            for (int x = 0; x < width; x++)
-                yuv[y][x].y += (crosstalk_sin[x % CROSSTALK_SIZE] * work[y][x].u + crosstalk_cos[x % CROSSTALK_SIZE] * work[y][x].v) / crosstalk_div; /* even lines (/2) */
+    /* edge detect with { -1, 1, 0, 0, 0 } */
+    if (y / 2 % 2 == 1) /* rows 3&4 */
+        for (int x = 0; x < width; x++)
+            luma[x] += (sinx[x] * (u[x - 1] - u[x - 2]) - cosx[x] * (v[x - 1] - v[x - 2])) / crosstalk_div; /* odd lines (/2) */
+    else          /* rows 1&2 */
+        for (int x = 0; x < width; x++)
+            luma[x] += (sinx[x] * (u[x - 1] - u[x - 2]) + cosx[x] * (v[x - 1] - v[x - 2])) / crosstalk_div; /* even lines (/2) */
 }
 
-#undef CROSSTALK_SIZE
-
-
-static void scanline_shade(YUV **yuv, YUV **work, int width, int height) {
-    if (gd_pal_emu_scanline_shade < 0)
-        gd_pal_emu_scanline_shade = 0;
-    if (gd_pal_emu_scanline_shade > 100)
-        gd_pal_emu_scanline_shade = 100;
-    int shade = gd_pal_emu_scanline_shade * 256 / 100;
 
+static void scanline_shade(PalRow &row, int shade, int y, int width) {
     /* apply shade for every second row */
-    for (int y = 1; y < height; y += 2)
+    if (y % 2 == 1)
         for (int x = 0; x < width; x++)
-            yuv[y][x].y = yuv[y][x].y * shade / 256;
+            row.luma[x] = row.luma[x] * shade / 256;
 }
 
 
@@ -343,76 +302,94 @@ static inline int clamp(int value, int min, int max) {
     return value;
 }
 
-void pal_emulate(Pixbuf &pb) {
-    int width = pb.get_width();
-    int height = pb.get_height();
 
-    /* memory for yuv images */
-    YUV **yuv = new YUV*[height];
-    for (int y = 0; y < height; y++)
-        yuv[y] = new YUV[width];
-    YUV **work = new YUV*[height];
-    for (int y = 0; y < height; y++)
-        work[y] = new YUV[width];
-    YUV **alpha = new YUV*[height]; /* alpha is not really yuv, only y will be used. luma blur touches only y. */
-    for (int y = 0; y < height; y++)
-        alpha[y] = new YUV[width];
+static void pal_emulate_row(PalRow &row, PalEmulation const &pal, int y) {
+    Pixbuf &pb = *pal.pb;
+    int width = pb.get_width();
+    guint32 *pixels = pb.get_row(y);
+    gint32 *yy = &row.y[PAL_PAD], *uu = &row.u[PAL_PAD], *vv = &row.v[PAL_PAD], *aa = &row.alpha[PAL_PAD];
 
     /* convert to yuv */
-    for (int y = 0; y < height; y++) {
-        guint32 *row = pb.get_row(y);
+    for (int x = 0; x < width; x++) {
+        int r = (pixels[x] >> pb.rshift) & 0xff;
+        int g = (pixels[x] >> pb.gshift) & 0xff;
+        int b = (pixels[x] >> pb.bshift) & 0xff;
+
+        /* now y, u, v will contain values * 256 */
+        yy[x] = 77 * r + 150 * g + 29 * b; /* always pos */
+        uu[x] = -37 * r - 74 * g + 111 * b; /* pos or neg */
+        vv[x] = 157 * r - 131 * g - 26 * b; /* pos or neg */
+
+        /* alpha is copied as is, and is not *256 */
+        aa[x] = (pixels[x] >> pb.ashift) & 0xff;
+    }
+    pal_pad_row(&row.y[0], width);
+    pal_pad_row(&row.u[0], width);
+    pal_pad_row(&row.v[0], width);
+    pal_pad_row(&row.alpha[0], width);
 
-        for (int x = 0; x < width; x++) {
-            int r = (row[x] >> pb.rshift) & 0xff;
-            int g = (row[x] >> pb.gshift) & 0xff;
-            int b = (row[x] >> pb.bshift) & 0xff;
+    luma_blur(yy, &row.luma[0], width);
+    chroma_blur(uu, &row.blurred_u[PAL_PAD], width);
+    chroma_blur(vv, &row.blurred_v[PAL_PAD], width);
+    pal_pad_row(&row.blurred_u[0], width);
+    pal_pad_row(&row.blurred_v[0], width);
+    chroma_crosstalk_to_luma(row, pal, y, width);
+    scanline_shade(row, pal.shade, y, width);
 
-            /* now y, u, v will contain values * 256 */
-            yuv[y][x].y = 77 * r + 150 * g + 29 * b; /* always pos */
-            yuv[y][x].u = -37 * r - 74 * g + 111 * b; /* pos or neg */
-            yuv[y][x].v = 157 * r - 131 * g - 26 * b; /* pos or neg */
+    luma_blur(aa, &row.blurred_alpha[0], width);
 
-            /* alpha is copied as is, and is not *256 */
-            alpha[y][x].y = (row[x] >> pb.ashift) & 0xff;
-        }
+    /* convert back to rgb */
+    gint32 const *luma = &row.luma[0], *u = &row.blurred_u[PAL_PAD], *v = &row.blurred_v[PAL_PAD];
+    for (int x = 0; x < width; x++) {
+        /* back to rgb */
+        int r = clamp((256 * luma[x]             + 292 * v[x] + 32768) / 65536, 0, 255);
+        int g = clamp((256 * luma[x] - 101 * u[x] - 149 * v[x] + 32768) / 65536, 0, 255);
+        int b = clamp((256 * luma[x] + 519 * u[x]              + 32768) / 65536, 0, 255);
+
+        /* alpha channel is preserved, others are converted back from yuv */
+        pixels[x] = (row.blurred_alpha[x] << pb.ashift) | (r << pb.rshift) | (g << pb.gshift) | (b << pb.bshift);
     }
+}
 
-    /* we give them an array to "work" in, so that is not free()d and malloc() four times */
-    luma_blur(yuv, work, width, height);
-    chroma_blur(yuv, work, width, height);
-    chroma_crosstalk_to_luma(yuv, work, width, height);
-    scanline_shade(yuv, work, width, height);
-
-    luma_blur(alpha, work, width, height);
 
-    /* convert back to rgb */
-    for (int y = 0; y < height; y++) {
-        guint32 *row = pb.get_row(y);
+static void pal_emulate_band(unsigned band, gpointer data) {
+    PalEmulation const &pal = *static_cast<PalEmulation *>(data);
+    int height = pal.pb->get_height();
+    PalRow row(pal.pb->get_width());
+    for (int y = height * band / pal.bands; y < height * (band + 1) / pal.bands; y++)
+        pal_emulate_row(row, pal, y);
+}
 
-        for (int x = 0; x < width; x++) {
-            /* back to rgb */
-            int r = clamp((256 * yuv[y][x].y                + 292 * yuv[y][x].v + 32768) / 65536, 0, 255);
-            int g = clamp((256 * yuv[y][x].y - 101 * yuv[y][x].u - 149 * yuv[y][x].v + 32768) / 65536, 0, 255);
-            int b = clamp((256 * yuv[y][x].y + 519 * yuv[y][x].u                + 32768) / 65536, 0, 255);
 
-            /* alpha channel is preserved, others are converted back from yuv */
-            row[x] = (alpha[y][x].y << pb.ashift) | (r << pb.rshift) | (g << pb.gshift) | (b << pb.bshift);
-        }
+void pal_emulate(Pixbuf &pb) {
+    int width = pb.get_width();
+    int height = pb.get_height();
+    /* crosstalk will be amplitude/div, see chroma_crosstalk_to_luma */
+    const int crosstalk_amplitude = 384;
 
+    PalEmulation pal;
+    pal.pb = &pb;
+    /* this may run on worker threads, so the setting is only read, not corrected in place */
+    pal.shade = clamp(gd_pal_emu_scanline_shade, 0, 100) * 256 / 100;
+    pal.crosstalk_sin.resize(width);
+    pal.crosstalk_cos.resize(width);
+    for (int x = 0; x < width; x++) {
+        double f = (double)(x % CROSSTALK_SIZE) / CROSSTALK_SIZE * 2.0 * G_PI * 2;
+        pal.crosstalk_sin[x] = crosstalk_amplitude * sin(f);
+        pal.crosstalk_cos[x] = crosstalk_amplitude * cos(f);
     }
 
-    /* free arrays */
-    for (int y = 0; y < height; y++)
-        delete[] yuv[y];
-    delete[] yuv;
-    for (int y = 0; y < height; y++)
-        delete[] alpha[y];
-    delete[] alpha;
-    for (int y = 0; y < height; y++)
-        delete[] work[y];
-    delete[] work;
+    /* small pictures, like the cells, are not worth starting threads for;
+     * they may be processed on worker threads themselves. */
+    pal.bands = 1;
+    if (width * height >= 128 * 128)
+        pal.bands = std::max(1, std::min(int(ParallelJobs::get_num_processors()), height / 16));
+    gd_parallel_for(pal.bands, pal_emulate_band, &pal);
 }
 
+#undef CROSSTALK_SIZE
+#undef PAL_PAD
+
 
 GdColor average_nonblack_colors_in_pixbuf(Pixbuf const &pb) {
     guint32 red = 0, green = 0, blue = 0, count = 0;
@@ -32,6 +32,9 @@
  *
  * The RGBtoYUV lookup table is removed, as scaling is only done once
  * in GDash for every cave loading, not continuously during the game.
+ * Instead, every pixel is converted only once, and the patterns and
+ * the edge differences are determined for whole rows by HqxPatterns.
+ * Big pictures are scaled in row bands, in parallel.
  *
  * The interpolation functions are changed so they do not produce
  * overflows for the most significant bytes. So when calculating, they
@@ -94,7 +97,7 @@
 #define PIXEL11_90    Interp9(dp+dpL+1, w[5], w[6], w[8]);
 #define PIXEL11_100   Interp10(dp+dpL+1, w[5], w[6], w[8]);
 
-void hq2x(Pixbuf const &src, Pixbuf &dst) {
+static void hq2x_rows(Pixbuf const &src, Pixbuf &dst, int first_row, int last_row) {
     guint32  w[10];
 
     //   +----+----+----+
@@ -111,9 +114,11 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
     int sw = src.get_width();
     int sh = src.get_height();
     int dpL = dst.get_pitch() / 4; /* 4 bytes/pixel */
+    HqxPatterns patterns(src);
 
-    for (int j = 0; j < sh; j++) {
+    for (int j = first_row; j < last_row; j++) {
         const guint32 *line = src.get_row(j);
+        const guint16 *row_patterns = patterns.get_row(j);
         const guint32 *prevline, *nextline;
         if (j > 0)      prevline = src.get_row(j - 1);
         else prevline = src.get_row(sh - 1);
@@ -145,23 +150,8 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 w[9] = nextline[0];
             }
 
-            int pattern = 0;
-            int flag = 1;
-
-            guint32 YUV1 = RGBtoYUV(w[5]);
-
-            for (int k = 1; k <= 9; k++) {
-                if (k == 5) continue;
-
-                if (w[k] != w[5]) {
-                    guint32 YUV2 = RGBtoYUV(w[k]);
-                    if ((abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY) ||
-                            (abs((YUV1 & Umask) - (YUV2 & Umask)) > trU) ||
-                            (abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV))
-                        pattern |= flag;
-                }
-                flag <<= 1;
-            }
+            int pattern = row_patterns[i] & 0xff;
+            int edges = row_patterns[i] >> 8;
 
             guint32 *dp = dst.get_row(j * 2) + i * 2;
 
@@ -311,7 +301,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 18:
                 case 50: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_20
@@ -325,7 +315,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_20
                     PIXEL01_22
                     PIXEL10_21
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_20
@@ -336,7 +326,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 76: {
                     PIXEL00_21
                     PIXEL01_20
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_20
@@ -346,7 +336,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 10:
                 case 138: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_20
@@ -409,7 +399,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 22:
                 case 54: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
@@ -423,7 +413,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_20
                     PIXEL01_22
                     PIXEL10_21
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -434,7 +424,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 108: {
                     PIXEL00_21
                     PIXEL01_20
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -444,7 +434,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 11:
                 case 139: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
@@ -456,7 +446,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 19:
                 case 51: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL00_11
                         PIXEL01_10
                     } else {
@@ -470,7 +460,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 146:
                 case 178: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                         PIXEL11_12
                     } else {
@@ -483,7 +473,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 84:
                 case 85: {
                     PIXEL00_20
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL01_11
                         PIXEL11_10
                     } else {
@@ -497,7 +487,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 113: {
                     PIXEL00_20
                     PIXEL01_22
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL10_12
                         PIXEL11_10
                     } else {
@@ -510,7 +500,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 204: {
                     PIXEL00_21
                     PIXEL01_20
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                         PIXEL11_11
                     } else {
@@ -521,7 +511,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 73:
                 case 77: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL00_12
                         PIXEL10_10
                     } else {
@@ -534,7 +524,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 42:
                 case 170: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                         PIXEL10_11
                     } else {
@@ -547,7 +537,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 14:
                 case 142: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                         PIXEL01_12
                     } else {
@@ -616,12 +606,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 26:
                 case 31: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
@@ -633,13 +623,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 82:
                 case 214: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
                     }
                     PIXEL10_21
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -650,12 +640,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 248: {
                     PIXEL00_21
                     PIXEL01_22
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -664,13 +654,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 74:
                 case 107: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_21
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -679,7 +669,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 27: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
@@ -691,7 +681,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 86: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
@@ -704,7 +694,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_21
                     PIXEL01_22
                     PIXEL10_10
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -714,7 +704,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 106: {
                     PIXEL00_10
                     PIXEL01_21
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -724,7 +714,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 30: {
                     PIXEL00_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
@@ -737,7 +727,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_22
                     PIXEL01_10
                     PIXEL10_21
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -747,7 +737,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 120: {
                     PIXEL00_21
                     PIXEL01_22
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -756,7 +746,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 75: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
@@ -851,12 +841,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 58: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
@@ -867,13 +857,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 83: {
                     PIXEL00_11
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
                     }
                     PIXEL10_21
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -883,12 +873,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 92: {
                     PIXEL00_21
                     PIXEL01_11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -896,13 +886,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 202: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
                     PIXEL01_21
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
@@ -911,13 +901,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 78: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
                     PIXEL01_12
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
@@ -926,12 +916,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 154: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
@@ -942,13 +932,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 114: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
                     }
                     PIXEL10_12
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -958,12 +948,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 89: {
                     PIXEL00_12
                     PIXEL01_22
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -971,22 +961,22 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 90: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -995,7 +985,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 55:
                 case 23: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL00_11
                         PIXEL01_0
                     } else {
@@ -1009,7 +999,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 182:
                 case 150: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                         PIXEL11_12
                     } else {
@@ -1022,7 +1012,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 213:
                 case 212: {
                     PIXEL00_20
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL01_11
                         PIXEL11_0
                     } else {
@@ -1036,7 +1026,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 240: {
                     PIXEL00_20
                     PIXEL01_22
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL10_12
                         PIXEL11_0
                     } else {
@@ -1049,7 +1039,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 232: {
                     PIXEL00_21
                     PIXEL01_20
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                         PIXEL11_11
                     } else {
@@ -1060,7 +1050,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 109:
                 case 105: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL00_12
                         PIXEL10_0
                     } else {
@@ -1073,7 +1063,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 171:
                 case 43: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL10_11
                     } else {
@@ -1086,7 +1076,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 143:
                 case 15: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_12
                     } else {
@@ -1100,7 +1090,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 124: {
                     PIXEL00_21
                     PIXEL01_11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -1109,7 +1099,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 203: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
@@ -1121,7 +1111,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 62: {
                     PIXEL00_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
@@ -1134,7 +1124,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_11
                     PIXEL01_10
                     PIXEL10_21
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1143,7 +1133,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 118: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
@@ -1156,7 +1146,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_12
                     PIXEL01_22
                     PIXEL10_10
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1166,7 +1156,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 110: {
                     PIXEL00_10
                     PIXEL01_12
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -1175,7 +1165,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 155: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
@@ -1244,12 +1234,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 220: {
                     PIXEL00_21
                     PIXEL01_11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1257,12 +1247,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 158: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
@@ -1272,13 +1262,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 234: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
                     PIXEL01_21
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -1288,13 +1278,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 242: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
                     }
                     PIXEL10_12
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1302,12 +1292,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 59: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
@@ -1319,12 +1309,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 121: {
                     PIXEL00_12
                     PIXEL01_22
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -1333,13 +1323,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 87: {
                     PIXEL00_11
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
                     }
                     PIXEL10_21
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -1347,13 +1337,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 79: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_12
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
@@ -1362,22 +1352,22 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 122: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -1385,22 +1375,22 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 94: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -1408,22 +1398,22 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 218: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1431,22 +1421,22 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 91: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -1482,12 +1472,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 186: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
@@ -1498,13 +1488,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 115: {
                     PIXEL00_11
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
                     }
                     PIXEL10_12
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -1514,12 +1504,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 93: {
                     PIXEL00_12
                     PIXEL01_11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -1527,13 +1517,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 206: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
                     }
                     PIXEL01_12
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
@@ -1545,7 +1535,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 201: {
                     PIXEL00_12
                     PIXEL01_20
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_10
                     } else {
                         PIXEL10_70
@@ -1555,7 +1545,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 174:
                 case 46: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_10
                     } else {
                         PIXEL00_70
@@ -1568,7 +1558,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 179:
                 case 147: {
                     PIXEL00_11
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_10
                     } else {
                         PIXEL01_70
@@ -1582,7 +1572,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_20
                     PIXEL01_11
                     PIXEL10_12
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_10
                     } else {
                         PIXEL11_70
@@ -1605,12 +1595,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 126: {
                     PIXEL00_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -1619,14 +1609,14 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 219: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_10
                     PIXEL10_10
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1634,7 +1624,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 125: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL00_12
                         PIXEL10_0
                     } else {
@@ -1647,7 +1637,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 221: {
                     PIXEL00_12
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL01_11
                         PIXEL11_0
                     } else {
@@ -1658,7 +1648,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 207: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_12
                     } else {
@@ -1672,7 +1662,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 238: {
                     PIXEL00_10
                     PIXEL01_12
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                         PIXEL11_11
                     } else {
@@ -1683,7 +1673,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 190: {
                     PIXEL00_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                         PIXEL11_12
                     } else {
@@ -1694,7 +1684,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 187: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL10_11
                     } else {
@@ -1708,7 +1698,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 243: {
                     PIXEL00_11
                     PIXEL01_10
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL10_12
                         PIXEL11_0
                     } else {
@@ -1718,7 +1708,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 119: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL00_11
                         PIXEL01_0
                     } else {
@@ -1733,7 +1723,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 233: {
                     PIXEL00_12
                     PIXEL01_20
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_100
@@ -1743,7 +1733,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 175:
                 case 47: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_100
@@ -1756,7 +1746,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 183:
                 case 151: {
                     PIXEL00_11
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_100
@@ -1770,7 +1760,7 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_20
                     PIXEL01_11
                     PIXEL10_12
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_100
@@ -1780,12 +1770,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 250: {
                     PIXEL00_10
                     PIXEL01_10
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1793,13 +1783,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 123: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_10
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -1808,12 +1798,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 95: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
@@ -1824,13 +1814,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 222: {
                     PIXEL00_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
                     }
                     PIXEL10_10
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1840,12 +1830,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 252: {
                     PIXEL00_21
                     PIXEL01_11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_100
@@ -1855,12 +1845,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 249: {
                     PIXEL00_12
                     PIXEL01_22
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_100
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1868,13 +1858,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 235: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_21
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_100
@@ -1883,13 +1873,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 111: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_100
                     }
                     PIXEL01_12
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -1898,12 +1888,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 63: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_100
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
@@ -1913,12 +1903,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 159: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_100
@@ -1929,13 +1919,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 215: {
                     PIXEL00_11
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_100
                     }
                     PIXEL10_21
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -1944,13 +1934,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 246: {
                     PIXEL00_22
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
                     }
                     PIXEL10_12
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_100
@@ -1959,17 +1949,17 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 254: {
                     PIXEL00_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_100
@@ -1979,12 +1969,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 case 253: {
                     PIXEL00_12
                     PIXEL01_11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_100
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_100
@@ -1992,18 +1982,18 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 251: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_10
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_100
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -2011,13 +2001,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 239: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_100
                     }
                     PIXEL01_12
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_100
@@ -2026,17 +2016,17 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 127: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_100
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_20
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_20
@@ -2045,12 +2035,12 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 191: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_100
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_100
@@ -2060,18 +2050,18 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 223: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_100
                     }
                     PIXEL10_10
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_20
@@ -2080,13 +2070,13 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 247: {
                     PIXEL00_11
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_100
                     }
                     PIXEL10_12
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_100
@@ -2094,22 +2084,22 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 255: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_100
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_0
                     } else {
                         PIXEL01_100
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_0
                     } else {
                         PIXEL10_100
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL11_0
                     } else {
                         PIXEL11_100
@@ -2120,3 +2110,8 @@ void hq2x(Pixbuf const &src, Pixbuf &dst) {
         }
     }
 }
+
+
+void hq2x(Pixbuf const &src, Pixbuf &dst) {
+    hqx_scale(src, dst, hq2x_rows);
+}
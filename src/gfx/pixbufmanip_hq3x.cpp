@@ -32,6 +32,9 @@
  *
  * The RGBtoYUV lookup table is removed, as scaling is only done once
  * in GDash for every cave loading, not continuously during the game.
+ * Instead, every pixel is converted only once, and the patterns and
+ * the edge differences are determined for whole rows by HqxPatterns.
+ * Big pictures are scaled in row bands, in parallel.
  *
  * The interpolation functions are changed so they do not produce
  * overflows for the most significant bytes. So when calculating, they
@@ -99,7 +102,7 @@
 #define PIXEL22_5   Interp5(dp+dpL+dpL+2, w[6], w[8]);
 #define PIXEL22_C   *(dp+dpL+dpL+2) = w[5];
 
-void hq3x(Pixbuf const &src, Pixbuf &dst) {
+static void hq3x_rows(Pixbuf const &src, Pixbuf &dst, int first_row, int last_row) {
     guint32  w[10];
 
     //   +----+----+----+
@@ -116,9 +119,11 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
     int sw = src.get_width();
     int sh = src.get_height();
     int dpL = dst.get_pitch() / 4; /* 4 bytes/pixel */
+    HqxPatterns patterns(src);
 
-    for (int j = 0; j < sh; j++) {
+    for (int j = first_row; j < last_row; j++) {
         const guint32 *line = src.get_row(j);
+        const guint16 *row_patterns = patterns.get_row(j);
         const guint32 *prevline, *nextline;
         if (j > 0)      prevline = src.get_row(j - 1);
         else prevline = src.get_row(sh - 1);
@@ -150,23 +155,8 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 w[9] = nextline[0];
             }
 
-            int pattern = 0;
-            int flag = 1;
-
-            guint32 YUV1 = RGBtoYUV(w[5]);
-
-            for (int k = 1; k <= 9; k++) {
-                if (k == 5) continue;
-
-                if (w[k] != w[5]) {
-                    guint32 YUV2 = RGBtoYUV(w[k]);
-                    if ((abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY) ||
-                            (abs((YUV1 & Umask) - (YUV2 & Umask)) > trU) ||
-                            (abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV))
-                        pattern |= flag;
-                }
-                flag <<= 1;
-            }
+            int pattern = row_patterns[i] & 0xff;
+            int edges = row_patterns[i] >> 8;
 
             guint32 *dp = dst.get_row(j * 3) + i * 3;
 
@@ -381,7 +371,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 18:
                 case 50: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_1M
                         PIXEL12_C
@@ -405,7 +395,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_1
                     PIXEL11
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_1M
@@ -423,7 +413,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_2
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_1M
                         PIXEL21_C
@@ -437,7 +427,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 10:
                 case 138: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                         PIXEL01_C
                         PIXEL10_C
@@ -537,7 +527,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 22:
                 case 54: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -561,7 +551,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_1
                     PIXEL11
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -579,7 +569,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_2
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -593,7 +583,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 11:
                 case 139: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -612,7 +602,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 19:
                 case 51: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL00_1L
                         PIXEL01_C
                         PIXEL02_1M
@@ -632,7 +622,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 146:
                 case 178: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_1M
                         PIXEL12_C
@@ -652,7 +642,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 84:
                 case 85: {
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL02_1U
                         PIXEL12_C
                         PIXEL21_C
@@ -672,7 +662,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 112:
                 case 113: {
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL20_1L
                         PIXEL21_C
@@ -692,7 +682,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 200:
                 case 204: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_1M
                         PIXEL21_C
@@ -712,7 +702,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 73:
                 case 77: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL00_1U
                         PIXEL10_C
                         PIXEL20_1M
@@ -732,7 +722,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 42:
                 case 170: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                         PIXEL01_C
                         PIXEL10_C
@@ -752,7 +742,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 14:
                 case 142: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                         PIXEL01_C
                         PIXEL02_1R
@@ -868,7 +858,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 26:
                 case 31: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL10_C
                     } else {
@@ -876,7 +866,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_3
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                         PIXEL12_C
                     } else {
@@ -892,7 +882,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 82:
                 case 214: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                     } else {
@@ -903,7 +893,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11
                     PIXEL12_C
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL21_C
                         PIXEL22_C
                     } else {
@@ -918,7 +908,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL01_1
                     PIXEL02_1M
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                     } else {
@@ -926,7 +916,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL20_4
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL22_C
                     } else {
@@ -937,7 +927,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 74:
                 case 107: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                     } else {
@@ -948,7 +938,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                         PIXEL21_C
                     } else {
@@ -959,7 +949,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 27: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -978,7 +968,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 86: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -1001,7 +991,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -1018,7 +1008,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1M
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -1032,7 +1022,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 30: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -1055,7 +1045,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_1
                     PIXEL11
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -1072,7 +1062,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1M
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -1085,7 +1075,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 75: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -1247,13 +1237,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 58: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -1269,7 +1259,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 83: {
                     PIXEL00_1L
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -1279,7 +1269,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL12_C
                     PIXEL20_1M
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -1293,13 +1283,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -1307,7 +1297,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 202: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
@@ -1317,7 +1307,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
@@ -1327,7 +1317,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 78: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
@@ -1337,7 +1327,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
@@ -1347,13 +1337,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 154: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -1369,7 +1359,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 114: {
                     PIXEL00_1M
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -1379,7 +1369,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL12_C
                     PIXEL20_1L
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -1393,13 +1383,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -1407,13 +1397,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 90: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -1421,13 +1411,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -1436,7 +1426,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 55:
                 case 23: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL00_1L
                         PIXEL01_C
                         PIXEL02_C
@@ -1456,7 +1446,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 182:
                 case 150: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -1476,7 +1466,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 213:
                 case 212: {
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL02_1U
                         PIXEL12_C
                         PIXEL21_C
@@ -1496,7 +1486,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 241:
                 case 240: {
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL20_1L
                         PIXEL21_C
@@ -1516,7 +1506,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 236:
                 case 232: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -1536,7 +1526,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 109:
                 case 105: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL00_1U
                         PIXEL10_C
                         PIXEL20_C
@@ -1556,7 +1546,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 171:
                 case 43: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -1576,7 +1566,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 143:
                 case 15: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL02_1R
@@ -1600,7 +1590,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1U
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -1613,7 +1603,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 203: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -1632,7 +1622,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 62: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -1655,7 +1645,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_1
                     PIXEL11
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -1668,7 +1658,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 118: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -1691,7 +1681,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -1708,7 +1698,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1R
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -1721,7 +1711,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 155: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -1840,12 +1830,12 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1U
                     PIXEL10_C
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -1857,12 +1847,12 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 158: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -1879,7 +1869,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 234: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
@@ -1888,7 +1878,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1M
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -1903,7 +1893,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 242: {
                     PIXEL00_1M
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -1911,7 +1901,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_1
                     PIXEL11
                     PIXEL20_1L
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -1923,7 +1913,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 59: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -1932,7 +1922,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL01_3
                         PIXEL10_3
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -1950,7 +1940,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1M
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -1959,7 +1949,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL20_4
                         PIXEL21_3
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -1968,7 +1958,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 87: {
                     PIXEL00_1L
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -1981,7 +1971,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11
                     PIXEL20_1M
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -1989,7 +1979,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 79: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -2001,7 +1991,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1R
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
@@ -2011,20 +2001,20 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 122: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
                     }
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -2033,7 +2023,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL20_4
                         PIXEL21_3
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -2041,12 +2031,12 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 94: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -2057,13 +2047,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     }
                     PIXEL10_C
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -2071,25 +2061,25 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 218: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
                     }
                     PIXEL10_C
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -2101,7 +2091,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 91: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -2110,20 +2100,20 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL01_3
                         PIXEL10_3
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
                     }
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -2179,13 +2169,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 186: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -2201,7 +2191,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 115: {
                     PIXEL00_1L
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -2211,7 +2201,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL12_C
                     PIXEL20_1L
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -2225,13 +2215,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -2239,7 +2229,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 206: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
@@ -2249,7 +2239,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
@@ -2266,7 +2256,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_1M
                     } else {
                         PIXEL20_2
@@ -2277,7 +2267,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 174:
                 case 46: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_1M
                     } else {
                         PIXEL00_2
@@ -2296,7 +2286,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 147: {
                     PIXEL00_1L
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_1M
                     } else {
                         PIXEL02_2
@@ -2319,7 +2309,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL12_C
                     PIXEL20_1L
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_1M
                     } else {
                         PIXEL22_2
@@ -2352,7 +2342,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 126: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -2362,7 +2352,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL12_3
                     }
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -2375,7 +2365,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 219: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -2387,7 +2377,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1M
                     PIXEL11
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -2399,7 +2389,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 125: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL00_1U
                         PIXEL10_C
                         PIXEL20_C
@@ -2418,7 +2408,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 221: {
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL02_1U
                         PIXEL12_C
                         PIXEL21_C
@@ -2437,7 +2427,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 207: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL02_1R
@@ -2456,7 +2446,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 238: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -2475,7 +2465,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 190: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -2494,7 +2484,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 187: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -2513,7 +2503,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 243: {
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL20_1L
                         PIXEL21_C
@@ -2532,7 +2522,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 119: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL00_1L
                         PIXEL01_C
                         PIXEL02_C
@@ -2558,7 +2548,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                     } else {
                         PIXEL20_2
@@ -2569,7 +2559,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 175:
                 case 47: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                     } else {
                         PIXEL00_2
@@ -2588,7 +2578,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 151: {
                     PIXEL00_1L
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                     } else {
                         PIXEL02_2
@@ -2611,7 +2601,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL12_C
                     PIXEL20_1L
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_C
                     } else {
                         PIXEL22_2
@@ -2623,7 +2613,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL01_C
                     PIXEL02_1M
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                     } else {
@@ -2631,7 +2621,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL20_4
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL22_C
                     } else {
@@ -2641,7 +2631,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 123: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                     } else {
@@ -2652,7 +2642,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                         PIXEL21_C
                     } else {
@@ -2663,7 +2653,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 95: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL10_C
                     } else {
@@ -2671,7 +2661,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_3
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                         PIXEL12_C
                     } else {
@@ -2686,7 +2676,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 222: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                     } else {
@@ -2697,7 +2687,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11
                     PIXEL12_C
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL21_C
                         PIXEL22_C
                     } else {
@@ -2712,7 +2702,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1U
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                     } else {
@@ -2720,7 +2710,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL20_4
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_C
                     } else {
                         PIXEL22_2
@@ -2733,13 +2723,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL02_1M
                     PIXEL10_C
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                     } else {
                         PIXEL20_2
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL22_C
                     } else {
@@ -2749,7 +2739,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 235: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                     } else {
@@ -2760,7 +2750,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                     } else {
                         PIXEL20_2
@@ -2770,7 +2760,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 111: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                     } else {
                         PIXEL00_2
@@ -2780,7 +2770,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                         PIXEL21_C
                     } else {
@@ -2791,13 +2781,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 63: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                     } else {
                         PIXEL00_2
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                         PIXEL12_C
                     } else {
@@ -2812,7 +2802,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 159: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL10_C
                     } else {
@@ -2820,7 +2810,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_3
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                     } else {
                         PIXEL02_2
@@ -2835,7 +2825,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 215: {
                     PIXEL00_1L
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                     } else {
                         PIXEL02_2
@@ -2844,7 +2834,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11
                     PIXEL12_C
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL21_C
                         PIXEL22_C
                     } else {
@@ -2855,7 +2845,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 246: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                     } else {
@@ -2867,7 +2857,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL12_C
                     PIXEL20_1L
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_C
                     } else {
                         PIXEL22_2
@@ -2876,7 +2866,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 254: {
                     PIXEL00_1M
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                     } else {
@@ -2884,14 +2874,14 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL02_4
                     }
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                     } else {
                         PIXEL10_3
                         PIXEL20_4
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL21_C
                         PIXEL22_C
@@ -2909,13 +2899,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                     } else {
                         PIXEL20_2
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_C
                     } else {
                         PIXEL22_2
@@ -2923,7 +2913,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 251: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                     } else {
@@ -2932,7 +2922,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     }
                     PIXEL02_1M
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL10_C
                         PIXEL20_C
                         PIXEL21_C
@@ -2941,7 +2931,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL20_2
                         PIXEL21_3
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL12_C
                         PIXEL22_C
                     } else {
@@ -2951,7 +2941,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 239: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                     } else {
                         PIXEL00_2
@@ -2961,7 +2951,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_1
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                     } else {
                         PIXEL20_2
@@ -2971,7 +2961,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 127: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL01_C
                         PIXEL10_C
@@ -2980,7 +2970,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL01_3
                         PIXEL10_3
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                         PIXEL12_C
                     } else {
@@ -2988,7 +2978,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL12_3
                     }
                     PIXEL11
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                         PIXEL21_C
                     } else {
@@ -2999,13 +2989,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 191: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                     } else {
                         PIXEL00_2
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                     } else {
                         PIXEL02_2
@@ -3019,14 +3009,14 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 223: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                         PIXEL10_C
                     } else {
                         PIXEL00_4
                         PIXEL10_3
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL01_C
                         PIXEL02_C
                         PIXEL12_C
@@ -3037,7 +3027,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     }
                     PIXEL11
                     PIXEL20_1M
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL21_C
                         PIXEL22_C
                     } else {
@@ -3049,7 +3039,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                 case 247: {
                     PIXEL00_1L
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                     } else {
                         PIXEL02_2
@@ -3059,7 +3049,7 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL12_C
                     PIXEL20_1L
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_C
                     } else {
                         PIXEL22_2
@@ -3067,13 +3057,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 255: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_C
                     } else {
                         PIXEL00_2
                     }
                     PIXEL01_C
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_C
                     } else {
                         PIXEL02_2
@@ -3081,13 +3071,13 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_C
                     PIXEL11
                     PIXEL12_C
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_C
                     } else {
                         PIXEL20_2
                     }
                     PIXEL21_C
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_C
                     } else {
                         PIXEL22_2
@@ -3098,3 +3088,8 @@ void hq3x(Pixbuf const &src, Pixbuf &dst) {
         }
     }
 }
+
+
+void hq3x(Pixbuf const &src, Pixbuf &dst) {
+    hqx_scale(src, dst, hq3x_rows);
+}
@@ -32,6 +32,9 @@
  *
  * The RGBtoYUV lookup table is removed, as scaling is only done once
  * in GDash for every cave loading, not continuously during the game.
+ * Instead, every pixel is converted only once, and the patterns and
+ * the edge differences are determined for whole rows by HqxPatterns.
+ * Big pictures are scaled in row bands, in parallel.
  *
  * The interpolation functions are changed so they do not produce
  * overflows for the most significant bytes. So when calculating, they
@@ -186,7 +189,7 @@
 #define PIXEL33_81    Interp8(dp+dpL+dpL+dpL+3, w[5], w[6]);
 #define PIXEL33_82    Interp8(dp+dpL+dpL+dpL+3, w[5], w[8]);
 
-void hq4x(Pixbuf const &src, Pixbuf &dst) {
+static void hq4x_rows(Pixbuf const &src, Pixbuf &dst, int first_row, int last_row) {
     guint32  w[10];
 
     //   +----+----+----+
@@ -203,9 +206,11 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
     int sw = src.get_width();
     int sh = src.get_height();
     int dpL = dst.get_pitch() / 4; /* 4 bytes/pixel */
+    HqxPatterns patterns(src);
 
-    for (int j = 0; j < sh; j++) {
+    for (int j = first_row; j < last_row; j++) {
         const guint32 *line = src.get_row(j);
+        const guint16 *row_patterns = patterns.get_row(j);
         const guint32 *prevline, *nextline;
         if (j > 0)      prevline = src.get_row(j - 1);
         else prevline = src.get_row(sh - 1);
@@ -237,23 +242,8 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 w[9] = nextline[0];
             }
 
-            int pattern = 0;
-            int flag = 1;
-
-            guint32 YUV1 = RGBtoYUV(w[5]);
-
-            for (int k = 1; k <= 9; k++) {
-                if (k == 5) continue;
-
-                if (w[k] != w[5]) {
-                    guint32 YUV2 = RGBtoYUV(w[k]);
-                    if ((abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY) ||
-                            (abs((YUV1 & Umask) - (YUV2 & Umask)) > trU) ||
-                            (abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV))
-                        pattern |= flag;
-                }
-                flag <<= 1;
-            }
+            int pattern = row_patterns[i] & 0xff;
+            int edges = row_patterns[i] >> 8;
 
             guint32 *dp = dst.get_row(j * 4) + i * 4;
 
@@ -560,7 +550,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 50: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -595,7 +585,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL13_10
                     PIXEL20_61
                     PIXEL21_30
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -620,7 +610,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_70
                     PIXEL13_60
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -639,7 +629,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 10:
                 case 138: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -790,7 +780,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 54: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -825,7 +815,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_61
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -848,7 +838,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_70
                     PIXEL13_60
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -866,7 +856,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 11:
                 case 139: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -892,7 +882,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 19:
                 case 51: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL00_81
                         PIXEL01_31
                         PIXEL02_10
@@ -923,7 +913,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 178: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -953,7 +943,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_20
                     PIXEL01_60
                     PIXEL02_81
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL03_81
                         PIXEL13_31
                         PIXEL22_30
@@ -989,7 +979,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL13_10
                     PIXEL20_82
                     PIXEL21_32
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL30_82
@@ -1016,7 +1006,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_70
                     PIXEL13_60
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -1037,7 +1027,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 73:
                 case 77: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL00_82
                         PIXEL10_32
                         PIXEL20_10
@@ -1066,7 +1056,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 42:
                 case 170: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -1095,7 +1085,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 14:
                 case 142: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL02_32
@@ -1276,7 +1266,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 26:
                 case 31: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -1285,7 +1275,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL01_50
                         PIXEL10_50
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -1310,7 +1300,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 214: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -1325,7 +1315,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_61
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -1348,7 +1338,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_30
                     PIXEL13_10
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -1359,7 +1349,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     }
                     PIXEL21_0
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -1372,7 +1362,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 74:
                 case 107: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -1386,7 +1376,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_0
                     PIXEL12_30
                     PIXEL13_61
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -1403,7 +1393,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 27: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -1430,7 +1420,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 86: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -1464,7 +1454,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_10
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -1486,7 +1476,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_30
                     PIXEL13_61
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -1505,7 +1495,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 30: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -1539,7 +1529,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_61
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -1561,7 +1551,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_30
                     PIXEL13_10
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -1578,7 +1568,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 75: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -1831,7 +1821,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 58: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -1842,7 +1832,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_11
                         PIXEL11_0
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -1866,7 +1856,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 83: {
                     PIXEL00_81
                     PIXEL01_31
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -1881,7 +1871,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_31
                     PIXEL20_61
                     PIXEL21_30
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -1905,7 +1895,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_31
                     PIXEL13_31
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -1916,7 +1906,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL30_20
                         PIXEL31_11
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -1930,7 +1920,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 202: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -1945,7 +1935,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL03_80
                     PIXEL12_30
                     PIXEL13_61
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -1963,7 +1953,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 78: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -1978,7 +1968,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL03_82
                     PIXEL12_32
                     PIXEL13_82
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -1996,7 +1986,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 154: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -2007,7 +1997,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_11
                         PIXEL11_0
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -2031,7 +2021,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 114: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -2046,7 +2036,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL20_82
                     PIXEL21_32
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -2070,7 +2060,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_32
                     PIXEL12_30
                     PIXEL13_10
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -2081,7 +2071,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL30_20
                         PIXEL31_11
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -2095,7 +2085,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 90: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -2106,7 +2096,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_11
                         PIXEL11_0
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -2117,7 +2107,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL12_0
                         PIXEL13_12
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -2128,7 +2118,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL30_20
                         PIXEL31_11
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -2143,7 +2133,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 55:
                 case 23: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL00_81
                         PIXEL01_31
                         PIXEL02_0
@@ -2174,7 +2164,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 150: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL12_0
@@ -2204,7 +2194,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_20
                     PIXEL01_60
                     PIXEL02_81
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL03_81
                         PIXEL13_31
                         PIXEL22_0
@@ -2240,7 +2230,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL13_10
                     PIXEL20_82
                     PIXEL21_32
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_0
                         PIXEL23_0
                         PIXEL30_82
@@ -2267,7 +2257,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_70
                     PIXEL13_60
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL21_0
                         PIXEL30_0
@@ -2288,7 +2278,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 109:
                 case 105: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL00_82
                         PIXEL10_32
                         PIXEL20_0
@@ -2317,7 +2307,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 171:
                 case 43: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -2346,7 +2336,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 143:
                 case 15: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL02_32
@@ -2382,7 +2372,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_31
                     PIXEL13_31
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -2399,7 +2389,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 203: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -2426,7 +2416,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 62: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -2460,7 +2450,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_61
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -2476,7 +2466,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 118: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -2510,7 +2500,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_10
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -2532,7 +2522,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_32
                     PIXEL13_82
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -2549,7 +2539,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 155: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -2734,7 +2724,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_31
                     PIXEL13_31
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -2746,7 +2736,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL31_11
                     }
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -2758,7 +2748,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 158: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -2769,7 +2759,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_11
                         PIXEL11_0
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -2790,7 +2780,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 234: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -2805,7 +2795,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL03_80
                     PIXEL12_30
                     PIXEL13_61
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -2824,7 +2814,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 242: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -2840,7 +2830,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_82
                     PIXEL21_32
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -2854,7 +2844,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 59: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -2863,7 +2853,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL01_50
                         PIXEL10_50
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -2894,7 +2884,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_32
                     PIXEL12_30
                     PIXEL13_10
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -2904,7 +2894,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL31_50
                     }
                     PIXEL21_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -2920,7 +2910,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 87: {
                     PIXEL00_81
                     PIXEL01_31
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -2934,7 +2924,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL12_0
                     PIXEL20_61
                     PIXEL21_30
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -2950,7 +2940,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 79: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -2964,7 +2954,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_0
                     PIXEL12_32
                     PIXEL13_82
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -2982,7 +2972,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 122: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -2993,7 +2983,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_11
                         PIXEL11_0
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -3004,7 +2994,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL12_0
                         PIXEL13_12
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -3014,7 +3004,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL31_50
                     }
                     PIXEL21_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -3028,7 +3018,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 94: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -3039,7 +3029,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_11
                         PIXEL11_0
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -3049,7 +3039,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL13_50
                     }
                     PIXEL12_0
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -3060,7 +3050,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL30_20
                         PIXEL31_11
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -3074,7 +3064,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 218: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -3085,7 +3075,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_11
                         PIXEL11_0
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -3096,7 +3086,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL12_0
                         PIXEL13_12
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -3108,7 +3098,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL31_11
                     }
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -3120,7 +3110,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 91: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -3129,7 +3119,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL01_50
                         PIXEL10_50
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -3141,7 +3131,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL13_12
                     }
                     PIXEL11_0
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -3152,7 +3142,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL30_20
                         PIXEL31_11
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -3242,7 +3232,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 186: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -3253,7 +3243,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_11
                         PIXEL11_0
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -3277,7 +3267,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 115: {
                     PIXEL00_81
                     PIXEL01_31
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -3292,7 +3282,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_31
                     PIXEL20_82
                     PIXEL21_32
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -3316,7 +3306,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_32
                     PIXEL12_31
                     PIXEL13_31
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -3327,7 +3317,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL30_20
                         PIXEL31_11
                     }
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -3341,7 +3331,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 206: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -3356,7 +3346,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL03_82
                     PIXEL12_32
                     PIXEL13_82
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -3383,7 +3373,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_32
                     PIXEL12_70
                     PIXEL13_60
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_10
                         PIXEL21_30
                         PIXEL30_80
@@ -3402,7 +3392,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 174:
                 case 46: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_80
                         PIXEL01_10
                         PIXEL10_10
@@ -3431,7 +3421,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 147: {
                     PIXEL00_81
                     PIXEL01_31
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_10
                         PIXEL03_80
                         PIXEL12_30
@@ -3466,7 +3456,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL13_31
                     PIXEL20_82
                     PIXEL21_32
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_30
                         PIXEL23_10
                         PIXEL32_10
@@ -3522,7 +3512,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 126: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -3534,7 +3524,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_10
                     PIXEL11_30
                     PIXEL12_0
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -3551,7 +3541,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 219: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -3568,7 +3558,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_10
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -3582,7 +3572,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 125: {
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL00_82
                         PIXEL10_32
                         PIXEL20_0
@@ -3613,7 +3603,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_82
                     PIXEL01_82
                     PIXEL02_81
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL03_81
                         PIXEL13_31
                         PIXEL22_0
@@ -3638,7 +3628,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 207: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL02_32
@@ -3674,7 +3664,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_32
                     PIXEL13_82
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL21_0
                         PIXEL30_0
@@ -3696,7 +3686,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 190: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL12_0
@@ -3722,7 +3712,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 187: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -3760,7 +3750,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL13_10
                     PIXEL20_82
                     PIXEL21_32
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL22_0
                         PIXEL23_0
                         PIXEL30_82
@@ -3778,7 +3768,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 119: {
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL00_81
                         PIXEL01_31
                         PIXEL02_0
@@ -3819,7 +3809,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL21_0
                     PIXEL22_31
                     PIXEL23_81
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL30_0
                     } else {
                         PIXEL30_20
@@ -3831,7 +3821,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 }
                 case 175:
                 case 47: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
@@ -3858,7 +3848,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_81
                     PIXEL01_31
                     PIXEL02_0
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL03_0
                     } else {
                         PIXEL03_20
@@ -3894,7 +3884,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL30_82
                     PIXEL31_32
                     PIXEL32_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL33_0
                     } else {
                         PIXEL33_20
@@ -3910,7 +3900,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_30
                     PIXEL13_10
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -3921,7 +3911,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     }
                     PIXEL21_0
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -3933,7 +3923,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 123: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -3947,7 +3937,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_0
                     PIXEL12_30
                     PIXEL13_10
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -3964,7 +3954,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 95: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -3973,7 +3963,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL01_50
                         PIXEL10_50
                     }
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -3997,7 +3987,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 222: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -4012,7 +4002,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_10
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -4034,7 +4024,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_30
                     PIXEL12_31
                     PIXEL13_31
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -4047,7 +4037,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL22_0
                     PIXEL23_0
                     PIXEL32_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL33_0
                     } else {
                         PIXEL33_20
@@ -4066,7 +4056,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_0
                     PIXEL21_0
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -4075,7 +4065,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL32_50
                         PIXEL33_50
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL30_0
                     } else {
                         PIXEL30_20
@@ -4084,7 +4074,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 235: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -4102,7 +4092,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL21_0
                     PIXEL22_31
                     PIXEL23_81
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL30_0
                     } else {
                         PIXEL30_20
@@ -4113,7 +4103,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 111: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
@@ -4125,7 +4115,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL11_0
                     PIXEL12_32
                     PIXEL13_82
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -4142,13 +4132,13 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 63: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_0
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -4171,7 +4161,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 159: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -4181,7 +4171,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_50
                     }
                     PIXEL02_0
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL03_0
                     } else {
                         PIXEL03_20
@@ -4203,7 +4193,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_81
                     PIXEL01_31
                     PIXEL02_0
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL03_0
                     } else {
                         PIXEL03_20
@@ -4215,7 +4205,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_61
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -4231,7 +4221,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 246: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -4250,7 +4240,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL30_82
                     PIXEL31_32
                     PIXEL32_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL33_0
                     } else {
                         PIXEL33_20
@@ -4260,7 +4250,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                 case 254: {
                     PIXEL00_80
                     PIXEL01_10
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -4272,7 +4262,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_10
                     PIXEL11_30
                     PIXEL12_0
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -4285,7 +4275,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL22_0
                     PIXEL23_0
                     PIXEL32_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL33_0
                     } else {
                         PIXEL33_20
@@ -4305,14 +4295,14 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL21_0
                     PIXEL22_0
                     PIXEL23_0
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL30_0
                     } else {
                         PIXEL30_20
                     }
                     PIXEL31_0
                     PIXEL32_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL33_0
                     } else {
                         PIXEL33_20
@@ -4320,7 +4310,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 251: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -4337,7 +4327,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_0
                     PIXEL21_0
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -4346,7 +4336,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL32_50
                         PIXEL33_50
                     }
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL30_0
                     } else {
                         PIXEL30_20
@@ -4355,7 +4345,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 239: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
@@ -4371,7 +4361,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL21_0
                     PIXEL22_31
                     PIXEL23_81
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL30_0
                     } else {
                         PIXEL30_20
@@ -4382,13 +4372,13 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 127: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_0
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL02_0
                         PIXEL03_0
                         PIXEL13_0
@@ -4400,7 +4390,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL10_0
                     PIXEL11_0
                     PIXEL12_0
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL20_0
                         PIXEL30_0
                         PIXEL31_0
@@ -4417,14 +4407,14 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 191: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_0
                     PIXEL02_0
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL03_0
                     } else {
                         PIXEL03_20
@@ -4444,7 +4434,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 223: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                         PIXEL01_0
                         PIXEL10_0
@@ -4454,7 +4444,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                         PIXEL10_50
                     }
                     PIXEL02_0
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL03_0
                     } else {
                         PIXEL03_20
@@ -4465,7 +4455,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL20_10
                     PIXEL21_30
                     PIXEL22_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL23_0
                         PIXEL32_0
                         PIXEL33_0
@@ -4482,7 +4472,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL00_81
                     PIXEL01_31
                     PIXEL02_0
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL03_0
                     } else {
                         PIXEL03_20
@@ -4498,7 +4488,7 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL30_82
                     PIXEL31_32
                     PIXEL32_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL33_0
                     } else {
                         PIXEL33_20
@@ -4506,14 +4496,14 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     break;
                 }
                 case 255: {
-                    if (Diff(w[4], w[2])) {
+                    if (HQX_DIFF_4_2) {
                         PIXEL00_0
                     } else {
                         PIXEL00_20
                     }
                     PIXEL01_0
                     PIXEL02_0
-                    if (Diff(w[2], w[6])) {
+                    if (HQX_DIFF_2_6) {
                         PIXEL03_0
                     } else {
                         PIXEL03_20
@@ -4526,14 +4516,14 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
                     PIXEL21_0
                     PIXEL22_0
                     PIXEL23_0
-                    if (Diff(w[8], w[4])) {
+                    if (HQX_DIFF_8_4) {
                         PIXEL30_0
                     } else {
                         PIXEL30_20
                     }
                     PIXEL31_0
                     PIXEL32_0
-                    if (Diff(w[6], w[8])) {
+                    if (HQX_DIFF_6_8) {
                         PIXEL33_0
                     } else {
                         PIXEL33_20
@@ -4544,3 +4534,8 @@ void hq4x(Pixbuf const &src, Pixbuf &dst) {
         }
     }
 }
+
+
+void hq4x(Pixbuf const &src, Pixbuf &dst) {
+    hqx_scale(src, dst, hq4x_rows);
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Common parts of the hq2x, hq3x and hq4x scalers: pattern detection
+ * for whole rows, and cutting the pictures into bands for parallel
+ * scaling. The interpolation rules themselves are in the scaler files.
+ */
+
+#include "config.h"
+
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "gfx/pixbufmanip_hqx.hpp"
+#include "misc/parallel.hpp"
+
+
+#ifdef __SSE2__
+/* Convert four pixels to YUV. The same integer formulas are used as in
+ * RGBtoYUV(); the intermediate values of u and v may be negative, but
+ * the final results are in 0..65535, so the 16-bit wraparound
+ * arithmetic gives exactly the same numbers. */
+static inline __m128i rgb_to_yuv_sse2(__m128i p) {
+    __m128i const byte = _mm_set1_epi32(0xff);
+    __m128i const zero = _mm_setzero_si128();
+    /* values are 0..255, so packing with signed saturation does not change them */
+    __m128i r = _mm_and_si128(_mm_srli_epi32(p, Pixbuf::rshift), byte);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(p, Pixbuf::gshift), byte);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(p, Pixbuf::bshift), byte);
+    r = _mm_packs_epi32(r, zero);
+    g = _mm_packs_epi32(g, zero);
+    b = _mm_packs_epi32(b, zero);
+
+    __m128i y = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(77)),
+                                            _mm_mullo_epi16(g, _mm_set1_epi16(150))),
+                              _mm_mullo_epi16(b, _mm_set1_epi16(29)));
+    __m128i u = _mm_sub_epi16(_mm_add_epi16(_mm_set1_epi16(-32768), _mm_slli_epi16(b, 7)),
+                              _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(43)),
+                                            _mm_mullo_epi16(g, _mm_set1_epi16(85))));
+    __m128i v = _mm_sub_epi16(_mm_add_epi16(_mm_set1_epi16(-32768), _mm_slli_epi16(r, 7)),
+                              _mm_add_epi16(_mm_mullo_epi16(g, _mm_set1_epi16(107)),
+                                            _mm_mullo_epi16(b, _mm_set1_epi16(21))));
+    y = _mm_srli_epi16(y, 8);
+    u = _mm_srli_epi16(u, 8);
+    v = _mm_srli_epi16(v, 8);
+
+    /* (y << 16) + (u << 8) + v */
+    return _mm_unpacklo_epi16(_mm_or_si128(_mm_slli_epi16(u, 8), v), y);
+}
+
+
+/* Four bits, set where the YUV colors differ more than the thresholds.
+ * The components are bytes in the YUV values, so the absolute differences
+ * can be computed with saturated byte arithmetic. */
+static inline int diff_sse2(__m128i yuv1, __m128i yuv2) {
+    __m128i const thresholds = _mm_set1_epi32((trY | trU | trV));
+    __m128i absdiff = _mm_or_si128(_mm_subs_epu8(yuv1, yuv2), _mm_subs_epu8(yuv2, yuv1));
+    __m128i over = _mm_subs_epu8(absdiff, thresholds);
+    __m128i same = _mm_cmpeq_epi32(over, _mm_setzero_si128());
+    return ~_mm_movemask_ps(_mm_castsi128_ps(same)) & 0xf;
+}
+#endif
+
+
+HqxPatterns::HqxPatterns(Pixbuf const &src)
+    :   src(src),
+        width(src.get_width()),
+        height(src.get_height()),
+        current_row(-1),
+        yuv_prev(width + 2),
+        yuv_line(width + 2),
+        yuv_next(width + 2),
+        patterns(width) {
+}
+
+
+void HqxPatterns::convert_row(int j, std::vector<guint32> &yuv) {
+    const guint32 *line = src.get_row(j);
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= width; i += 4)
+        _mm_storeu_si128((__m128i *) &yuv[i + 1], rgb_to_yuv_sse2(_mm_loadu_si128((__m128i const *) &line[i])));
+#endif
+    for (; i < width; i++)
+        yuv[i + 1] = RGBtoYUV(line[i]);
+    /* wrap around at the edges */
+    yuv[0] = yuv[width];
+    yuv[width + 1] = yuv[1];
+}
+
+
+const guint16 *HqxPatterns::get_row(int j) {
+    int prev = j > 0 ? j - 1 : height - 1;
+    int next = j < height - 1 ? j + 1 : 0;
+    if (current_row != -1 && j == current_row + 1) {
+        /* moving one row down: only the next row is new */
+        yuv_prev.swap(yuv_line);
+        yuv_line.swap(yuv_next);
+        convert_row(next, yuv_next);
+    } else if (j != current_row) {
+        convert_row(prev, yuv_prev);
+        convert_row(j, yuv_line);
+        convert_row(next, yuv_next);
+    }
+    current_row = j;
+
+    //   +----+----+----+
+    //   |    |    |    |
+    //   | w1 | w2 | w3 |    pixel i is at index i+1 of the yuv vectors,
+    //   +----+----+----+    so w1 of pixel i is at index i of yuv_prev,
+    //   |    |    |    |    w2 is at i+1, and w3 is at i+2.
+    //   | w4 | w5 | w6 |
+    //   +----+----+----+
+    //   |    |    |    |
+    //   | w7 | w8 | w9 |
+    //   +----+----+----+
+    const guint32 *p = &yuv_prev[0], *l = &yuv_line[0], *n = &yuv_next[0];
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= width; i += 4) {
+        __m128i w1 = _mm_loadu_si128((__m128i const *) &p[i]);
+        __m128i w2 = _mm_loadu_si128((__m128i const *) &p[i + 1]);
+        __m128i w3 = _mm_loadu_si128((__m128i const *) &p[i + 2]);
+        __m128i w4 = _mm_loadu_si128((__m128i const *) &l[i]);
+        __m128i w5 = _mm_loadu_si128((__m128i const *) &l[i + 1]);
+        __m128i w6 = _mm_loadu_si128((__m128i const *) &l[i + 2]);
+        __m128i w7 = _mm_loadu_si128((__m128i const *) &n[i]);
+        __m128i w8 = _mm_loadu_si128((__m128i const *) &n[i + 1]);
+        __m128i w9 = _mm_loadu_si128((__m128i const *) &n[i + 2]);
+        int d[12] = {
+            diff_sse2(w5, w1), diff_sse2(w5, w2), diff_sse2(w5, w3), diff_sse2(w5, w4),
+            diff_sse2(w5, w6), diff_sse2(w5, w7), diff_sse2(w5, w8), diff_sse2(w5, w9),
+            diff_sse2(w4, w2), diff_sse2(w2, w6), diff_sse2(w6, w8), diff_sse2(w8, w4),
+        };
+        /* d[bit] has the bits of the four pixels; collect the bits of each pixel */
+        for (int k = 0; k < 4; ++k) {
+            guint16 pattern = 0;
+            for (int bit = 0; bit < 12; ++bit)
+                pattern |= ((d[bit] >> k) & 1) << bit;
+            patterns[i + k] = pattern;
+        }
+    }
+#endif
+    for (; i < width; i++) {
+        guint32 w5 = l[i + 1];
+        guint16 pattern = 0;
+        if (DiffYUV(w5, p[i])) pattern |= 0x01;
+        if (DiffYUV(w5, p[i + 1])) pattern |= 0x02;
+        if (DiffYUV(w5, p[i + 2])) pattern |= 0x04;
+        if (DiffYUV(w5, l[i])) pattern |= 0x08;
+        if (DiffYUV(w5, l[i + 2])) pattern |= 0x10;
+        if (DiffYUV(w5, n[i])) pattern |= 0x20;
+        if (DiffYUV(w5, n[i + 1])) pattern |= 0x40;
+        if (DiffYUV(w5, n[i + 2])) pattern |= 0x80;
+        if (DiffYUV(l[i], p[i + 1])) pattern |= HQX_EDGE_4_2 << 8;
+        if (DiffYUV(p[i + 1], l[i + 2])) pattern |= HQX_EDGE_2_6 << 8;
+        if (DiffYUV(l[i + 2], n[i + 1])) pattern |= HQX_EDGE_6_8 << 8;
+        if (DiffYUV(n[i + 1], l[i])) pattern |= HQX_EDGE_8_4 << 8;
+        patterns[i] = pattern;
+    }
+
+    return &patterns[0];
+}
+
+
+namespace {
+struct HqxBands {
+    Pixbuf const *src;
+    Pixbuf *dst;
+    HqxRowsFunc rows_func;
+    unsigned bands;
+};
+}
+
+static void hqx_band(unsigned band, gpointer data) {
+    HqxBands *b = static_cast<HqxBands *>(data);
+    int height = b->src->get_height();
+    int first_row = height * band / b->bands;
+    int last_row = height * (band + 1) / b->bands;
+    b->rows_func(*b->src, *b->dst, first_row, last_row);
+}
+
+
+void hqx_scale(Pixbuf const &src, Pixbuf &dst, HqxRowsFunc rows_func) {
+    /* small pictures, like the cells, are not worth starting threads for;
+     * they may be scaled on worker threads themselves. */
+    unsigned bands = 1;
+    if (src.get_width() * src.get_height() >= 128 * 128)
+        bands = std::max(1, std::min(int(ParallelJobs::get_num_processors()), src.get_height() / 16));
+
+    HqxBands b = { &src, &dst, rows_func, bands };
+    gd_parallel_for(bands, hqx_band, &b);
+}
@@ -28,6 +28,7 @@
 
 #include <glib.h>
 #include <cstdlib>
+#include <vector>
 #include "gfx/pixbuf.hpp"
 
 #define Ymask 0x00FF0000
@@ -61,15 +62,65 @@ inline guint32 RGBtoYUV(guint32 c) {
     return (y << 16) + (u << 8) + v;
 }
 
+/* Test if there is difference in color, for already converted colors */
+inline int DiffYUV(guint32 YUV1, guint32 YUV2) {
+    return (abs(int((YUV1 & Ymask) - (YUV2 & Ymask))) > trY)
+           || (abs(int((YUV1 & Umask) - (YUV2 & Umask))) > trU)
+           || (abs(int((YUV1 & Vmask) - (YUV2 & Vmask))) > trV);
+}
+
 /* Test if there is difference in color */
 inline int Diff(guint32 w1, guint32 w2) {
-    guint32 YUV1 = RGBtoYUV(w1);
-    guint32 YUV2 = RGBtoYUV(w2);
-    return (abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY)
-           || (abs((YUV1 & Umask) - (YUV2 & Umask)) > trU)
-           || (abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV);
+    return DiffYUV(RGBtoYUV(w1), RGBtoYUV(w2));
 }
 
+
+/* Bits of the row patterns above the 8-bit neighbour pattern: the
+ * differences between the edge neighbours, which the scalers would
+ * otherwise test with Diff() in the switch. The macros expect a local
+ * "edges" variable, like the PIXEL macros expect w[] and dp. */
+#define HQX_EDGE_4_2 0x01
+#define HQX_EDGE_2_6 0x02
+#define HQX_EDGE_6_8 0x04
+#define HQX_EDGE_8_4 0x08
+#define HQX_DIFF_4_2 (edges & HQX_EDGE_4_2)
+#define HQX_DIFF_2_6 (edges & HQX_EDGE_2_6)
+#define HQX_DIFF_6_8 (edges & HQX_EDGE_6_8)
+#define HQX_DIFF_8_4 (edges & HQX_EDGE_8_4)
+
+
+/// @brief Computes the hqx patterns of a picture row by row.
+///
+/// Every pixel is converted to YUV only once, and the neighbour pattern
+/// (bits 0-7) and the edge differences (bits 8-11) of a whole row are
+/// determined at a time, with SSE2 where available. When the rows are
+/// asked for in increasing order, the converted rows are reused. The
+/// results are the same as testing the neighbours with Diff().
+class HqxPatterns {
+public:
+    explicit HqxPatterns(Pixbuf const &src);
+    /// Get the patterns of row j; valid until the next call.
+    const guint16 *get_row(int j);
+
+private:
+    Pixbuf const &src;
+    int width, height;
+    int current_row;
+    /// Converted rows above, at and below the current one. For easy wraparound,
+    /// they are one pixel longer at both ends: pixel i is at index i+1.
+    std::vector<guint32> yuv_prev, yuv_line, yuv_next;
+    std::vector<guint16> patterns;
+
+    void convert_row(int j, std::vector<guint32> &yuv);
+};
+
+/// The function type of the row range scalers used by hqx_scale.
+typedef void (*HqxRowsFunc)(Pixbuf const &src, Pixbuf &dst, int first_row, int last_row);
+
+/// Scale the picture with the given row range scaler. Big pictures are
+/// cut into row bands, which are scaled in parallel.
+void hqx_scale(Pixbuf const &src, Pixbuf &dst, HqxRowsFunc rows_func);
+
 /* Interpolate functions */
 inline void Interp1(guint32 *pc, guint32 c1, guint32 c2) {
     //*pc = (c1*3+c2)/4;
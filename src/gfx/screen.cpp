@@ -27,6 +27,8 @@
 #include "gfx/screen.hpp"
 #include "gfx/pixbuffactory.hpp"
 #include "gfx/pixmapstorage.hpp"
+#include "cave/particle.hpp"
+#include "misc/frametimes.hpp"
 
 
 #include "gdash_icon_32.cpp"
@@ -107,6 +109,22 @@ void Screen::flip() {
 }
 
 
+void Screen::do_the_flip() {
+    did_some_drawing = false;
+    {
+        FrameTimeMeasure measure(FrameTimes::Flip);
+        flip();
+    }
+    gd_frame_times.frame_finished();
+}
+
+
 
 void Screen::draw_particle_set(int dx, int dy, ParticleSet const &ps) {
 }
+
+
+void Screen::draw_particles(int dx, int dy, ParticleSystem const &particles) {
+    for (unsigned i = 0; i < particles.num_sets(); ++i)
+        draw_particle_set(dx, dy, particles.get_set(i));
+}
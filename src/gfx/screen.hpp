@@ -32,6 +32,7 @@
 
 class GdColor;
 class ParticleSet;
+class ParticleSystem;
 class Pixbuf;
 class PixmapStorage;
 
@@ -99,6 +100,11 @@ public:
         return scaling_factor;
     }
 
+    /// @brief Return the software scaling algorithm used for the pixbuf->pixmap.
+    GdScalingType get_scaling_type() const {
+        return scaling_type;
+    }
+
     /// @brief Returns true, if the screen uses software pal emulation.
     bool get_pal_emulation() const {
         return pal_emulation;
@@ -131,6 +137,9 @@ public:
     virtual void remove_clip_rect() = 0;
 
     virtual void draw_particle_set(int dx, int dy, ParticleSet const &ps);
+    /// @brief Draw all particle sets of a particle system, oldest first.
+    /// The default implementation draws them one by one with draw_particle_set().
+    virtual void draw_particles(int dx, int dy, ParticleSystem const &particles);
 
     /**
      * Returns if the screen is double buffered, which means that everything must be redrawn
@@ -157,12 +166,10 @@ public:
     }
 
     /**
-     *
+     * Show the drawing on the screen. This also ends the frame
+     * in the frame time measurements.
      */
-    void do_the_flip() {
-        did_some_drawing = false;
-        flip();
-    }
+    void do_the_flip();
     
     static unsigned char const *gdash_icon_32_png;
     static unsigned const gdash_icon_32_size;
@@ -197,11 +197,11 @@ void GTKScreen::draw_particle_set(int dx, int dy, ParticleSet const &ps) {
      * dx0, dy0 are the center, and the sides "outgrow". */
     double dxm = dx - size, dx0 = dx + 0.5, dxp = dx + size + 1;
     double dym = dy - size, dy0 = dy + 0.5, dyp = dy + size + 1;
-    for (ParticleSet::const_iterator it = ps.begin(); it != ps.end(); ++it) {
-        cairo_move_to(cr, (int)it->px + dx0, (int)it->py + dym);
-        cairo_line_to(cr, (int)it->px + dxp, (int)it->py + dy0);
-        cairo_line_to(cr, (int)it->px + dx0, (int)it->py + dyp);
-        cairo_line_to(cr, (int)it->px + dxm, (int)it->py + dy0);
+    for (unsigned i = 0; i < ps.count; ++i) {
+        cairo_move_to(cr, (int)ps.px[i] + dx0, (int)ps.py[i] + dym);
+        cairo_line_to(cr, (int)ps.px[i] + dxp, (int)ps.py[i] + dy0);
+        cairo_line_to(cr, (int)ps.px[i] + dx0, (int)ps.py[i] + dyp);
+        cairo_line_to(cr, (int)ps.px[i] + dxm, (int)ps.py[i] + dy0);
         cairo_fill(cr);
     }
 }
@@ -43,9 +43,12 @@
 #include "misc/util.hpp"
 #include "misc/logger.hpp"
 #include "misc/about.hpp"
+#include "misc/frametimes.hpp"
+#include "misc/trace.hpp"
 #include "settings.hpp"
 #include "framework/commands.hpp"
 #include "fileops/loadfile.hpp"
+#include "fileops/mappedfile.hpp"
 #include "fileops/highscore.hpp"
 #include "fileops/binaryimport.hpp"
 #include "input/joystick.hpp"
@@ -76,6 +79,8 @@ int main(int argc, char *argv[]) {
     char *gallery_filename = NULL;
     char *png_filename = NULL, *png_size = NULL;
     char *save_cave_name = NULL, *save_gds_name = NULL;
+    char *frame_times_filename = NULL;
+    char *trace_filename = NULL;
 #ifdef HAVE_GTK
     int save_doc_lang = -1;
 #endif
@@ -95,6 +100,8 @@ int main(int argc, char *argv[]) {
 #ifdef HAVE_GTK
         {"save-docs", 0, 0, G_OPTION_ARG_INT, &save_doc_lang, N_("Save documentation in HTML, in the given language identified by an integer.")},
 #endif
+        {"frame-times", 0, 0, G_OPTION_ARG_FILENAME, &frame_times_filename, N_("Save the frame times of the last frames to a CSV file on exit")},
+        {"trace", 0, 0, G_OPTION_ARG_FILENAME, &trace_filename, N_("Save a timeline of loading, rendering and drawing to a file in the Chrome trace format")},
         {"quit", 'q', 0, G_OPTION_ARG_NONE, &quit, N_("Batch mode: quit after specified tasks")},
         {NULL}
     };
@@ -123,6 +130,9 @@ int main(int argc, char *argv[]) {
 
     Logger global_logger;
 
+    if (trace_filename != NULL && !gd_trace_open(trace_filename))
+        gd_warning(CPrintf("Cannot open trace file %s") % trace_filename);
+
     gd_settings_init();
     gd_settings_init_dirs();
     if (!gd_param_load_default_settings)
@@ -151,9 +161,8 @@ int main(int argc, char *argv[]) {
             g_print("An input filename must be given for GDS conversion.\n");
             return 1;
         }
-        std::vector<unsigned char> file = load_file_to_vector(gd_param_cavenames[0]);
-        /* -1 because the file loader adds a terminating zero */
-        std::vector<unsigned char> memory = load_memory_dump(&file[0], file.size() - 1);
+        MappedFile file(gd_param_cavenames[0]);
+        std::vector<unsigned char> memory = load_memory_dump(file.get_contents(), file.get_length());
         std::vector<unsigned char> gds = gdash_binary_import(memory);
         std::fstream os(save_gds_name, std::ios::out | std::ios::binary);
         os.write((char *) &gds[0], gds.size());
@@ -166,12 +175,12 @@ int main(int argc, char *argv[]) {
     try {
         if (gd_param_cavenames && gd_param_cavenames[0]) {
             caveset = load_caveset_from_file(gd_param_cavenames[0]);
-            load_highscore(caveset);
+            load_highscore_later(caveset);
         } else {
             /* if nothing requested, load default */
             caveset = create_from_buffer(level_pointers[0], -1);
             caveset.name = level_names[0];
-            load_highscore(caveset);
+            load_highscore_later(caveset);
         }
     } catch (std::exception &e) {
         /// @todo show error to the screen
@@ -302,6 +311,10 @@ restart_from_here:
 
     gd_save_settings();
 
+    if (frame_times_filename != NULL && !gd_frame_times.save_csv(frame_times_filename))
+        gd_warning(CPrintf("Cannot save frame times to %s") % frame_times_filename);
+    gd_trace_close();
+
     global_logger.clear();
 
 #ifdef HAVE_SDL
@@ -315,6 +328,8 @@ restart_from_here:
     g_free(png_filename);
     g_free(png_size);
     g_free(save_gds_name);
+    g_free(frame_times_filename);
+    g_free(trace_filename);
 
     return 0;
 }
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <glib.h>
+#include <algorithm>
+#include <fstream>
+
+#include "misc/frametimes.hpp"
+
+
+FrameTimes gd_frame_times;
+
+
+const char *FrameTimes::section_names[NumSections] = {
+    "frame",
+    "game",
+    "iterate",
+    "indexes",
+    "cave",
+    "status",
+    "particle",
+    "flip",
+};
+
+
+FrameTimes::FrameTimes()
+    : frame_count(0),
+      recording(false) {
+    std::fill(current.us, current.us + NumSections, 0);
+    last_frame_end = now();
+}
+
+
+void FrameTimes::start_recording() {
+    /* drop what was measured meanwhile, and do not count the time spent elsewhere in the first frame */
+    std::fill(current.us, current.us + NumSections, 0);
+    last_frame_end = now();
+    recording = true;
+}
+
+
+void FrameTimes::stop_recording() {
+    recording = false;
+}
+
+
+gint64 FrameTimes::now() {
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=28)
+    return g_get_monotonic_time();
+#else
+    GTimeVal tv;
+    g_get_current_time(&tv);
+    return gint64(tv.tv_sec) * G_USEC_PER_SEC + tv.tv_usec;
+#endif
+}
+
+
+void FrameTimes::frame_finished() {
+    if (!recording)
+        return;
+    gint64 end = now();
+    current.us[WholeFrame] = end - last_frame_end;
+    last_frame_end = end;
+
+    /* write the slot first, and only then publish it */
+    gint count = g_atomic_int_get(&frame_count);
+    frames[count % Capacity] = current;
+    g_atomic_int_inc(&frame_count);
+
+    std::fill(current.us, current.us + NumSections, 0);
+}
+
+
+std::vector<FrameTimes::Frame> FrameTimes::get_frames(unsigned max_frames) const {
+    unsigned count = g_atomic_int_get(&frame_count);
+    /* the oldest slot may be being overwritten by the next frame, so leave that out */
+    unsigned n = std::min(count, unsigned(Capacity) - 1);
+    n = std::min(n, max_frames);
+
+    std::vector<Frame> result;
+    result.reserve(n);
+    for (unsigned i = count - n; i != count; ++i)
+        result.push_back(frames[i % Capacity]);
+    return result;
+}
+
+
+void FrameTimes::get_statistics(unsigned max_frames, Statistics stats[]) const {
+    std::vector<Frame> last = get_frames(max_frames);
+    std::vector<guint32> values(last.size());
+    for (unsigned s = 0; s < NumSections; ++s) {
+        if (values.empty()) {
+            stats[s].p50 = stats[s].p95 = stats[s].p99 = stats[s].max = 0;
+            continue;
+        }
+        for (unsigned i = 0; i < last.size(); ++i)
+            values[i] = last[i].us[s];
+        std::sort(values.begin(), values.end());
+        unsigned top = values.size() - 1;
+        stats[s].p50 = values[top * 50 / 100] / 1000.0;
+        stats[s].p95 = values[top * 95 / 100] / 1000.0;
+        stats[s].p99 = values[top * 99 / 100] / 1000.0;
+        stats[s].max = values[top] / 1000.0;
+    }
+}
+
+
+bool FrameTimes::save_csv(const char *filename) const {
+    std::ofstream outfile;
+    outfile.open(filename);
+    if (!outfile.is_open())
+        return false;
+
+    for (unsigned s = 0; s < NumSections; ++s)
+        outfile << (s == 0 ? "" : ",") << section_names[s];
+    outfile << std::endl;
+
+    std::vector<Frame> all = get_frames(Capacity);
+    for (unsigned i = 0; i < all.size(); ++i) {
+        for (unsigned s = 0; s < NumSections; ++s)
+            outfile << (s == 0 ? "" : ",") << all[i].us[s];
+        outfile << std::endl;
+    }
+    outfile.close();
+    return !outfile.fail();
+}
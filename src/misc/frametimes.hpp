@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef FRAMETIMES_HPP_INCLUDED
+#define FRAMETIMES_HPP_INCLUDED
+
+#include "config.h"
+
+#include <glib.h>
+#include <vector>
+
+/// @brief Per-frame timings of the parts of the game loop, to find the causes of stutter.
+///
+/// The time spent in the sections of the game loop is summed with FrameTimeMeasure
+/// objects. When a frame is finished, the sums are stored in a ring buffer, which
+/// holds the last Capacity frames. The times are recorded by the main thread only,
+/// and only while the game is running; see start_recording().
+/// The ring buffer needs no locks: a frame is first written into its slot, and then
+/// published by incrementing the frame counter atomically.
+class FrameTimes {
+public:
+    /// The parts of the game loop measured. Sections may contain each other;
+    /// for example, Iterate is part of GameMainInt.
+    enum Section {
+        WholeFrame,     ///< Time from the end of the previous frame, including waiting.
+        GameMainInt,    ///< GameControl::main_int().
+        Iterate,        ///< CaveRendered::iterate().
+        DrawIndexes,    ///< CaveRendered::draw_indexes().
+        DrawCave,       ///< Drawing the cave and the particles.
+        DrawStatus,     ///< Drawing the status bar.
+        Particles,      ///< Moving the particles.
+        Flip,           ///< Screen::flip().
+        NumSections
+    };
+
+    /// Short names of the sections, for the overlay and the CSV header.
+    static const char *section_names[NumSections];
+
+    /// The number of frames remembered.
+    enum { Capacity = 4096 };
+
+    /// Times of a frame, in microseconds.
+    struct Frame {
+        guint32 us[NumSections];
+    };
+
+    /// Percentiles of a section over a number of frames, in milliseconds.
+    struct Statistics {
+        double p50, p95, p99, max;
+    };
+
+    FrameTimes();
+
+    /// The current time in microseconds, from an arbitrary starting point.
+    static gint64 now();
+
+    /// Start recording frames; called when the game loop starts. The frames drawn
+    /// before, for example by the menus, are not recorded.
+    void start_recording();
+    /// Stop recording frames; called when the game loop is left.
+    void stop_recording();
+
+    /// Add time spent in a section to the current frame.
+    void add(Section section, gint64 us) {
+        if (recording)
+            current.us[section] += us;
+    }
+
+    /// Store the current frame in the ring buffer, and start a new one.
+    /// Does nothing if not recording.
+    void frame_finished();
+
+    /// Get the last frames recorded, the oldest first.
+    /// @param max_frames Return at most this many frames.
+    std::vector<Frame> get_frames(unsigned max_frames) const;
+
+    /// Calculate the statistics of all sections, over the last frames.
+    /// @param max_frames Number of frames to consider.
+    /// @param stats Array of NumSections elements to store the results in.
+    void get_statistics(unsigned max_frames, Statistics stats[]) const;
+
+    /// Save the frames recorded to a CSV file, in microseconds.
+    /// @return True, if successful.
+    bool save_csv(const char *filename) const;
+
+private:
+    Frame frames[Capacity];
+    volatile gint frame_count;      ///< Number of frames stored so far; accessed atomically
+    Frame current;
+    gint64 last_frame_end;
+    bool recording;
+};
+
+/// The frame times of the game loop.
+extern FrameTimes gd_frame_times;
+
+/// @brief Measures the time from its construction to its destruction,
+/// and adds it to a section of the current frame in gd_frame_times.
+class FrameTimeMeasure {
+    FrameTimes::Section section;
+    gint64 start;
+public:
+    explicit FrameTimeMeasure(FrameTimes::Section section)
+        : section(section), start(FrameTimes::now()) {}
+    ~FrameTimeMeasure() {
+        gd_frame_times.add(section, FrameTimes::now() - start);
+    }
+};
+
+#endif
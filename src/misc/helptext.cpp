@@ -210,6 +210,7 @@ helpdata const gamehelp[] = {
     { NULL, NULL, "F2", O_NONE, N_("Random colors") },
     { NULL, NULL, "F3", O_NONE, N_("Take snapshot") },
     { NULL, NULL, "F4", O_NONE, N_("Revert to snapshot") },
+    { NULL, NULL, "F7", O_NONE, N_("Frame times (for testing)") },
     { NULL, NULL, "F8", O_NONE, N_("Cave variables (for testing)") },
     { NULL, NULL, "F9", O_NONE, N_("Sound volume") },
 #ifdef HAVE_GTK
@@ -30,8 +30,39 @@
 
 #include "settings.hpp"
 #include "misc/logger.hpp"
+#include "misc/parallel.hpp"
 
-std::vector<Logger *> Logger::loggers;
+/* the loggers of each thread; the most recently created is the active one. */
+static void delete_thread_loggers(gpointer loggers) {
+    delete static_cast<std::vector<Logger *> *>(loggers);
+}
+
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+static GPrivate thread_loggers_key = G_PRIVATE_INIT(delete_thread_loggers);
+#else
+static GStaticPrivate thread_loggers_key = G_STATIC_PRIVATE_INIT;
+#endif
+static StaticMutex handler_mutex = GD_STATIC_MUTEX_INIT;
+
+/* the number of loggers in all threads. the glib log handler is installed while there are any. */
+static unsigned num_loggers = 0;
+
+static std::vector<Logger *> &thread_loggers() {
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+    std::vector<Logger *> *loggers = static_cast<std::vector<Logger *> *>(g_private_get(&thread_loggers_key));
+    if (loggers == NULL) {
+        loggers = new std::vector<Logger *>;
+        g_private_set(&thread_loggers_key, loggers);
+    }
+#else
+    std::vector<Logger *> *loggers = static_cast<std::vector<Logger *> *>(g_static_private_get(&thread_loggers_key));
+    if (loggers == NULL) {
+        loggers = new std::vector<Logger *>;
+        g_static_private_set(&thread_loggers_key, loggers, delete_thread_loggers);
+    }
+#endif
+    return *loggers;
+}
 
 static char severity_char(ErrorMessage::Severity sev) {
     switch (sev) {
@@ -69,37 +100,48 @@ std::ostream &operator<<(std::ostream &os, const ErrorMessage &em) {
 /// GLib log func. This is used to record the log messages from gtk and
 /// glib as well.
 static void log_func(const gchar *log_domain, GLogLevelFlags log_level, const gchar *message, gpointer user_data) {
-    log(severity_glog(log_level), message);
+    /* threads without a logger only print to the console */
+    if (!thread_loggers().empty())
+        log(severity_glog(log_level), message);
     /* also call default handler to print to console; but with processed string */
     g_log_default_handler(log_domain, log_level, message, user_data);
 }
 
 
 /// Creates a new misc/logger.
-/// Adds it to the static list of loggers.
-Logger::Logger(bool ignore_)
+/// Adds it to the list of loggers of the calling thread.
+/// @param ignore_ If true, all messages are ignored.
+/// @param quiet_ If true, the messages are only stored, and not printed to the console.
+///     This is useful if the messages are logged again later.
+Logger::Logger(bool ignore_, bool quiet_)
     :
     ignore(ignore_),
+    quiet(quiet_),
     read(true),
     context() {
     /* if this is the first logger created */
-    if (loggers.empty())
-        g_log_set_default_handler(log_func, NULL);
+    {
+        StaticMutexLock lock(handler_mutex);
+        if (num_loggers++ == 0)
+            g_log_set_default_handler(log_func, NULL);
+    }
     /* add this logger to list of loggers, so we always know which was last */
-    loggers.push_back(this);
+    thread_loggers().push_back(this);
 }
 
 /// Destruct a misc/logger.
-/// Removes it from the static list of loggers.
+/// Removes it from the list of loggers of the thread.
 Logger::~Logger() {
     if (!read) {
         std::cerr << "Messages left in logger!" << std::endl;
         for (Container::const_iterator it = messages.begin(); it != messages.end(); ++it)
             std::cerr << "  " << *it << std::endl;
     }
+    std::vector<Logger *> &loggers = thread_loggers();
     assert(loggers.back() == this);
     loggers.pop_back();
-    if (loggers.empty())
+    StaticMutexLock lock(handler_mutex);
+    if (--num_loggers == 0)
         g_log_set_default_handler(g_log_default_handler, NULL);
 }
 
@@ -156,14 +198,16 @@ void Logger::log(ErrorMessage::Severity sev, std::string const &message) {
         messages.push_back(ErrorMessage(sev, message));
     else
         messages.push_back(ErrorMessage(sev, context + ": " + message));
-    std::cerr << messages.back() << std::endl;
+    if (!quiet)
+        std::cerr << messages.back() << std::endl;
     read = false;
 }
 
 void log(ErrorMessage::Severity sev, std::string const &message) {
     /* check if at least one logger exists */
-    if (!Logger::loggers.empty()) {
-        Logger::loggers.back()->log(sev, message);
+    std::vector<Logger *> &loggers = thread_loggers();
+    if (!loggers.empty()) {
+        loggers.back()->log(sev, message);
     } else {
         g_warning("%s", message.c_str());
     }
@@ -171,8 +215,8 @@ void log(ErrorMessage::Severity sev, std::string const &message) {
 
 Logger &get_active_logger() {
     /* check if at least one logger exists */
-    assert(!Logger::loggers.empty());
-    return *Logger::loggers.back();
+    assert(!thread_loggers().empty());
+    return *thread_loggers().back();
 }
 
 /**
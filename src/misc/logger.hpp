@@ -65,14 +65,17 @@ public:
  * log handler is also installed by the misc/logger.
  *
  * The Logger class keeps track of all Logger objects in
- * existence, using the loggers static variable.
+ * existence, separately for each thread.
  * Global error logging functions are provided for simple
  * usage - they allow callers to use the logging facility
  * without the need of passing the references to a logger
  * object.
  *
  * The global log functions always log errors to the most recently
- * created Logger object. The scheme to use this thing is:
+ * created Logger object of the calling thread. So a worker thread
+ * must create its own Logger, if it is to log messages; it can pass
+ * them to the other thread after its work is done.
+ * The scheme to use this thing is:
  * @code
  * {             // a code block for the logger object
  *   Logger l;   // create a logger
@@ -106,14 +109,13 @@ public:
  * @endcode
  */
 class Logger {
-private:
-    static std::vector<Logger *> loggers;
 public:
     typedef std::vector<ErrorMessage> Container;
     typedef Container::const_iterator ConstIterator;
 
 private:
     bool ignore;            ///< if true, all errors reported are ignored
+    bool quiet;             ///< if true, messages are not printed to the console
     bool read;              ///< if false, not all messages are seen by the user.
     Container messages;     ///< list of messages
     std::string context;    ///< context which is added to all messages
@@ -125,7 +127,7 @@ private:
     std::string const &get_context() const;
 
 public:
-    Logger(bool ignore_ = false);
+    Logger(bool ignore_ = false, bool quiet_ = false);
     ~Logger();
     void clear();
     bool empty() const;
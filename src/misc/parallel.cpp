@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "misc/parallel.hpp"
+
+
+ParallelJobs::ParallelJobs(unsigned count, JobFunc func, gpointer data, unsigned num_threads)
+    :   count(count),
+        func(func),
+        data(data),
+        state(count, gint(Waiting)),
+        next(0),
+        quit(0) {
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+    mutex = new GMutex;
+    g_mutex_init(mutex);
+    cond = new GCond;
+    g_cond_init(cond);
+#else
+    mutex = g_mutex_new();
+    cond = g_cond_new();
+#endif
+
+    if (num_threads == 0)
+        num_threads = get_num_processors();
+    if (num_threads > count)
+        num_threads = count;
+    for (unsigned i = 0; i < num_threads; ++i) {
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+        GThread *thread = g_thread_new("worker", worker, this);
+#else
+        GThread *thread = g_thread_create(worker, this, TRUE, NULL);
+#endif
+        g_assert(thread != NULL);
+        threads.push_back(thread);
+    }
+}
+
+
+ParallelJobs::~ParallelJobs() {
+    /* workers stop after their current job */
+    g_atomic_int_set(&quit, 1);
+    for (unsigned i = 0; i < threads.size(); ++i)
+        g_thread_join(threads[i]);
+
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+    g_mutex_clear(mutex);
+    delete mutex;
+    g_cond_clear(cond);
+    delete cond;
+#else
+    g_mutex_free(mutex);
+    g_cond_free(cond);
+#endif
+}
+
+
+unsigned ParallelJobs::get_num_processors() {
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=36)
+    return MAX(g_get_num_processors(), 1u);
+#else
+    return 2;
+#endif
+}
+
+
+/// Try to take a job. Returns true, if the caller is the one who must do it.
+bool ParallelJobs::claim(unsigned job) {
+    return g_atomic_int_compare_and_exchange(&state[job], Waiting, Running);
+}
+
+
+void ParallelJobs::run(unsigned job) {
+    func(job, data);
+    g_mutex_lock(mutex);
+    g_atomic_int_set(&state[job], Done);
+    g_cond_broadcast(cond);
+    g_mutex_unlock(mutex);
+}
+
+
+gpointer ParallelJobs::worker(gpointer data) {
+    ParallelJobs *jobs = static_cast<ParallelJobs *>(data);
+
+    for (unsigned job = g_atomic_int_get(&jobs->next); job < jobs->count && !g_atomic_int_get(&jobs->quit); ++job) {
+        if (jobs->claim(job)) {
+            /* only a hint for the others, so no problem if it is overwritten by a smaller number */
+            g_atomic_int_set(&jobs->next, job + 1);
+            jobs->run(job);
+        }
+    }
+    return NULL;
+}
+
+
+bool ParallelJobs::is_done(unsigned job) const {
+    g_assert(job < count);
+    return g_atomic_int_get(&state[job]) == Done;
+}
+
+
+void ParallelJobs::finish(unsigned job) {
+    g_assert(job < count);
+    if (claim(job)) {
+        run(job);
+        return;
+    }
+    /* somebody else is doing it, so wait */
+    g_mutex_lock(mutex);
+    while (g_atomic_int_get(&state[job]) != Done)
+        g_cond_wait(cond, mutex);
+    g_mutex_unlock(mutex);
+}
+
+
+void ParallelJobs::finish_all() {
+    for (unsigned job = 0; job < count; ++job)
+        finish(job);
+}
+
+
+void gd_parallel_for(unsigned count, ParallelJobs::JobFunc func, gpointer data) {
+    if (count == 1 || ParallelJobs::get_num_processors() == 1) {
+        for (unsigned i = 0; i < count; ++i)
+            func(i, data);
+        return;
+    }
+    /* the calling thread will also work, so one less worker is enough */
+    ParallelJobs jobs(count, func, data, ParallelJobs::get_num_processors() - 1);
+    jobs.finish_all();
+}
+
+
+BackgroundWorker::BackgroundWorker()
+    :   func(NULL),
+        data(NULL),
+        state(Idle),
+        quit(false) {
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+    mutex = new GMutex;
+    g_mutex_init(mutex);
+    cond = new GCond;
+    g_cond_init(cond);
+    thread = g_thread_new("background", worker, this);
+#else
+    mutex = g_mutex_new();
+    cond = g_cond_new();
+    thread = g_thread_create(worker, this, TRUE, NULL);
+#endif
+    g_assert(thread != NULL);
+}
+
+
+BackgroundWorker::~BackgroundWorker() {
+    g_mutex_lock(mutex);
+    g_assert(state == Idle);
+    quit = true;
+    g_cond_broadcast(cond);
+    g_mutex_unlock(mutex);
+    g_thread_join(thread);
+
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+    g_mutex_clear(mutex);
+    delete mutex;
+    g_cond_clear(cond);
+    delete cond;
+#else
+    g_mutex_free(mutex);
+    g_cond_free(cond);
+#endif
+}
+
+
+void BackgroundWorker::start(JobFunc func, gpointer data) {
+    g_mutex_lock(mutex);
+    g_assert(state == Idle);
+    this->func = func;
+    this->data = data;
+    state = Waiting;
+    g_cond_broadcast(cond);
+    g_mutex_unlock(mutex);
+}
+
+
+void BackgroundWorker::finish() {
+    g_mutex_lock(mutex);
+    g_assert(state != Idle);
+    if (state == Waiting) {
+        /* not started yet; do it here, instead of waiting for the worker to wake up */
+        state = Running;
+        g_mutex_unlock(mutex);
+        func(data);
+        g_mutex_lock(mutex);
+        state = Done;
+    }
+    while (state != Done)
+        g_cond_wait(cond, mutex);
+    state = Idle;
+    g_mutex_unlock(mutex);
+}
+
+
+void BackgroundWorker::cancel() {
+    g_mutex_lock(mutex);
+    if (state == Waiting)
+        state = Done;
+    while (state == Running)
+        g_cond_wait(cond, mutex);
+    state = Idle;
+    g_mutex_unlock(mutex);
+}
+
+
+gpointer BackgroundWorker::worker(gpointer data) {
+    BackgroundWorker *bw = static_cast<BackgroundWorker *>(data);
+
+    g_mutex_lock(bw->mutex);
+    while (!bw->quit) {
+        if (bw->state != Waiting) {
+            g_cond_wait(bw->cond, bw->mutex);
+            continue;
+        }
+        bw->state = Running;
+        g_mutex_unlock(bw->mutex);
+        bw->func(bw->data);
+        g_mutex_lock(bw->mutex);
+        bw->state = Done;
+        g_cond_broadcast(bw->cond);
+    }
+    g_mutex_unlock(bw->mutex);
+    return NULL;
+}
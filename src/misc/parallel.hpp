@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef PARALLEL_HPP_INCLUDED
+#define PARALLEL_HPP_INCLUDED
+
+#include "config.h"
+
+#include <glib.h>
+#include <vector>
+
+/// @brief Runs a number of independent jobs on worker threads.
+///
+/// The jobs are numbered from 0 to count-1, and for each, the job function
+/// is called with the job number and the user data. The jobs are started
+/// in the constructor, and processed in the background, roughly in the
+/// order of their numbers. The owner can ask for the result of any job
+/// with finish(); if that job is not yet started, it is run immediately on
+/// the calling thread, so the caller never waits for the other jobs.
+///
+/// The destructor stops the workers; jobs not yet started are not run.
+/// The job function must not touch anything but the data of its own job.
+class ParallelJobs {
+public:
+    typedef void (*JobFunc)(unsigned job, gpointer data);
+
+    /// @param count Number of jobs.
+    /// @param func The function to call for each job.
+    /// @param data User data passed to the job function.
+    /// @param num_threads Number of worker threads; 0 selects the number of processors.
+    ParallelJobs(unsigned count, JobFunc func, gpointer data, unsigned num_threads = 0);
+    ~ParallelJobs();
+
+    /// Make sure that the given job is done. If it is not started yet, it is run on
+    /// the calling thread; if it is just running on a worker, this waits for it.
+    void finish(unsigned job);
+
+    /// Make sure that all jobs are done; the calling thread also helps.
+    void finish_all();
+
+    /// Check if the job is done, without waiting.
+    bool is_done(unsigned job) const;
+
+    /// The number of processors in the computer, at least 1.
+    static unsigned get_num_processors();
+
+private:
+    enum { Waiting, Running, Done };
+
+    unsigned count;
+    JobFunc func;
+    gpointer data;
+    std::vector<gint> state;        ///< Waiting, Running or Done; accessed atomically
+    volatile gint next;             ///< A hint for the workers where to look for the next job
+    volatile gint quit;
+    GMutex *mutex;
+    GCond *cond;
+    std::vector<GThread *> threads;
+
+    bool claim(unsigned job);
+    void run(unsigned job);
+    static gpointer worker(gpointer data);
+
+    ParallelJobs(const ParallelJobs &);                // not implemented
+    ParallelJobs &operator=(const ParallelJobs &);     // not implemented
+};
+
+/// @brief A single worker thread, which runs one job at a time in the background.
+///
+/// Unlike ParallelJobs, the thread is kept between the jobs, so it can be
+/// given small jobs often, without starting a thread for each of them.
+/// A job is started with start(), and its result must be taken with
+/// finish(), or it must be cancelled, before the next one is started.
+class BackgroundWorker {
+public:
+    typedef void (*JobFunc)(gpointer data);
+
+    BackgroundWorker();
+    /// Stops the thread; the current job must be finished or cancelled before.
+    ~BackgroundWorker();
+
+    /// Give a job to the worker. The previous one must be finished or cancelled.
+    void start(JobFunc func, gpointer data);
+    /// Make sure that the job is done. If the worker has not started it yet,
+    /// it is run on the calling thread.
+    void finish();
+    /// Drop the job if it is not started yet; if it is just running, wait for it.
+    void cancel();
+
+private:
+    enum { Idle, Waiting, Running, Done };
+
+    JobFunc func;
+    gpointer data;
+    int state;                      ///< Idle, Waiting, Running or Done; guarded by the mutex
+    bool quit;
+    GMutex *mutex;
+    GCond *cond;
+    GThread *thread;
+
+    static gpointer worker(gpointer data);
+
+    BackgroundWorker(const BackgroundWorker &);                // not implemented
+    BackgroundWorker &operator=(const BackgroundWorker &);     // not implemented
+};
+
+/// @brief A mutex for global and static variables, with the same code for all glib versions.
+///
+/// It needs no initialization function and no cleanup, so it can be used
+/// before main() is started. Define it as:
+/// static StaticMutex mutex = GD_STATIC_MUTEX_INIT;
+/// and lock it with a StaticMutexLock.
+struct StaticMutex {
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+    GMutex mutex;
+
+    void lock() {
+        g_mutex_lock(&mutex);
+    }
+    void unlock() {
+        g_mutex_unlock(&mutex);
+    }
+#else
+    GStaticMutex mutex;
+
+    void lock() {
+        g_static_mutex_lock(&mutex);
+    }
+    void unlock() {
+        g_static_mutex_unlock(&mutex);
+    }
+#endif
+};
+
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+/* a static GMutex needs no initialization, only to be zeroed */
+#define GD_STATIC_MUTEX_INIT { }
+#else
+#define GD_STATIC_MUTEX_INIT { G_STATIC_MUTEX_INIT }
+#endif
+
+/// @brief Keeps a StaticMutex locked, while the object exists.
+class StaticMutexLock {
+public:
+    explicit StaticMutexLock(StaticMutex &mutex) : mutex(mutex) {
+        mutex.lock();
+    }
+    ~StaticMutexLock() {
+        mutex.unlock();
+    }
+
+private:
+    StaticMutex &mutex;
+
+    StaticMutexLock(const StaticMutexLock &);                // not implemented
+    StaticMutexLock &operator=(const StaticMutexLock &);     // not implemented
+};
+
+/// @brief Call func for 0..count-1 on worker threads, and wait for them all to finish.
+/// The calling thread also takes part in the work.
+void gd_parallel_for(unsigned count, ParallelJobs::JobFunc func, gpointer data);
+
+#endif
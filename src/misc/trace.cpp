@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <glib.h>
+#include <cstdio>
+
+#include "misc/trace.hpp"
+#include "misc/frametimes.hpp"
+#include "misc/parallel.hpp"
+
+
+bool gd_trace_enabled = false;
+
+static FILE *trace_file = NULL;
+static gint64 trace_start = 0;
+static bool trace_first_event = true;
+/* small numbers for the threads, as the viewer shows them. each thread
+ * stores its own id, as GThread pointers are reused by glib after a thread
+ * exits. the ids are valid only in the trace they were given out for. */
+struct TraceThreadId {
+    unsigned trace;
+    int id;
+};
+static unsigned trace_number = 0;
+static int trace_next_thread_id = 0;
+
+static void delete_trace_thread_id(gpointer id) {
+    delete static_cast<TraceThreadId *>(id);
+}
+
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+static GPrivate trace_thread_id_key = G_PRIVATE_INIT(delete_trace_thread_id);
+#else
+static GStaticPrivate trace_thread_id_key = G_STATIC_PRIVATE_INIT;
+#endif
+
+static StaticMutex trace_mutex = GD_STATIC_MUTEX_INIT;
+
+
+gint64 gd_trace_now() {
+    return FrameTimes::now();
+}
+
+
+/* start a new event in the json array. */
+static void trace_event_separator() {
+    fputs(trace_first_event ? "[\n" : ",\n", trace_file);
+    trace_first_event = false;
+}
+
+
+/* get the id of the calling thread. when a thread is seen first,
+ * it is named in the trace. must be called with the mutex locked. */
+static int trace_thread_id() {
+#if GLIB_MAJOR_VERSION>2 || (GLIB_MAJOR_VERSION==2 && GLIB_MINOR_VERSION>=32)
+    TraceThreadId *self = static_cast<TraceThreadId *>(g_private_get(&trace_thread_id_key));
+    if (self == NULL) {
+        self = new TraceThreadId;
+        self->trace = trace_number - 1;
+        g_private_set(&trace_thread_id_key, self);
+    }
+#else
+    TraceThreadId *self = static_cast<TraceThreadId *>(g_static_private_get(&trace_thread_id_key));
+    if (self == NULL) {
+        self = new TraceThreadId;
+        self->trace = trace_number - 1;
+        g_static_private_set(&trace_thread_id_key, self, delete_trace_thread_id);
+    }
+#endif
+    if (self->trace == trace_number)
+        return self->id;
+
+    int id = trace_next_thread_id++;
+    self->trace = trace_number;
+    self->id = id;
+    trace_event_separator();
+    if (id == 0)
+        fprintf(trace_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"main\"}}", id);
+    else
+        fprintf(trace_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}", id, id);
+    return id;
+}
+
+
+bool gd_trace_open(const char *filename) {
+    g_assert(trace_file == NULL);
+    trace_file = fopen(filename, "w");
+    if (trace_file == NULL)
+        return false;
+
+    trace_start = gd_trace_now();
+    trace_first_event = true;
+    trace_number++;
+    trace_next_thread_id = 0;
+    {
+        StaticMutexLock lock(trace_mutex);
+        trace_thread_id();      /* so the calling thread is the main one */
+    }
+    gd_trace_enabled = true;
+    return true;
+}
+
+
+void gd_trace_close() {
+    if (trace_file == NULL)
+        return;
+
+    gd_trace_enabled = false;
+    StaticMutexLock lock(trace_mutex);
+    fputs("\n]\n", trace_file);
+    fclose(trace_file);
+    trace_file = NULL;
+}
+
+
+void gd_trace_add_span(const char *name, const char *category, gint64 start_us, gint64 end_us) {
+    StaticMutexLock lock(trace_mutex);
+    if (trace_file != NULL) {
+        int tid = trace_thread_id();
+        trace_event_separator();
+        fprintf(trace_file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT "}",
+                name, category, tid, start_us - trace_start, end_us - start_us);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2007-2013, Czirkos Zoltan http://code.google.com/p/gdash/
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef TRACE_HPP_INCLUDED
+#define TRACE_HPP_INCLUDED
+
+#include "config.h"
+
+#include <glib.h>
+
+/// @defgroup Trace Timeline tracing
+/// Scoped spans, written to a file in the Chrome trace event format, which can be
+/// viewed with about:tracing in Chrome or with Perfetto. Spans can be created on any
+/// thread. If no trace file is open, a span costs only the test of a global flag.
+/// @{
+
+/// True, if a trace file is open. Only changed at startup and exit.
+extern bool gd_trace_enabled;
+
+/// Open the trace file, and start recording spans.
+/// @return True, if the file could be opened.
+bool gd_trace_open(const char *filename);
+
+/// Finish the trace file.
+void gd_trace_close();
+
+/// Write a span to the trace file.
+/// @param name Name of the span; must be a string literal, as it is not escaped.
+/// @param category Category of the span, for filtering in the viewer.
+/// @param start_us The start of the span, as returned by gd_trace_now().
+/// @param end_us The end of the span.
+void gd_trace_add_span(const char *name, const char *category, gint64 start_us, gint64 end_us);
+
+/// The current time in microseconds, for the trace.
+gint64 gd_trace_now();
+
+/// @brief Records a span in the trace, from its construction to its destruction.
+class TraceSpan {
+    const char *name;
+    const char *category;
+    gint64 start;
+public:
+    TraceSpan(const char *name, const char *category)
+        : name(name), category(category), start(gd_trace_enabled ? gd_trace_now() : 0) {}
+    ~TraceSpan() {
+        if (G_UNLIKELY(gd_trace_enabled))
+            gd_trace_add_span(name, category, start, gd_trace_now());
+    }
+};
+
+/// @}
+
+#endif
@@ -22,12 +22,15 @@
  */
 
 #include <cmath>
+#include <cstdlib>
 #include <memory>
+#include <algorithm>
 
 #include "sdl/sdlabstractscreen.hpp"
 
 #include "cave/colors.hpp"
 #include "gfx/pixbuffactory.hpp"
+#include "gfx/particlerasterizer.hpp"
 #include "sdl/sdlpixbuf.hpp"
 #include "sdl/sdlscreen.hpp"
 #include "cave/particle.hpp"
@@ -217,53 +220,71 @@ static void hlineColor(SDL_Surface *dst, Sint16 x1, Sint16 x2, Sint16 y, Uint32
 }
 
 
-/** Draw a diamond with the specified color, 0xRRGGBBAA.
- * The surface must be already locked if needed. */
-static void filledDiamondColor(SDL_Surface *dst, Sint16 xc, Sint16 yc, Sint16 r, Uint32 color, bool software_pal_emulation) {
-    if ((dst->clip_rect.w == 0) || (dst->clip_rect.h == 0))
-        return;
-    if (r < 0)
-        return;
+namespace {
+/**
+ * \brief Draws the particles of particle sets on a surface, which must be already
+ * locked if needed.
+ * For 32-bpp surfaces, which are the usual ones, the spans are blended by the
+ * ParticleRasterizer. For other surfaces, they are drawn with hlineColor().
+ */
+class SDLParticleRasterizer: public ParticleRasterizer {
+public:
+    SDLParticleRasterizer(SDL_Surface *dst, bool pal_emu);
 
-    Sint16 x2 = xc + r;
-    Sint16 left = dst->clip_rect.x;
-    if (x2 < left)
-        return;
-    Sint16 x1 = xc - r;
-    Sint16 right = dst->clip_rect.x + dst->clip_rect.w - 1;
-    if (x1 > right)
-        return;
-    Sint16 y2 = yc + r;
-    Sint16 top = dst->clip_rect.y;
-    if (y2 < top)
-        return;
-    Sint16 y1 = yc - r;
-    Sint16 bottom = dst->clip_rect.y + dst->clip_rect.h - 1;
-    if (y1 > bottom)
-        return;
+protected:
+    virtual void span(int x1, int x2, int y);
 
-    /* Draw */
-    hlineColor(dst, xc - r, xc + r, yc, color, software_pal_emulation);
-    for (Sint16 f = 0; f < r; ++f) {
-        hlineColor(dst, xc - f, xc + f, yc - (r - f), color, software_pal_emulation);
-        hlineColor(dst, xc - f, xc + f, yc + (r - f), color, software_pal_emulation);
-    }
+private:
+    SDL_Surface *dst;
+    bool fast32;
+};
+}
+
+
+SDLParticleRasterizer::SDLParticleRasterizer(SDL_Surface *dst, bool pal_emu)
+    : ParticleRasterizer((guint32 *) dst->pixels, dst->pitch,
+                         dst->format->Rshift, dst->format->Gshift, dst->format->Bshift,
+                         dst->clip_rect.x, dst->clip_rect.y,
+                         dst->clip_rect.x + dst->clip_rect.w - 1, dst->clip_rect.y + dst->clip_rect.h - 1,
+                         pal_emu)
+    , dst(dst) {
+    SDL_PixelFormat *format = dst->format;
+    fast32 = format->BytesPerPixel == 4
+             && format->Rloss == 0 && format->Gloss == 0 && format->Bloss == 0
+             && format->Rshift % 8 == 0 && format->Gshift % 8 == 0 && format->Bshift % 8 == 0;
+}
+
+
+void SDLParticleRasterizer::span(int x1, int x2, int y) {
+    if (fast32)
+        ParticleRasterizer::span(x1, x2, y);
+    else
+        /* hlineColor does the pal emulation shading by itself */
+        hlineColor(dst, x1, x2, y, colors[0].color, pal_emu);
 }
 
 
 void SDLAbstractScreen::draw_particle_set(int dx, int dy, ParticleSet const &ps) {
-    unsigned char r, g, b;
-    ps.color.get_rgb(r, g, b);
-    Uint8 a = ps.life / 1000.0 * ps.opacity * 255;
-    Uint32 color = r << 24 | g << 16 | b << 8 | a << 0;
-    int size = ceil(ps.size);
     if (SDL_MUSTLOCK(surface))
         if (SDL_LockSurface(surface) < 0)
             return;
-    bool software_pal_emulation = get_pal_emulation();
-    for (ParticleSet::const_iterator it = ps.begin(); it != ps.end(); ++it) {
-        filledDiamondColor(surface, dx + it->px, dy + it->py, size, color, software_pal_emulation);
-    }
+    SDLParticleRasterizer rasterizer(surface, get_pal_emulation());
+    rasterizer.draw(dx, dy, ps);
+    if (SDL_MUSTLOCK(surface))
+        SDL_UnlockSurface(surface);
+}
+
+
+void SDLAbstractScreen::draw_particles(int dx, int dy, ParticleSystem const &particles) {
+    if (particles.num_sets() == 0)
+        return;
+    /* lock only once for all sets */
+    if (SDL_MUSTLOCK(surface))
+        if (SDL_LockSurface(surface) < 0)
+            return;
+    SDLParticleRasterizer rasterizer(surface, get_pal_emulation());
+    for (unsigned i = 0; i < particles.num_sets(); ++i)
+        rasterizer.draw(dx, dy, particles.get_set(i));
     if (SDL_MUSTLOCK(surface))
         SDL_UnlockSurface(surface);
 }
@@ -31,6 +31,7 @@
 #include "gfx/screen.hpp"
 
 class ParticleSet;
+class ParticleSystem;
 class GdColor;
 class PixbufFactory;
 
@@ -66,6 +67,7 @@ public:
     virtual void set_clip_rect(int x1, int y1, int w, int h);
     virtual void remove_clip_rect();
     virtual void draw_particle_set(int dx, int dy, ParticleSet const &ps);
+    virtual void draw_particles(int dx, int dy, ParticleSystem const &particles);
 };
 
 #endif
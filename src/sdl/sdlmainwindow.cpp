@@ -23,7 +23,7 @@
 
 #include "config.h"
 
-#include <numeric>
+#include <algorithm>
 
 #include "settings.hpp"
 #include "framework/app.hpp"
@@ -36,6 +36,7 @@
 #include "sdl/sdlgameinputhandler.hpp"
 #include "sdl/sdlscreen.hpp"
 #include "misc/logger.hpp"
+#include "misc/frametimes.hpp"
 
 #include "sdl/sdlmainwindow.hpp"
 
@@ -57,14 +58,127 @@ SDLApp::SDLApp(Screen &screenref)
 }
 
 
-/* generate a user event */
-static Uint32 timer_callback(Uint32 interval, void *param) {
-    SDL_Event ev;
+/*
+ * Decides how much time to pass to the app in each iteration of the main loop.
+ *
+ * If the flips of the screen wait for the vertical retrace, the app is given
+ * the time elapsed on every refresh of the display. The game still moves in
+ * 40 ms ticks, as GameRenderer accumulates the milliseconds, but scrolling is
+ * updated on every refresh, be it 50, 60 or 144 Hz. The refresh period is the
+ * median of the last intervals measured, which ignores dropped frames. To avoid
+ * drifting from the real time, the time passed follows the clock slowly, and
+ * the fractions of milliseconds are carried over.
+ *
+ * The scroll position is not interpolated between the game ticks: GameRenderer
+ * moves it with a speed calculated from the time given, so it already changes
+ * on every refresh. Only its target, the cell of the player, changes in ticks;
+ * interpolating that would also change when the game waits for the scrolling.
+ *
+ * Otherwise the app is given a fixed amount of time, and the loop sleeps until
+ * the next deadline, waking up early only for events.
+ */
+class FramePacer {
+public:
+    explicit FramePacer(int timer_ms);
+
+    /* call once on every refresh, when using screen timing. */
+    int refresh_elapsed_ms();
+    /* the median refresh period measured, in milliseconds. */
+    double get_refresh_period_ms() const;
+
+    /* check if it is time for a fixed timer tick. */
+    bool timer_tick();
+    int get_timer_ms() const {
+        return timer_us / 1000;
+    }
+    /* sleep until the next timer tick, or until an event arrives. */
+    void sleep_until_next_tick() const;
+
+private:
+    enum {
+        average_time_frame = 25,
+        /* intervals longer than this are not refreshes, but some stall */
+        max_refresh_us = 60000,
+        /* do not catch up more than this after a stall */
+        max_drift_us = 100000,
+    };
+
+    gint64 const timer_us;
+    gint64 next_tick;
+
+    gint64 last_refresh;
+    gint64 intervals[average_time_frame];
+    unsigned interval_index;
+    gint64 period_us;
+    gint64 drift_us;        /* real time elapsed minus time given to the app */
+    gint64 pending_us;      /* fraction of millisecond not yet given to the app */
+};
+
+
+FramePacer::FramePacer(int timer_ms)
+    : timer_us(timer_ms * 1000),
+      next_tick(FrameTimes::now() + timer_us),
+      last_refresh(FrameTimes::now()),
+      interval_index(0),
+      period_us(20000),
+      drift_us(0),
+      pending_us(0) {
+    /* by default, assume 20 ms / frame for frame rate measuring */
+    std::fill(intervals, intervals + average_time_frame, period_us);
+}
+
+
+int FramePacer::refresh_elapsed_ms() {
+    gint64 now = FrameTimes::now();
+    gint64 elapsed = now - last_refresh;
+    last_refresh = now;
+
+    if (elapsed <= max_refresh_us) {
+        intervals[interval_index] = elapsed;
+        interval_index = (interval_index + 1) % average_time_frame;
+        gint64 sorted[average_time_frame];
+        std::copy(intervals, intervals + average_time_frame, sorted);
+        std::nth_element(sorted, sorted + average_time_frame / 2, sorted + average_time_frame);
+        period_us = sorted[average_time_frame / 2];
+    }
+
+    /* give the app the refresh period, corrected slowly towards the real time */
+    drift_us = std::min(drift_us + elapsed, gint64(max_drift_us));
+    gint64 step = std::max(period_us + drift_us / 8, gint64(0));
+    drift_us -= step;
+
+    pending_us += step;
+    int ms = pending_us / 1000;
+    pending_us -= ms * 1000;
+    return ms;
+}
 
-    ev.type = SDL_USEREVENT;
-    SDL_PushEvent(&ev);
 
-    return interval;
+double FramePacer::get_refresh_period_ms() const {
+    return period_us / 1000.0;
+}
+
+
+bool FramePacer::timer_tick() {
+    gint64 now = FrameTimes::now();
+    if (now < next_tick)
+        return false;
+    next_tick += timer_us;
+    /* if lagging behind much, do not try to catch up */
+    if (now >= next_tick)
+        next_tick = now + timer_us;
+    return true;
+}
+
+
+void FramePacer::sleep_until_next_tick() const {
+    for (;;) {
+        gint64 remaining = next_tick - FrameTimes::now();
+        if (remaining <= 0 || SDL_PollEvent(NULL))
+            return;
+        /* sleep in short slices, so events are not delayed much */
+        g_usleep(std::min(remaining, gint64(10000)));
+    }
 }
 
 
@@ -132,40 +246,19 @@ private:
 
 
 static void run_the_app(App &the_app, NextAction &na) {
-    /* for the sdltimer based timing */
-    int const timer_ms = gd_fine_scroll ? 20 : 40;
-    SDL_TimerID timer_id;
-    bool timer_installed = false;
-    /* for the screen based timing */
-    Uint32 ticks_now = SDL_GetTicks(), ticks_last = SDL_GetTicks();
-    enum { average_time_frame = 25 };
-    Uint32 moved[average_time_frame];
-    unsigned move_index = 0;
-
-    if (!SDL_WasInit(SDL_INIT_TIMER))
-        SDL_InitSubSystem(SDL_INIT_TIMER);
+    FramePacer pacer(gd_fine_scroll ? 20 : 40);
 
     /* if screen reports we can use it for timing, measure the number of
      * milliseconds each refresh takes */
     bool use_screen_timing = the_app.screen->has_timed_flips();
     if (use_screen_timing)
         gd_debug("starting screen based timing");
-    /* by default, assume 20 ms / frame for frame rate measuring */
-    std::fill(moved, moved + average_time_frame, 20);
-
-    if (!use_screen_timing) {
-        timer_id = SDL_AddTimer(timer_ms, timer_callback, NULL);
-        timer_installed = true;
-    }
-
 
     the_app.set_no_activity_command(new SetNextActionCommandSDL(&the_app, na, Quit));
 
-    /* sdl_waitevent will wait until at least one event appears. */
     na = StartTitle;
     while (na == StartTitle) {
         /* and now we poll all the events, as there might be more than one. */
-        bool had_timer_event1 = false;
         SDL_Event ev;
 
         while (SDL_PollEvent(&ev)) {
@@ -192,51 +285,25 @@ static void run_the_app(App &the_app, NextAction &na) {
                 case SDL_VIDEOEXPOSE:
                     the_app.redraw_event(true);
                     break;
-                case SDL_USEREVENT:
-                    had_timer_event1 = true;
-                    break;
-                case SDL_USEREVENT+1:
-                    the_app.timer2_event();
-                    break;
             } // switch ev.type
         } // while pollevent
 
         if (use_screen_timing) {
-            int average_ms = std::accumulate(moved, moved + average_time_frame, 0) / average_time_frame;
-            if (average_ms < 7) {
-                use_screen_timing = false;
-                gd_debug("screen timing too fast, switching to built-in timer");
-                timer_id = SDL_AddTimer(timer_ms, timer_callback, NULL);
-                timer_installed = true;
-            }
-            /* feed the timer with the average value. */
-            the_app.timer_event(average_ms);
+            /* give the app the time of one refresh, and draw. */
+            the_app.timer_event(pacer.refresh_elapsed_ms());
             if (the_app.redraw_queued()) {
                 the_app.redraw_event(the_app.screen->must_redraw_all_before_flip());
             }
-            /*
-            // writing the ms delays to the screen
-            std::string s;
-            for (int i = 0; i < average_time_frame; ++i) {
-                s += SPrintf("%d ") % moved[i];
-            }
-            the_app.set_color(GD_GDASH_WHITE);
-            the_app.blittext_n(0, the_app.screen->get_height()-20, s.c_str());
-            */
-
-            /* calculate average milliseconds / refresh. if seems to be too fast, switch to timer based stuff */
-            ticks_now = SDL_GetTicks();
-            Uint32 ms = ticks_now - ticks_last;
-            if (ms <= 60) {
-                moved[move_index] = ms;
-                move_index = (move_index + 1) % average_time_frame;
-            }
             /* always flip, because we need the time it waits! */
             the_app.screen->do_the_flip();
-            ticks_last = ticks_now;
+            /* if the flips do not wait for the display, switch to the built-in timer */
+            if (pacer.get_refresh_period_ms() < 4) {
+                use_screen_timing = false;
+                gd_debug("screen timing too fast, switching to built-in timer");
+            }
         } else {
-            if (had_timer_event1)
-                the_app.timer_event(timer_ms);
+            if (pacer.timer_tick())
+                the_app.timer_event(pacer.get_timer_ms());
             if (the_app.redraw_queued()) {
                 the_app.redraw_event(the_app.screen->must_redraw_all_before_flip());
             }
@@ -244,9 +311,8 @@ static void run_the_app(App &the_app, NextAction &na) {
                 /* only flip if drawn something. */
                 the_app.screen->do_the_flip();
             }
-            /* we must wait the next event here so we do not eat cpu.
-             * but events are generated regurarly by the timer. */
-            SDL_WaitEvent(NULL);
+            /* sleep until the next tick, so we do not eat cpu. */
+            pacer.sleep_until_next_tick();
         }
 
 #ifdef HAVE_GTK
@@ -256,9 +322,6 @@ static void run_the_app(App &the_app, NextAction &na) {
             g_main_context_iteration(NULL, FALSE);
 #endif
     }
-
-    if (timer_installed)
-        SDL_RemoveTimer(timer_id);
 }
 
 
@@ -43,7 +43,6 @@ private:
     SDLPixbuf(int w, int h);
 
     friend class SDLPixbufFactory;
-    friend class SDLInmemoryScreen;
 
 public:
     ~SDLPixbuf();
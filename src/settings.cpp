@@ -101,6 +101,7 @@ bool gd_no_invisible_outbox = false;
 bool gd_all_caves_selectable = false;
 bool gd_import_as_all_caves_selectable = false;
 bool gd_use_bdcff_highscore = false;
+bool gd_caveset_cache = true;
 int gd_pal_emu_scanline_shade = 80;
 bool gd_fine_scroll = true;
 bool gd_particle_effects = true;
@@ -134,6 +135,9 @@ bool gd_pal_emulation_game = false;
 int gd_cell_scale_factor_editor = 1;
 int gd_cell_scale_type_editor = GD_SCALING_NEAREST;
 bool gd_pal_emulation_editor = false;
+bool gd_cell_sheet_cache_on_disk = false;
+bool gd_prescale_cells = true;
+bool gd_stream_title_animation = true;
 
 /* html output option */
 /* CURRENTLY ONLY FROM THE COMMAND LINE */
@@ -225,6 +229,7 @@ Setting *gd_get_game_settings_array() {
         { TypeBoolean, N_("All caves selectable"), &gd_all_caves_selectable, false, NULL, N_("All caves and intermissions can be selected at game start.") },
         { TypeBoolean, N_("Import as all selectable"), &gd_import_as_all_caves_selectable, false, NULL, N_("Original, C64 games are imported not with A, E, I, M caves selectable, but all caves (ABCD, EFGH... excluding intermissions). This does not affect BDCFF caves.") },
         { TypeBoolean, N_("Use BDCFF highscore"), &gd_use_bdcff_highscore, false, NULL, N_("Use BDCFF highscores. GDash saves highscores in its own configuration directory and also in the *.bd files. However, it prefers loading them from the configuration directory; as the *.bd files might be read-only. You can enable this setting to let GDash load them from the *.bd files.") },
+        { TypeBoolean, N_("Cache loaded cavesets"), &gd_caveset_cache, false, NULL, N_("Save the loaded cavesets in a binary format to the configuration directory, so they are loaded faster the next time. The caveset files are always checked for changes, and loaded again if they are modified.") },
         { TypeBoolean, N_("Show story"), &gd_show_story, false, NULL, N_("If the cave has a story, it will be shown when the cave is first started.") },
         { TypeBoolean, N_("Game name at uncover"), &gd_show_name_of_game, false, NULL, N_("Show the name of the game when uncovering a cave.") },
         { TypeBoolean, N_("No invisible outbox"), &gd_no_invisible_outbox, false, NULL, N_("Show invisible outboxes as visible (blinking) ones.") },
@@ -244,6 +249,9 @@ Setting *gd_get_game_settings_array() {
         { TypeStringv, N_("  Scaling type"), &gd_cell_scale_type_game, true, gd_scaling_names, N_("Software scaling method used. This setting is only effective for the GTK+ and the SDL engines. If you use the OpenGL engine, you can configure its scaling method by selecting a shader.") },
         { TypeBoolean, N_("  Software PAL emu"), &gd_pal_emulation_game, true, NULL, N_("Use PAL emulated graphics, i.e. lines are striped, and colors are distorted like on a TV. Only effective for the GTK+ and the SDL engines.") },
         { TypePercent, N_("  PAL scanline shade"), &gd_pal_emu_scanline_shade, true, NULL, N_("Darker rows for PAL emulation. Only effective for the GTK+ and the SDL engines.") },
+        { TypeBoolean, N_("  Pre-scale cells"), &gd_prescale_cells, false, NULL, N_("Scale all cells of the cave on other processor cores while the cave is uncovered, so the game does not stutter when a new element is first shown.") },
+        { TypeBoolean, N_("  Stream title animation"), &gd_stream_title_animation, false, NULL, N_("Scale the frames of the title screen animation one by one as they are shown, instead of all of them when the title screen is opened. This saves memory and makes the title screen appear faster with big scaling factors.") },
+        { TypeBoolean, N_("  Cache scaled cells"), &gd_cell_sheet_cache_on_disk, false, NULL, N_("Save the scaled and colored cells of the theme to the configuration directory, so they do not have to be scaled again the next time the same cave colors are used.") },
         { TypeBoolean, N_("Fine scrolling"), &gd_fine_scroll, true, NULL, N_("If fine scrolling is turned off, scrolling and cave animation is limited to a lower frame rate, and consumes much less CPU. On some hardware, it might actually look better than fine scrolling. Not all graphics engines support fine scrolling.") },
         { TypeBoolean, N_("Particle effects"), &gd_particle_effects, true, NULL, N_("Particle effects during play. This requires a lot of CPU power.") },
 
@@ -397,6 +405,7 @@ void gd_settings_init() {
     settings_bools["all_caves_selectable"] = &gd_all_caves_selectable;
     settings_bools["import_as_all_caves_selectable"] = &gd_import_as_all_caves_selectable;
     settings_bools["use_bdcff_highscore"] = &gd_use_bdcff_highscore;
+    settings_bools["caveset_cache"] = &gd_caveset_cache;
     settings_bools["fine_scroll"] = &gd_fine_scroll;
     settings_bools["particle_effects"] = &gd_particle_effects;
     settings_bools["show_story"] = &gd_show_story;
@@ -416,6 +425,9 @@ void gd_settings_init() {
     settings_bools["show_preview"] = &gd_show_preview;
     settings_bools["pal_emulation_game"] = &gd_pal_emulation_game;
     settings_bools["pal_emulation_editor"] = &gd_pal_emulation_editor;
+    settings_bools["cell_sheet_cache_on_disk"] = &gd_cell_sheet_cache_on_disk;
+    settings_bools["prescale_cells"] = &gd_prescale_cells;
+    settings_bools["stream_title_animation"] = &gd_stream_title_animation;
     settings_bools["fast_uncover_in_test"] = &gd_fast_uncover_in_test;
     settings_integers["editor_window_width"] = &gd_editor_window_width;
     settings_integers["editor_window_height"] = &gd_editor_window_height;
@@ -39,6 +39,7 @@ extern bool gd_no_invisible_outbox;
 extern bool gd_all_caves_selectable;
 extern bool gd_import_as_all_caves_selectable;
 extern bool gd_use_bdcff_highscore;
+extern bool gd_caveset_cache;
 extern int gd_pal_emu_scanline_shade;
 extern bool gd_fine_scroll;
 extern bool gd_particle_effects;
@@ -75,6 +76,9 @@ extern bool gd_pal_emulation_game;
 extern int gd_cell_scale_factor_editor;
 extern int gd_cell_scale_type_editor;
 extern bool gd_pal_emulation_editor;
+extern bool gd_cell_sheet_cache_on_disk;
+extern bool gd_prescale_cells;
+extern bool gd_stream_title_animation;
 
 /* keyboard */
 #ifdef HAVE_GTK
@@ -29,6 +29,8 @@
 
 #include <glib.h>
 #include <cmath>
+#include <vector>
+#include <algorithm>
 #include "settings.hpp"
 #include "cave/helper/cavesound.hpp"
 #include "cave/caverendered.hpp"
@@ -72,6 +74,22 @@ static GdSound snd_playing[5];
 static Mix_Music *music = NULL;
 
 static int music_volume = MIX_MAX_VOLUME;
+
+/* for offline mixing, the sounds are not played by sdl_mixer, but mixed
+ * by gd_sound_mix_offline(), with the same volumes, panning and fading. */
+struct OfflineChannel {
+    Mix_Chunk *chunk;       ///< The sound playing, or NULL
+    Uint32 pos;             ///< Byte position in the chunk
+    bool looped;
+    int volume;             ///< 0..MIX_MAX_VOLUME
+    int left, right;        ///< Panning, 0..255
+    int distance;           ///< 0..255, 0 is the loudest
+    int fade_length;        ///< Length of fading out, in sample frames; 0 if not fading
+    int fade_left;          ///< Sample frames left until the end of fading
+};
+static bool offline_mixing = false;
+static int offline_frequency;
+static OfflineChannel offline_channels[G_N_ELEMENTS(snd_playing)];
 #endif
 
 #ifdef HAVE_SDL
@@ -145,6 +163,14 @@ static void channel_done(int channel) {
 
 #ifdef HAVE_SDL
 static void halt_channel(int channel) {
+    if (offline_mixing) {
+        OfflineChannel &ch = offline_channels[channel];
+        if (ch.chunk != NULL && ch.fade_length == 0) {
+            ch.fade_length = offline_frequency * 40 / 1000;
+            ch.fade_left = ch.fade_length;
+        }
+        return;
+    }
     Mix_FadeOutChannel(channel, 40);
 }
 #endif
@@ -154,6 +180,12 @@ static void set_channel_panning(int channel, int dx, int dy) {
     if (gd_sound_stereo) {
         int left = gd_clamp(128 - dx * 2, 0, 255);
         int distance = gd_clamp(sqrt(dx * dx + dy * dy) * 2, 0, 255);
+        if (offline_mixing) {
+            offline_channels[channel].left = left;
+            offline_channels[channel].right = 255 - left;
+            offline_channels[channel].distance = distance;
+            return;
+        }
         Mix_SetPanning(channel, left, 255 - left);
         Mix_SetDistance(channel, distance);
     }
@@ -191,8 +223,17 @@ static void play_sound(int channel, SoundWithPos sound) {
     g_assert(!gd_sound_is_fake(sound.sound));
 
     /* now play it. */
-    Mix_PlayChannel(channel, sounds[sound.sound], gd_sound_is_looped(sound.sound) ? -1 : 0);
-    Mix_Volume(channel, MIX_MAX_VOLUME * gd_sound_chunks_volume_percent / 100);
+    if (offline_mixing) {
+        OfflineChannel &ch = offline_channels[channel];
+        ch.chunk = sounds[sound.sound];
+        ch.pos = 0;
+        ch.looped = gd_sound_is_looped(sound.sound);
+        ch.volume = MIX_MAX_VOLUME * gd_sound_chunks_volume_percent / 100;
+        ch.fade_length = 0;
+    } else {
+        Mix_PlayChannel(channel, sounds[sound.sound], gd_sound_is_looped(sound.sound) ? -1 : 0);
+        Mix_Volume(channel, MIX_MAX_VOLUME * gd_sound_chunks_volume_percent / 100);
+    }
     set_channel_panning(channel, sound.dx, sound.dy);
     snd_playing[channel] = sound.sound;
 }
@@ -248,6 +289,80 @@ void gd_sound_close() {
         }
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
     mixer_started = false;
+    offline_mixing = false;
+#endif
+}
+
+
+gboolean gd_sound_init_offline() {
+#ifdef HAVE_SDL
+    /* the mixer is opened only to have the sounds loaded and converted
+     * to its format; it is paused, so its callback never runs. */
+    if (!gd_sound_init() || !mixer_started)
+        return FALSE;
+
+    int channels;
+    Uint16 format;
+    Mix_QuerySpec(&offline_frequency, &format, &channels);
+    if (format != AUDIO_S16LSB || channels != 2) {
+        gd_message("Offline mixing needs 16-bit stereo sound.");
+        gd_sound_close();
+        return FALSE;
+    }
+    SDL_PauseAudio(1);
+
+    for (unsigned i = 0; i < G_N_ELEMENTS(offline_channels); i++) {
+        OfflineChannel &ch = offline_channels[i];
+        ch.chunk = NULL;
+        ch.left = ch.right = 255;
+        ch.distance = 0;
+    }
+    offline_mixing = true;
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+
+void gd_sound_mix_offline(gint16 *stream, unsigned frames) {
+#ifdef HAVE_SDL
+    if (!offline_mixing) {
+        std::fill(stream, stream + frames * 2, 0);
+        return;
+    }
+
+    std::vector<int> mix(frames * 2, 0);
+    for (unsigned c = 0; c < G_N_ELEMENTS(offline_channels); c++) {
+        OfflineChannel &ch = offline_channels[c];
+        if (ch.chunk == NULL)
+            continue;
+        /* the same gains as Mix_Volume, Mix_SetPanning and Mix_SetDistance */
+        double gain = ch.volume / double(MIX_MAX_VOLUME) * (255 - ch.distance) / 255.0;
+        double gain_left = gain * ch.left / 255.0, gain_right = gain * ch.right / 255.0;
+        for (unsigned i = 0; i < frames && ch.chunk != NULL; i++) {
+            gint16 const *sample = reinterpret_cast<gint16 const *>(ch.chunk->abuf + ch.pos);
+            double fade = ch.fade_length != 0 ? ch.fade_left / double(ch.fade_length) : 1.0;
+            mix[i * 2] += GINT16_FROM_LE(sample[0]) * gain_left * fade;
+            mix[i * 2 + 1] += GINT16_FROM_LE(sample[1]) * gain_right * fade;
+
+            ch.pos += 2 * sizeof(gint16);
+            if (ch.pos + 2 * sizeof(gint16) > ch.chunk->alen) {
+                if (ch.looped)
+                    ch.pos = 0;
+                else
+                    ch.chunk = NULL;
+            }
+            if (ch.fade_length != 0 && --ch.fade_left == 0)
+                ch.chunk = NULL;
+            if (ch.chunk == NULL)
+                channel_done(c);
+        }
+    }
+    for (unsigned i = 0; i < frames * 2; i++)
+        stream[i] = gd_clamp(mix[i], -32768, 32767);
+#else
+    std::fill(stream, stream + frames * 2, 0);
 #endif
 }
 
@@ -334,7 +449,7 @@ void gd_music_play_random() {
     static std::vector<char *> music_filenames;
     static bool music_dir_read = false;
 
-    if (!mixer_started || !gd_sound_enabled)
+    if (!mixer_started || !gd_sound_enabled || offline_mixing)
         return;
 
     /* if already playing, do nothing */
@@ -384,7 +499,7 @@ void gd_music_play_random() {
 
 void gd_music_stop() {
 #ifdef HAVE_SDL
-    if (!mixer_started)
+    if (!mixer_started || offline_mixing)
         return;
 
     if (Mix_PlayingMusic())
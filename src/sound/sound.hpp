@@ -30,6 +30,15 @@
 gboolean gd_sound_init(unsigned int bufsize = 44100 / 25);
 void gd_sound_close();
 
+/// Initialize sound for mixing offline: the sounds are not played, but mixed
+/// with gd_sound_mix_offline(), as fast as needed. Uses the sound settings,
+/// which must select 16-bit stereo mixing. Closed with gd_sound_close().
+gboolean gd_sound_init_offline();
+/// Mix the sounds playing to a buffer, for the given number of sample frames.
+/// The samples are 16-bit stereo, interleaved, at the frequency of the mixer.
+/// Without offline mixing, this gives silence.
+void gd_sound_mix_offline(gint16 *stream, unsigned frames);
+
 void gd_sound_off();
 void gd_sound_play_sounds(SoundWithPos const &sound1, SoundWithPos const &sound2, SoundWithPos const &sound3);
 void gd_sound_play_bonus_life();